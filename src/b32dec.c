@@ -66,14 +66,14 @@ int 	b32dec_output(char * base32, bool hexOutput, size_t * charsOnLine)
 	{
 		outSize = binaryToHexadecimal(binary, binarySize, hex, sizeof(hex));
 		out = hex;
-		out = wrapOutput(stdout, charsOnLine, &outSize, out);
+		out = wrapOutput(outputStdout(), charsOnLine, &outSize, out);
 	}
 	else
 	{
 		outSize = binarySize;
 		out = binary;
 	}
-	if (fwrite(out, outSize, 1, stdout) != 1)
+	if (isAnyError() || !outputSinkWrite(outputStdout(), out, outSize))
 	{
 		setError(WRITE_FAILED);
 		errorMessage(errorWriteFailed);
@@ -155,8 +155,8 @@ int 	b32enc_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 		{
 			char *		out = base32;
 
-			out = wrapOutput(stdout, &charsOnLine, &base32Size, base32);
-			if (fwrite(out, base32Size, 1, stdout) != 1)
+			out = wrapOutput(outputStdout(), &charsOnLine, &base32Size, base32);
+			if (isAnyError() || !outputSinkWrite(outputStdout(), out, base32Size))
 			{
 				setError(WRITE_FAILED);
 				errorMessage(errorWriteFailed);
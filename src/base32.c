@@ -73,6 +73,70 @@ size_t	base32ToBinary(char *base32, size_t base32Size, char *binary, size_t bina
 	return outOffset;
 }
 
+// convert Base32 data from a vector of memory spans to a binary buffer, groups of eight characters
+// crossing span borders are collected in a small buffer, all other data is converted in place
+
+size_t	base32ToBinaryVector(struct iovec *vector, int count, char *binary, size_t binarySize)
+{
+	char			group[8];
+	size_t			groupSize = 0;
+	size_t			b32Size = 0;
+	size_t			outOffset = 0;
+
+	for (int i = 0; i < count; i++)
+		b32Size += vector[i].iov_len;
+
+	if (b32Size % 8)
+		returnError(INV_B32_SIZE, 0);
+	if ((b32Size * 5 / 8) > binarySize)
+		returnError(BUF_TOO_SMALL, (b32Size * 5 / 8));
+	if (!binary)
+		return 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		char *		data = (char *) vector[i].iov_base;
+		size_t		size = vector[i].iov_len;
+
+		if (groupSize > 0) /* complete a group from the previous span */
+		{
+			size_t	missing = sizeof(group) - groupSize;
+
+			if (missing > size)
+				missing = size;
+
+			memcpy(group + groupSize, data, missing);
+			groupSize += missing;
+			data += missing;
+			size -= missing;
+
+			if (groupSize < sizeof(group))
+				continue;
+
+			if (!base32ToBinary(group, sizeof(group), binary + outOffset, binarySize - outOffset))
+				return 0;
+
+			outOffset += 5;
+			groupSize = 0;
+		}
+
+		size_t		aligned = size - (size % 8);
+
+		if (aligned > 0)
+		{
+			if (!base32ToBinary(data, aligned, binary + outOffset, binarySize - outOffset))
+				return 0;
+
+			outOffset += aligned * 5 / 8;
+		}
+
+		memcpy(group, data + aligned, size - aligned);
+		groupSize = size - aligned;
+	}
+
+	return outOffset;
+}
+
 // convert a binary buffer to a Base32 string
 
 size_t	binaryToBase32(char *binary, size_t binarySize, char *base32, size_t base32Size)
@@ -28,6 +28,7 @@
 // function prototypes
 
 size_t	base32ToBinary(char *base32, size_t base32Size, char *binary, size_t binarySize);
+size_t	base32ToBinaryVector(struct iovec *vector, int count, char *binary, size_t binarySize);
 size_t	binaryToBase32(char *binary, size_t binarySize, char *base32, size_t base32Size);
 
 #endif
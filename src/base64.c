@@ -45,7 +45,7 @@ size_t	base64ToBinary(char *base64, size_t base64Size, char *binary, size_t bina
 	{
 		char		*current = base64;
 
-		while (*current && (current < (base64 + b64Size)))
+		while ((current < (base64 + b64Size)) && *current)
 		{
 			if (isspace(*(current++))) /* only whitespace characters (0x20, 0x0A, 0x0D, 0x09, 0x0B, 0x0C) will be ignored here */
 				continue;
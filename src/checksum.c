@@ -36,6 +36,79 @@ static	char * *			commandNames = &__commandNames[0];
 static	commandEntry_t 		__checksum_command = { .names = &commandNames, .ep = &checksum_entry, .short_desc = &checksum_shortdesc, .usage = &checksum_usage, .finalNewlineOnTTY = true };
 EXPORTED commandEntry_t *	checksum_command = &__checksum_command;
 
+// replace the checksum of a single file, files without end marker are only skipped within directories
+
+static	bool	checksumInPlace(const char * fileName, bool fromDirectory)
+{
+	bool				changed = false;
+
+	if (repairExportFileChecksum(fileName, &changed))
+	{
+		if (changed)
+		{
+			verboseMessage(verboseChecksumReplaced, fileName);
+		}
+		return true;
+	}
+
+	if (isError(INVALID_FILE))
+	{
+		if (fromDirectory)
+		{
+			verboseMessage(verboseNoExportFileSkipped, fileName);
+			resetError();
+			return true;
+		}
+		errorMessage(errorNoExportFile, fileName);
+	}
+	else
+	{
+		errorMessage(errorChecksumNotReplaced, fileName);
+	}
+
+	return false;
+}
+
+// process all regular files from a directory
+
+static	bool	checksumInPlaceDirectory(const char * path)
+{
+	DIR *				dir = opendir(path);
+	struct dirent *		file;
+	bool				success = true;
+
+	if (!dir)
+	{
+		errorMessage(errorInvalidDirectoryName, path);
+		returnError(IO_ERROR, false);
+	}
+
+	while ((file = readdir(dir)))
+	{
+		char			fileName[PATH_MAX + 1];
+		struct stat		fileStat;
+
+		if (snprintf(fileName, sizeof(fileName), "%s/%s", path, file->d_name) >= (int) sizeof(fileName))
+			continue;
+
+		if (stat(fileName, &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+			continue;
+
+		if (!checksumInPlace(fileName, true))
+		{
+			success = false;
+			resetError();
+		}
+	}
+
+	closedir(dir);
+
+	if (!success)
+		setError(IO_ERROR);
+
+	return success;
+}
+
 // 'checksum' function - compute the CRC32 checksum for STDIN data
 
 int		checksum_entry(int argc, char** argv, int argo, commandEntry_t * entry)
@@ -45,6 +118,7 @@ int		checksum_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 	size_t				read = 0;
 	uint32_t			crcValue = 0;
 	bool				allData = false;
+	bool				inPlace = false;
 	enum {
 		OUTPUT_NONE,
 		OUTPUT_DECIMAL,
@@ -60,6 +134,7 @@ int		checksum_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 
 		static struct option options_long[] = {
 			{ "all-data", no_argument, NULL, 'd' },
+			{ "in-place", no_argument, NULL, 'i' },
 			{ "hex-output", no_argument, NULL, 'x' },
 			{ "raw-output", no_argument, NULL, 'r' },
 			{ "lsb-output", no_argument, NULL, 'l' },
@@ -67,7 +142,7 @@ int		checksum_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 			verbosity_options_long,
 			options_long_end,
 		};
-		char *			options_short = ":dxrlm" verbosity_options_short;
+		char *			options_short = ":dixrlm" verbosity_options_short;
 
 		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
 		{
@@ -77,6 +152,10 @@ int		checksum_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 					allData = true;
 					break;
 
+				case 'i':
+					inPlace = true;
+					break;
+
 				case 'x':
 					if (outputMode != OUTPUT_NONE)
 					{
@@ -131,10 +210,49 @@ int		checksum_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 				invalid_option(opt);
 			}
 		} 
-		if (optind < argc)
+		if (optind < argc && !inPlace)
 			warnAboutExtraArguments(argv, optind + 1);
 	}
 
+	if (inPlace) /* files from command line are changed, nothing is read from STDIN or written to STDOUT */
+	{
+		int				i = optind + argo;
+		bool			success = true;
+
+		entry->finalNewlineOnTTY = false;
+
+		if (isAnyError())
+			return EXIT_FAILURE;
+
+		if (allData || outputMode != OUTPUT_NONE)
+		{
+			errorMessage(errorConflictingOptions);
+			setError(OPTIONS_CONFLICT);
+			return EXIT_FAILURE;
+		}
+
+		if (i >= argc)
+		{
+			errorMessage(errorMissingArguments);
+			__autoUsage();
+			return EXIT_FAILURE;
+		}
+
+		for (; i < argc; i++)
+		{
+			struct stat	fileStat;
+
+			if (stat(argv[i], &fileStat) == 0 && S_ISDIR(fileStat.st_mode))
+				success = checksumInPlaceDirectory(argv[i]) && success;
+			else
+				success = checksumInPlace(argv[i], false) && success;
+
+			resetError();
+		}
+
+		return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
 	if (isatty(0))
 	{
 		errorMessage(errorNoReadFromTTY);
@@ -162,11 +280,11 @@ int		checksum_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 	}
 	else
 	{
-		memoryBuffer_t	*inputFile = memoryBufferReadFile(stdin, -1);
+		int				first = fgetc(stdin);
 
-		if (!inputFile)
+		if (first == EOF)
 		{
-			if (!isAnyError()) /* empty input file */
+			if (!ferror(stdin)) /* empty input file */
 			{
 				errorMessage(errorEmptyInputFile);
 			}
@@ -176,25 +294,12 @@ int		checksum_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 			}
 			return EXIT_FAILURE;
 		}
+		ungetc(first, stdin);
 
-		memoryBuffer_t	*consolidated = memoryBufferConsolidateData(inputFile);
-
-		if (!consolidated)
-		{
-			errorMessage(errorNoMemory);
-			inputFile = memoryBufferFreeChain(inputFile);
-			return EXIT_FAILURE;
-		}
-		else
-		{
-			inputFile = memoryBufferFreeChain(inputFile);
-			inputFile = consolidated;
-			verboseMessage(verboseInputDataConsolidated, memoryBufferDataSize(inputFile));
-		}
-
-		crcValue = computeExportFileChecksum(inputFile, (outputMode == OUTPUT_NONE ? stdout : NULL));
+		crcValue = computeExportFileChecksum(stdin, (outputMode == OUTPUT_NONE ? outputStdout() : NULL));
 
-		memoryBufferFreeChain(inputFile);
+		if (!outputClose())
+			errorMessage(errorWriteFailed);
 
 		if (outputMode == OUTPUT_NONE)
 			entry->finalNewlineOnTTY = false;
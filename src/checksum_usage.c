@@ -41,10 +41,15 @@ void 	checksum_usage(const bool help, UNUSED const bool version)
 	showFormatHeader(out);
 	addSpace();
 	addOption("options");
+	addSpace();
+	startOption();
+	addArgument("file(s)");
+	endOption();
 	showFormatEnd(out);
 
 	showOptionsHeader("options");
 	addOptionsEntry("-d, --all-data", "compute value over the 'raw' input file, don't handle the different parts of an export file", 0);
+	addOptionsEntry("-i, --in-place", "replace the checksum within the export files or directories specified on the command line", 0);
 	addOptionsEntry("-x, --hex-output", "show the computed value as hexadecimal string on STDOUT, otherwise it's written as decimal string", 0);
 	addOptionsEntry("-r, --raw-output", "write the 32 bits of the computed value as binary data to STDOUT (host order)", 0);
 	addOptionsEntry("-l, --lsb-output", "write the 32 bits of the computed value as binary data to STDOUT (LSB order)", 0);
@@ -70,7 +75,14 @@ void 	checksum_usage(const bool help, UNUSED const bool version)
 	fprintf(out,
 		"\nIf the '--all-data' option (or '-d') was specified, input data will not be handled as export file\n"
 		"and the CRC-32 value will be computed over the 'raw content'. Output format options are used to set\n"
-		"the format of data on STDOUT, input data will never be copied to STDOUT."
+		"the format of data on STDOUT, input data will never be copied to STDOUT.\n"
+	);
+
+	fprintf(out,
+		"\nWith the '--in-place' option (or '-i'), the names of export files have to be specified on the\n"
+		"command line instead of using STDIN. Each file is read once and only the digits of an invalid\n"
+		"checksum are replaced within the file. If a directory is specified, all regular files therein are\n"
+		"processed and any file without the end marker of an export file is skipped.\n"
 	);
 
 	showUsageFinalize(out, help, version);
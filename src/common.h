@@ -41,6 +41,14 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/fcntl.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/syscall.h>
+#include <linux/keyctl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <regex.h>
 
 #ifdef NETTLE
 
@@ -53,6 +61,7 @@
 #else
 
 #include <openssl/evp.h>
+#include <openssl/rand.h>
 
 #include "crypto_ossl.h"
 
@@ -65,6 +74,8 @@
 #include "base64.h"
 #include "hex.h"
 #include "crc32.h"
+#include "valuecache.h"
+#include "keycache.h"
 
 #include "functions.h"
 #include "memory.h"
@@ -76,6 +87,9 @@
 
 #include "encryption.h"
 #include "exportfile.h"
+#include "inflate.h"
+#include "tffsfile.h"
+#include "configfile.h"
 
 #include "b32dec.h"
 #include "b32enc.h"
@@ -88,10 +102,20 @@
 #include "pwfrdev.h"
 #include "decsngl.h"
 #include "decfile.h"
+#include "encsngl.h"
+#include "encfile.h"
 #include "decexp.h"
 #include "deccb.h"
 #include "pkpwd.h"
 #include "checksum.h"
 #include "decompose.h"
+#include "compose.h"
+#include "dectffs.h"
+#include "scansec.h"
+#include "qrycfg.h"
+#include "findsec.h"
+#include "diffexp.h"
+#include "patch.h"
+#include "rekey.h"
 
 #endif
@@ -0,0 +1,116 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+#define COMPOSE_C
+
+#include "common.h"
+#include "compose_usage.c"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+static	char *				__commandNames[] = {
+#include "compose_commands.c"
+		NULL
+};
+static	char * *			commandNames = &__commandNames[0];
+static	commandEntry_t 		__compose_command = { .names = &commandNames, .ep = &compose_entry, .short_desc = &compose_shortdesc, .usage = &compose_usage };
+EXPORTED commandEntry_t *	compose_command = &__compose_command;
+
+// 'compose' function - build an export file from single files
+
+int		compose_entry(int argc, char** argv, int argo, commandEntry_t * entry)
+{
+	char *				inputDir = NULL;
+	struct stat			fileStat;
+
+	if (argc > argo + 1)
+	{
+		int				opt;
+		int				optIndex = 0;
+
+		static struct option options_long[] = {
+			{ "input-directory", required_argument, NULL, 'i' },
+			verbosity_options_long,
+			options_long_end,
+		};
+		char *			options_short = ":" "i:" verbosity_options_short;
+
+		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
+		{
+			switch (opt)
+			{
+				case 'i':
+					{
+						if (!optarg)
+						{
+							errorMessage(errorMissingInputDirectoryName);
+							setError(OPTION_VALUE_MISSING);
+							return EXIT_FAILURE;
+						}
+						inputDir = optarg;
+					}
+					break;
+
+				check_verbosity_options_short();
+				help_option();
+				getopt_invalid_option();
+				invalid_option(opt);
+			}
+		} 
+		if (optind < argc)
+			warnAboutExtraArguments(argv, optind + 1);
+	}
+
+	if (!inputDir)
+	{
+		errorMessage(errorMissingInputDirectoryName);
+		setError(OPTION_VALUE_MISSING);
+		return EXIT_FAILURE;
+	}
+
+	if (stat(inputDir, &fileStat) != 0 || !S_ISDIR(fileStat.st_mode))
+	{
+		errorMessage(errorInvalidDirectoryName, inputDir);
+		setError(OPTION_VALUE_INVALID);
+	}
+
+	if (isAnyError())
+		return EXIT_FAILURE;
+
+	resetError();
+
+	composeExportFile(inputDir, outputStdout());
+
+	if (!outputClose())
+	{
+		errorMessage(errorWriteFailed);
+	}
+	else if (isError(NO_MEMORY))
+	{
+		errorMessage(errorNoMemory);
+	}
+
+	return (!isAnyError() ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+#pragma GCC diagnostic pop
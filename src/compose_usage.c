@@ -0,0 +1,68 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+// display usage help
+
+void 	compose_usage(const bool help, UNUSED const bool version)
+{
+	FILE *	out = (help || version ? stdout : stderr);
+
+	showUsageHeader(out, help, version);
+
+	if (version)
+	{
+		fprintf(out, "\n");
+		return;
+	}
+
+	showPurposeHeader(out);
+	fprintf(out,
+		"This program builds an export file from settings files, which were stored by 'split_export' before.\n"
+	);
+
+	showFormatHeader(out);
+	addSpace();
+	addOption("options");
+	showFormatEnd(out);
+
+	showOptionsHeader("options");
+	addOptionsEntry("-i, --input " __undl("directory"), "specifies the " __undl("directory") ", where the files are stored; this option is mandatory (and therefore not really an option)", 8);
+	addOptionsEntryVerbose();
+	addOptionsEntryQuiet();
+	addOptionsEntryStrict();
+	addOptionsEntryHelp();
+	addOptionsEntryVersion();
+	showOptionsEnd(out);
+
+	fprintf(out,
+		"\nThe input directory has to contain the files 'export_header' and 'export_dictionary', which are\n"
+		"created by 'split_export' with the '--dictionary' (or '-d') option. The contained files are read in\n"
+		"the order from dictionary, binary files are encoded again with the type stored in the dictionary.\n"
+		"\nThe new export file is written to STDOUT, its checksum is computed while the data is written.\n"
+	);
+
+	showUsageFinalize(out, help, version);
+}
+
+char *	compose_shortdesc(void)
+{
+	return "build an export file from single settings files";	
+}
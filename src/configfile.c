@@ -0,0 +1,611 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#define CONFIGFILE_C
+
+#include "common.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+// FRITZ!OS configuration file processing
+
+// tokenizer state - the input data isn't changed
+
+typedef struct {
+	char *				data;
+	char *				end;
+	char *				current;
+	size_t				line;
+} configScanner_t;
+
+// skip white space and comments
+
+static	void	configSkipSpace(configScanner_t * scanner)
+{
+	while (scanner->current < scanner->end)
+	{
+		char			c = *scanner->current;
+
+		if (c == '\n')
+			scanner->line++;
+
+		if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+			scanner->current++;
+		else if (c == '/' && scanner->current + 1 < scanner->end && *(scanner->current + 1) == '*')
+		{
+			char *		comment = scanner->current + 2;
+
+			while (comment + 1 < scanner->end && !(*comment == '*' && *(comment + 1) == '/'))
+			{
+				if (*comment == '\n')
+					scanner->line++;
+				comment++;
+			}
+
+			scanner->current = (comment + 1 < scanner->end ? comment + 2 : scanner->end);
+		}
+		else if (c == '/' && scanner->current + 1 < scanner->end && *(scanner->current + 1) == '/')
+		{
+			char *		newline = memchr(scanner->current, '\n', scanner->end - scanner->current);
+
+			scanner->current = (newline ? newline : scanner->end);
+		}
+		else
+			break;
+	}
+}
+
+// names end at white space or at any character with a special meaning
+
+static	size_t	configNameSize(configScanner_t * scanner)
+{
+	char *				name = scanner->current;
+
+	while (name < scanner->end && !strchr(" \t\r\n{}=;\"", *name))
+		name++;
+
+	return (name - scanner->current);
+}
+
+// the value ends at the first semicolon outside of quoted strings
+
+static	bool	configValueEnd(configScanner_t * scanner)
+{
+	bool				quoted = false;
+
+	while (scanner->current < scanner->end)
+	{
+		char			c = *scanner->current;
+
+		if (c == '\n')
+			scanner->line++;
+
+		if (quoted && c == '\\' && scanner->current + 1 < scanner->end)
+		{
+			if (*(scanner->current + 1) == '\n')
+				scanner->line++;
+			scanner->current += 2;
+			continue;
+		}
+
+		if (c == '"')
+			quoted = !quoted;
+		else if (c == ';' && !quoted)
+			return true;
+
+		scanner->current++;
+	}
+
+	return false;
+}
+
+// add a node to an index
+
+static	configNode_t *	configIndexAdd(configIndex_t * index, configNodeType_t type, char * name, size_t nameSize, size_t parent, size_t line)
+{
+	configNode_t *		node;
+
+	if (index->count == index->allocated)
+	{
+		configNode_t *	grown = (configNode_t *) realloc(index->nodes, (index->allocated ? index->allocated * 2 : 256) * sizeof(configNode_t));
+
+		if (!grown)
+			returnError(NO_MEMORY, NULL);
+
+		index->nodes = grown;
+		index->allocated = (index->allocated ? index->allocated * 2 : 256);
+	}
+
+	node = &index->nodes[index->count++];
+	node->type = type;
+	node->name = name;
+	node->nameSize = nameSize;
+	node->value = NULL;
+	node->valueSize = 0;
+	node->parent = parent;
+	node->instance = 0;
+	node->list = false;
+	node->line = line;
+
+	return node;
+}
+
+// build an index of all sections and values in a configuration file - the nodes are stored in the
+// order of their appearance and reference the input data, a syntax error is only shown on request
+
+EXPORTED	configIndex_t *	configIndexParse(char * data, size_t size, bool showErrors)
+{
+	configIndex_t *		index = (configIndex_t *) calloc(1, sizeof(configIndex_t));
+	configScanner_t		scanner = { .data = data, .end = data + size, .current = data, .line = 1 };
+	size_t				stack[CONFIG_MAX_DEPTH];
+	size_t				depth = 0;
+	size_t				closed = CONFIG_NO_PARENT;	/* section closed by the last token */
+
+	if (!index)
+		returnError(NO_MEMORY, NULL);
+
+	while (true)
+	{
+		size_t			nameSize;
+		char *			name;
+		size_t			line;
+		configNode_t *	node;
+
+		configSkipSpace(&scanner);
+
+		if (scanner.current == scanner.end)
+			break;
+
+		if (*scanner.current == '}')
+		{
+			if (depth == 0)
+				break;
+
+			closed = stack[--depth];
+			scanner.current++;
+			continue;
+		}
+
+		if (*scanner.current == '{' && closed != CONFIG_NO_PARENT && depth < CONFIG_MAX_DEPTH) /* next instance of a list */
+		{
+			configNode_t *	previous = &index->nodes[closed];
+
+			if (!(node = configIndexAdd(index, CONFIG_NODE_SECTION, previous->name, previous->nameSize, previous->parent, scanner.line)))
+				break;
+
+			previous = &index->nodes[closed]; /* nodes may have been moved */
+			previous->list = true;
+			node->list = true;
+			node->instance = previous->instance + 1;
+			stack[depth++] = index->count - 1;
+			closed = CONFIG_NO_PARENT;
+			scanner.current++;
+			continue;
+		}
+
+		closed = CONFIG_NO_PARENT;
+
+		if (*scanner.current == ';') /* empty statement */
+		{
+			scanner.current++;
+			continue;
+		}
+
+		if ((nameSize = configNameSize(&scanner)) == 0)
+			break;
+
+		name = scanner.current;
+		line = scanner.line;
+		scanner.current += nameSize;
+		configSkipSpace(&scanner);
+
+		if (scanner.current == scanner.end)
+			break;
+
+		if (*scanner.current == '{')
+		{
+			if (depth == CONFIG_MAX_DEPTH || !configIndexAdd(index, CONFIG_NODE_SECTION, name, nameSize, (depth ? stack[depth - 1] : CONFIG_NO_PARENT), line))
+				break;
+
+			stack[depth++] = index->count - 1;
+			scanner.current++;
+		}
+		else if (*scanner.current == '=')
+		{
+			char *		value;
+
+			scanner.current++;
+			configSkipSpace(&scanner);
+			value = scanner.current;
+
+			if (!configValueEnd(&scanner) || !(node = configIndexAdd(index, CONFIG_NODE_VALUE, name, nameSize, (depth ? stack[depth - 1] : CONFIG_NO_PARENT), line)))
+				break;
+
+			node->value = value;
+			node->valueSize = scanner.current - value;
+
+			while (node->valueSize > 0 && strchr(" \t\r\n", *(value + node->valueSize - 1)))
+				node->valueSize--;
+
+			scanner.current++;
+		}
+		else
+			break;
+	}
+
+	if (isAnyError())
+	{
+		index = configIndexFree(index);
+		return NULL;
+	}
+
+	if (scanner.current != scanner.end || depth > 0)
+	{
+		if (showErrors)
+		{
+			errorMessage(errorConfigSyntax, (unsigned long) scanner.line);
+		}
+		index = configIndexFree(index);
+		returnError(INVALID_FILE, NULL);
+	}
+
+	return index;
+}
+
+EXPORTED	configIndex_t *	configIndexFree(configIndex_t * index)
+{
+	if (index)
+	{
+		if (index->nodes)
+			free(index->nodes);
+		free(index);
+	}
+
+	return NULL;
+}
+
+// split a path into its elements, the names reference the copy of the text within the result
+
+EXPORTED	configPath_t *	configPathParse(char * text)
+{
+	configPath_t *		path = (configPath_t *) calloc(1, sizeof(configPath_t));
+	char *				current;
+
+	if (!path || !(path->text = strdup(text)))
+	{
+		if (path)
+			free(path);
+		returnError(NO_MEMORY, NULL);
+	}
+
+	current = path->text;
+
+	while (*current)
+	{
+		configPathElement_t *	element = &path->elements[path->count];
+		char *			end = current + strcspn(current, ".[");
+
+		if (path->count == CONFIG_MAX_DEPTH || end == current)
+			break;
+
+		element->name = (end - current == 1 && *current == '*' ? NULL : current);
+		element->nameSize = end - current;
+		element->instance = CONFIG_ANY_INSTANCE;
+		path->count++;
+		current = end;
+
+		if (*current == '[')
+		{
+			char *		number = ++current;
+
+			if (*current == '*')
+				current++;
+			else
+				element->instance = strtoul(number, &current, 10);
+
+			if (current == number || *current != ']')
+				break;
+
+			current++;
+		}
+
+		if (*current == '.' && *(current + 1))
+			current++;
+		else if (*current)
+			break;
+	}
+
+	if (*current || path->count == 0)
+	{
+		errorMessage(errorInvalidConfigPath, text);
+		path = configPathFree(path);
+		returnError(OPTION_VALUE_INVALID, NULL);
+	}
+
+	return path;
+}
+
+EXPORTED	configPath_t *	configPathFree(configPath_t * path)
+{
+	if (path)
+	{
+		if (path->text)
+			free(path->text);
+		free(path);
+	}
+
+	return NULL;
+}
+
+// check, if a node (or one of its parents) is selected by a path - a section selects all values within
+
+EXPORTED	bool	configPathMatches(configIndex_t * index, size_t node, configPath_t * path)
+{
+	size_t				chain[CONFIG_MAX_DEPTH + 1];
+	size_t				depth = 0;
+
+	for (size_t current = node; current != CONFIG_NO_PARENT && depth < sizeof(chain) / sizeof(chain[0]); current = index->nodes[current].parent)
+		chain[depth++] = current;
+
+	if (depth < path->count)
+		return false;
+
+	for (size_t i = 0; i < path->count; i++)
+	{
+		configNode_t *	current = &index->nodes[chain[depth - 1 - i]];
+		configPathElement_t *	element = &path->elements[i];
+
+		if (element->name && (element->nameSize != current->nameSize || memcmp(element->name, current->name, current->nameSize)))
+			return false;
+
+		if (element->instance != CONFIG_ANY_INSTANCE && element->instance != current->instance)
+			return false;
+	}
+
+	return true;
+}
+
+// write the complete path of a node, instance numbers are added for lists
+
+EXPORTED	bool	configWritePath(configIndex_t * index, size_t node, outputSink_t * out)
+{
+	configNode_t *		current = &index->nodes[node];
+	char				instance[24];
+
+	if (current->parent != CONFIG_NO_PARENT && (!configWritePath(index, current->parent, out) || !outputSinkWrite(out, ".", 1)))
+		return false;
+
+	if (!outputSinkWrite(out, current->name, current->nameSize))
+		return false;
+
+	if (current->list && !outputSinkWrite(out, instance, snprintf(instance, sizeof(instance), "[%lu]", (unsigned long) current->instance)))
+		return false;
+
+	return true;
+}
+
+// build the path of a node as string, the result is truncated to the size of the buffer and the
+// length of the complete path is returned
+
+EXPORTED	size_t	configPathString(configIndex_t * index, size_t node, char * buffer, size_t size)
+{
+	configNode_t *		current = &index->nodes[node];
+	size_t				used = 0;
+	int					added;
+
+	if (current->parent != CONFIG_NO_PARENT)
+	{
+		used = configPathString(index, current->parent, buffer, size);
+		used += snprintf(buffer + (used < size ? used : size), (used < size ? size - used : 0), ".");
+	}
+
+	if (current->list)
+		added = snprintf(buffer + (used < size ? used : size), (used < size ? size - used : 0), "%.*s[%lu]", (int) current->nameSize, current->name, (unsigned long) current->instance);
+	else
+		added = snprintf(buffer + (used < size ? used : size), (used < size ? size - used : 0), "%.*s", (int) current->nameSize, current->name);
+
+	return used + (added > 0 ? (size_t) added : 0);
+}
+
+// collect the text of a value element and decrypt the cipher-text therein - a quoted string is written
+// to the buffer without its quotation marks and escapes, if it's used for JSON output; cipher-text, which
+// can't be decrypted, is kept and counted
+
+static	bool	configDecodeElement(char * text, size_t size, bool unquote, CipherContext * ctx, char * key, char * *buffer, size_t * bufferSize, size_t * used, size_t * failed)
+{
+	char *				end = text + size;
+
+	*used = 0;
+
+	if (*bufferSize < size + 1) /* the clear-text is never larger than its cipher-text */
+	{
+		*buffer = clearMemory(*buffer, *bufferSize, true);
+		*bufferSize = 0;
+
+		if (!(*buffer = (char *) malloc(size + 1)))
+			returnError(NO_MEMORY, false);
+
+		*bufferSize = size + 1;
+	}
+
+	while (text < end)
+	{
+		if (unquote && *text == '\\' && text + 1 < end)
+		{
+			*(*buffer + (*used)++) = *(text + 1);
+			text += 2;
+			continue;
+		}
+
+		if (unquote && *text == '"')
+		{
+			text++;
+			continue;
+		}
+
+		if (*text == '$' && end - text > 4 && !memcmp(text, "$$$$", 4))
+		{
+			char *		cipherText = text + 4;
+			size_t		cipherTextSize = 0;
+			size_t		valueSize = *bufferSize - *used;
+			bool		isString = false;
+
+			while (cipherText + cipherTextSize < end && ((*(cipherText + cipherTextSize) >= 'A' && *(cipherText + cipherTextSize) <= 'Z') ||
+				   (*(cipherText + cipherTextSize) >= '1' && *(cipherText + cipherTextSize) <= '6')))
+				cipherTextSize++;
+
+			if (cipherTextSize)
+				memoryShowCipherText(cipherText, cipherTextSize);
+
+			if (cipherTextSize && decryptValueData(ctx, cipherText, cipherTextSize, key, *buffer + *used, &valueSize, &isString))
+			{
+				*(*buffer + *used + valueSize) = 0; /* it's overwritten by the following data */
+				showDecryptedValue(*buffer + *used, valueSize, isString);
+				*used += valueSize;
+				text = cipherText + cipherTextSize;
+				continue;
+			}
+
+			if (cipherTextSize)
+			{
+				resetError();
+				warningMessageNoApplet(verboseDecryptFailed);
+
+				if (failed)
+					(*failed)++;
+			}
+		}
+
+		*(*buffer + (*used)++) = *text++;
+	}
+
+	return true;
+}
+
+// write the value of a node with decrypted cipher-text - text output keeps the syntax of the file (the
+// clear-text is escaped within quoted strings), JSON output is a string or an array of strings; the number
+// of cipher-texts, which couldn't be decrypted, is added to 'failed' (if it's specified)
+
+EXPORTED	bool	configWriteValue(configNode_t * node, CipherContext * ctx, char * key, outputFormat_t format, outputSink_t * out, size_t * failed)
+{
+	char *				text = node->value;
+	char *				end = node->value + node->valueSize;
+	char *				buffer = NULL;
+	size_t				bufferSize = 0;
+	size_t				used = 0;
+	size_t				elements = 0;
+	bool				success = true;
+
+	if (format == OUTPUT_FORMAT_TEXT)
+	{
+		/* quoted strings are decrypted one by one, the clear-text needs escapes */
+
+		while (success && text < end)
+		{
+			char *		quote = memchr(text, '"', end - text);
+			char *		close;
+
+			if (!quote)
+			{
+				success = (configDecodeElement(text, end - text, false, ctx, key, &buffer, &bufferSize, &used, failed) && outputSinkWrite(out, buffer, used));
+				break;
+			}
+
+			for (close = quote + 1; close < end && *close != '"'; close++)
+			{
+				if (*close == '\\')
+					close++;
+			}
+
+			success = (configDecodeElement(text, quote + 1 - text, false, ctx, key, &buffer, &bufferSize, &used, failed) && outputSinkWrite(out, buffer, used) &&
+					   configDecodeElement(quote + 1, (close < end ? close : end) - (quote + 1), true, ctx, key, &buffer, &bufferSize, &used, failed) &&
+					   writeDecryptedValue(out, buffer, used, true) && (close == end || outputSinkWrite(out, "\"", 1)));
+			text = (close < end ? close + 1 : end);
+		}
+	}
+	else
+	{
+		/* list elements are separated by commas outside of quoted strings */
+
+		char *			element = text;
+		bool			quoted = false;
+		bool			list = false;
+
+		for (char * current = text; current < end; current++)
+		{
+			if (quoted && *current == '\\')
+				current++;
+			else if (*current == '"')
+				quoted = !quoted;
+			else if (*current == ',' && !quoted)
+			{
+				list = true;
+				break;
+			}
+		}
+
+		if (list)
+			success = outputSinkWrite(out, "[", 1);
+
+		quoted = false;
+
+		for (char * current = text; success && current <= end; current++)
+		{
+			if (current < end && quoted && *current == '\\')
+			{
+				current++;
+				continue;
+			}
+
+			if (current < end && *current == '"')
+				quoted = !quoted;
+
+			if (current < end && (*current != ',' || quoted))
+				continue;
+
+			while (element < current && strchr(" \t\r\n", *element))
+				element++;
+
+			size_t		elementSize = current - element;
+
+			while (elementSize > 0 && strchr(" \t\r\n", *(element + elementSize - 1)))
+				elementSize--;
+
+			success = ((!elements || outputSinkWrite(out, ",", 1)) &&
+					   configDecodeElement(element, elementSize, true, ctx, key, &buffer, &bufferSize, &used, failed) &&
+					   outputSinkWriteJson(out, buffer, used));
+			elements++;
+			element = current + 1;
+		}
+
+		if (success && list)
+			success = outputSinkWrite(out, "]", 1);
+	}
+
+	buffer = clearMemory(buffer, bufferSize, true);
+
+	return success;
+}
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#ifndef CONFIGFILE_H
+
+#define CONFIGFILE_H
+
+#include "common.h"
+
+// FRITZ!OS configuration files (ar7.cfg, voip.cfg, ...) - sections are written as 'name { ... }' and
+// a section followed directly by another block ('} {') is the next instance of a list, values are
+// assigned as 'name = value;', where the value may be a list of quoted strings
+
+#define	CONFIG_MAX_DEPTH			32
+#define	CONFIG_NO_PARENT			((size_t) -1)
+#define	CONFIG_ANY_INSTANCE			((size_t) -1)
+
+typedef enum {
+	CONFIG_NODE_SECTION,
+	CONFIG_NODE_VALUE
+} configNodeType_t;
+
+// a node references the name and the value in the input data, nothing is copied
+
+typedef struct configNode {
+	configNodeType_t	type;
+	char *				name;
+	size_t				nameSize;
+	char *				value;			/* text between the equal sign and the semicolon */
+	size_t				valueSize;
+	size_t				parent;
+	size_t				instance;		/* position within a list of sections */
+	bool				list;			/* the section has more than one instance */
+	size_t				line;
+} configNode_t;
+
+typedef struct configIndex {
+	configNode_t *		nodes;
+	size_t				count;
+	size_t				allocated;
+} configIndex_t;
+
+// a path is a list of names (or '*') with an optional instance number (or '*') in brackets
+
+typedef struct configPathElement {
+	char *				name;			/* NULL for any name */
+	size_t				nameSize;
+	size_t				instance;
+} configPathElement_t;
+
+typedef struct configPath {
+	char *				text;
+	configPathElement_t	elements[CONFIG_MAX_DEPTH];
+	size_t				count;
+} configPath_t;
+
+// function prototypes
+
+configIndex_t *		configIndexParse(char * data, size_t size, bool showErrors);
+configIndex_t *		configIndexFree(configIndex_t * index);
+configPath_t *		configPathParse(char * text);
+configPath_t *		configPathFree(configPath_t * path);
+bool				configPathMatches(configIndex_t * index, size_t node, configPath_t * path);
+bool				configWritePath(configIndex_t * index, size_t node, outputSink_t * out);
+size_t				configPathString(configIndex_t * index, size_t node, char * buffer, size_t size);
+bool				configWriteValue(configNode_t * node, CipherContext * ctx, char * key, outputFormat_t format, outputSink_t * out, size_t * failed);
+
+#endif
@@ -26,7 +26,10 @@
 EXPORTED	crcCtx_t *	crcInit(void)
 {
 	crcCtx_t			*ctx = malloc(sizeof(crcCtx_t));
-	
+
+	if (!ctx)
+		return NULL;
+
 	memset(ctx, 0, sizeof(crcCtx_t));
 	
 	for (uint32_t i = 0; i < (sizeof(ctx->table) / sizeof(uint32_t)); i++)
@@ -61,6 +64,8 @@ EXPORTED	void		crcUpdate(crcCtx_t * ctx, const char * input, const size_t size)
 		byte = *(input + i);
 		ctx->value = (ctx->value >> 8) ^ ctx->table[(ctx->value & 255) ^ byte];
 	}
+
+	ctx->size += size;
 }
 
 EXPORTED	uint32_t	crcFinal(crcCtx_t * ctx)
@@ -76,3 +81,69 @@ EXPORTED	uint32_t	crcFinal(crcCtx_t * ctx)
 
 	return value;
 }
+
+// multiply a vector with a 32x32 matrix over GF(2)
+
+static	uint32_t	crcMatrixTimes(const uint32_t * matrix, uint32_t vector)
+{
+	uint32_t			sum = 0;
+
+	while (vector)
+	{
+		if (vector & 1)
+			sum ^= *matrix;
+		vector >>= 1;
+		matrix++;
+	}
+
+	return sum;
+}
+
+static	void		crcMatrixSquare(uint32_t * square, const uint32_t * matrix)
+{
+	for (int i = 0; i < 32; i++)
+		square[i] = crcMatrixTimes(matrix, matrix[i]);
+}
+
+// compute the CRC value of concatenated data from the values of both parts and the size of the
+// second one, without touching the data again - it's the same algorithm as used by zlib
+
+EXPORTED	uint32_t	crcCombine(uint32_t crc1, uint32_t crc2, size_t size2)
+{
+	uint32_t			even[32];	/* operator for an even number of zero bits */
+	uint32_t			odd[32];	/* operator for an odd number of zero bits */
+	uint32_t			row = 1;
+
+	if (size2 == 0)
+		return crc1;
+
+	odd[0] = CRC_POLYNOM; /* operator for a single zero bit */
+	for (int i = 1; i < 32; i++)
+	{
+		odd[i] = row;
+		row <<= 1;
+	}
+
+	crcMatrixSquare(even, odd); /* two zero bits */
+	crcMatrixSquare(odd, even); /* four zero bits */
+
+	/* apply size2 zero bytes to crc1, the first square results in an operator for one zero byte */
+
+	do
+	{
+		crcMatrixSquare(even, odd);
+		if (size2 & 1)
+			crc1 = crcMatrixTimes(even, crc1);
+		size2 >>= 1;
+
+		if (size2 == 0)
+			break;
+
+		crcMatrixSquare(odd, even);
+		if (size2 & 1)
+			crc1 = crcMatrixTimes(odd, crc1);
+		size2 >>= 1;
+	} while (size2 != 0);
+
+	return crc1 ^ crc2;
+}
@@ -31,6 +31,7 @@
 
 typedef struct crcCtx {
 	uint32_t	value;
+	size_t		size;		/* number of bytes counted so far */
 	uint32_t	table[256];
 } crcCtx_t;
 
@@ -39,5 +40,6 @@ typedef struct crcCtx {
 crcCtx_t *		crcInit(void);
 void			crcUpdate(crcCtx_t * ctx, const char * input, const size_t size);
 uint32_t		crcFinal(crcCtx_t * ctx);
+uint32_t		crcCombine(uint32_t crc1, uint32_t crc2, size_t size2);
 
 #endif
@@ -150,6 +150,77 @@ EXPORTED	bool	CipherFinal(CipherContext * ctx, UNUSED char *output, UNUSED size_
 	return true;
 }
 
+// initialize a context for encryption - without a key, only a new IV is set and the expanded key
+// from the last call is used again
+
+EXPORTED	CipherContext *	CipherEncryptInit(CipherContext * ctx, CipherMode mode, char * key, char * iv)
+{
+	CipherContext	*cipherCTX = (ctx ? ctx : CipherContextNew());
+
+	if (!cipherCTX)
+		returnError(OSSL_CIPHER_ERR, NULL);
+
+	if (key)
+	{
+		aes256_set_encrypt_key(&(cipherCTX->cbc_context.ctx), (uint8_t *) key);
+		cipherCTX->cipher_mode = mode;
+	}
+
+	if (cipherCTX->cipher_mode == CipherTypeValue && iv)
+		CBC_SET_IV(&(cipherCTX->cbc_context), iv);
+
+	return cipherCTX;
+}
+
+// encrypt complete blocks
+
+EXPORTED	bool	CipherEncryptUpdate(CipherContext * ctx, char *output, size_t *outputSize, char *input, size_t inputSize)
+{
+	if (!ctx)
+		return false;
+
+	size_t				inSize = (inputSize - (inputSize % *cipher_blockSize));
+
+	if (ctx->cipher_mode == CipherTypeValue)
+		CBC_ENCRYPT(&(ctx->cbc_context), aes256_encrypt, inSize, (uint8_t *) output, (uint8_t *) input);
+	else
+		aes256_encrypt(&(ctx->cbc_context.ctx), inSize, (uint8_t *) output, (uint8_t *) input);
+
+	*outputSize = inSize;
+
+	return true;
+}
+
+// get random data for keys and IVs
+
+EXPORTED	bool	RandomBytes(char * buffer, size_t size)
+{
+	int				fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+	size_t			used = 0;
+
+	if (fd < 0)
+		returnError(OSSL_CIPHER_ERR, false);
+
+	while (used < size)
+	{
+		ssize_t		bytes = read(fd, buffer + used, size - used);
+
+		if (bytes <= 0)
+		{
+			if (bytes < 0 && errno == EINTR)
+				continue;
+			close(fd);
+			returnError(OSSL_CIPHER_ERR, false);
+		}
+
+		used += bytes;
+	}
+
+	close(fd);
+
+	return true;
+}
+
 // digest functions
 
 // get digest value length
@@ -126,6 +126,59 @@ EXPORTED	bool	CipherFinal(CipherContext * ctx, char *output, size_t *outputSize)
 	return true;
 }
 
+// initialize a context for encryption - without a key, only a new IV is set and the expanded key
+// from the last call is used again
+
+EXPORTED	CipherContext *	CipherEncryptInit(CipherContext * ctx, CipherMode mode, char * key, char * iv)
+{
+	CipherContext	*cipherCTX = (ctx ? ctx : CipherContextNew());
+
+	if (!cipherCTX)
+		returnError(OSSL_CIPHER_ERR, NULL);
+
+	if (!key)
+	{
+		if (EVP_EncryptInit_ex(cipherCTX, NULL, NULL, NULL, (unsigned char *) iv))
+			return cipherCTX;
+	}
+	else if (EVP_EncryptInit_ex(cipherCTX, (mode == CipherTypeValue ? EVP_aes_256_cbc() : EVP_aes_256_ecb()), NULL, (unsigned char *) key, (unsigned char *) iv))
+	{
+		EVP_CIPHER_CTX_set_padding(cipherCTX, false);
+		return cipherCTX;
+	}
+
+	if (!ctx)
+		CipherCleanup(cipherCTX);
+
+	returnError(OSSL_CIPHER_ERR, NULL);
+}
+
+// encrypt complete blocks
+
+EXPORTED	bool	CipherEncryptUpdate(CipherContext * ctx, char *output, size_t *outputSize, char *input, size_t inputSize)
+{
+	int				outSize = 0;
+
+	if (!ctx)
+		return false;
+	if (!EVP_EncryptUpdate(ctx, (unsigned char *) output, &outSize, (unsigned char *) input, inputSize))
+	{
+		setError(OSSL_CIPHER_ERR);
+		return false;
+	}
+	*outputSize = outSize;
+	return true;
+}
+
+// get random data for keys and IVs
+
+EXPORTED	bool	RandomBytes(char * buffer, size_t size)
+{
+	if (RAND_bytes((unsigned char *) buffer, size) != 1)
+		returnError(OSSL_CIPHER_ERR, false);
+	return true;
+}
+
 // digest functions
 
 // get digest value length
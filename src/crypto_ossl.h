@@ -54,6 +54,9 @@ CipherContext *	CipherInit(CipherContext * ctx, CipherMode mode, char * key, cha
 CipherContext *	CipherCleanup(CipherContext * ctx);
 bool			CipherUpdate(CipherContext * ctx, char *output, size_t *outputSize, char *input, size_t inputSize);
 bool			CipherFinal(CipherContext * ctx, char *output, size_t *outputSize);
+CipherContext *	CipherEncryptInit(CipherContext * ctx, CipherMode mode, char * key, char * iv);
+bool			CipherEncryptUpdate(CipherContext * ctx, char *output, size_t *outputSize, char *input, size_t inputSize);
+bool			RandomBytes(char * buffer, size_t size);
 
 void			DigestSizes(void);
 DigestContext *	DigestInit();
@@ -36,6 +36,70 @@ static	char * *			commandNames = &__commandNames[0];
 static	commandEntry_t 		__deccb_command = { .names = &commandNames, .ep = &deccb_entry, .usage = &deccb_usage, .short_desc = &deccb_shortdesc, .usesCrypto = true };
 EXPORTED commandEntry_t *	deccb_command = &__deccb_command;
 
+// check the trailer of a regular input file in advance, its last characters are read without changing
+// the file position - nothing is written on a wrong key then, data from a pipe can't be checked this way
+
+static	bool	deccbCheckTail(fileDecryptor_t * decryptor, bool binInput, bool b64Input)
+{
+	struct stat			fileStat;
+	char				tail[512];
+	char				text[sizeof(tail)];
+	char				binary[sizeof(tail)];
+	size_t				textSize = 0;
+	size_t				binSize = 0;
+	size_t				needed = 2 * decryptor->blockSize;
+	size_t				size;
+
+	if (fstat(fileno(stdin), &fileStat) || !S_ISREG(fileStat.st_mode) || fileStat.st_size <= 0)
+		return true;
+
+	size = ((size_t) fileStat.st_size > sizeof(tail) ? sizeof(tail) : (size_t) fileStat.st_size);
+
+	if (pread(fileno(stdin), tail, size, fileStat.st_size - size) != (ssize_t) size)
+		return true;
+
+	if (binInput)
+	{
+		memcpy(binary, tail, size);
+		binSize = size;
+	}
+	else
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			if (!isspace(tail[i]))
+				text[textSize++] = tail[i];
+		}
+
+		if (b64Input) /* the last complete groups, the padding characters are contained */
+		{
+			size_t		chars = ((needed + 2) / 3 + 1) * 4;
+
+			if (chars > textSize)
+				chars = textSize - (textSize % 4);
+
+			binSize = base64ToBinary(text + textSize - chars, chars, binary, sizeof(binary), false, false);
+		}
+		else
+		{
+			size_t		chars = (textSize > needed * 2 ? needed * 2 : textSize - (textSize % 2));
+
+			binSize = hexadecimalToBinary(text + textSize - chars, chars, binary, sizeof(binary));
+		}
+
+		if (isAnyError()) /* invalid data is reported later */
+		{
+			resetError();
+			return true;
+		}
+	}
+
+	if (binSize < needed) /* too short, this is detected later */
+		return true;
+
+	return fileDecryptorCheckTail(decryptor, binary + binSize - needed);
+}
+
 // 'decode_cryptedbinfile' function - decode the content of an encrypted binary file body from STDIN and copy the result to STDOUT
 
 int		deccb_entry(int argc, char** argv, int argo, commandEntry_t * entry)
@@ -64,10 +128,11 @@ int		deccb_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 			{ "bin-input", no_argument, NULL, 'b' },
 			width_options_long,
 			altenv_options_long,
+			keycache_options_long,
 			verbosity_options_long,
 			options_long_end,
 		};
-		char *			options_short = ":" "txnb" width_options_short altenv_options_short verbosity_options_short;
+		char *			options_short = ":" "txnb" width_options_short altenv_options_short keycache_options_short verbosity_options_short;
 
 		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
 		{
@@ -91,6 +156,7 @@ int		deccb_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 					break;
 
 				check_altenv_options_short();
+				check_keycache_options_short();
 				check_width_options_short();
 				check_verbosity_options_short();
 				help_option();
@@ -196,115 +262,105 @@ int		deccb_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 		return EXIT_FAILURE;
 	}
 
-	memoryBuffer_t	*inputFile = memoryBufferReadFile(stdin, -1);
-	
-	if (!inputFile)
+	/* input data is decoded and decrypted in chunks, only the last blocks are held back */
+
+	fileDecryptor_t *	decryptor = fileDecryptorNew(key, hexOutput);
+	char				input[FILE_DECRYPT_CHUNK_SIZE];
+	char				text[FILE_DECRYPT_CHUNK_SIZE + 4];	/* encoded characters without whitespace */
+	size_t				textSize = 0;
+	char				binary[FILE_DECRYPT_CHUNK_SIZE];
+	size_t				total = 0;
+	size_t				read;
+
+	clearMemory(key, *cipher_keyLen, false);
+
+	if (!decryptor)
 	{
-		if (!isAnyError()) /* empty input file */
-			return EXIT_SUCCESS;	
-		errorMessage(errorReadToMemory);
+		errorMessage(errorNoMemory);
 		return EXIT_FAILURE;
 	}
 
-	if (inputFile->next)
+	deccbCheckTail(decryptor, binInput, b64Input);
+
+	while (!isAnyError() && (read = fread(input, 1, sizeof(input), stdin)) > 0)
 	{
-		memoryBuffer_t	*consolidated = memoryBufferConsolidateData(inputFile);
-		if (!consolidated)
+		size_t			usable;
+		size_t			binSize;
+
+		total += read;
+
+		if (binInput)
 		{
-			errorMessage(errorNoMemory);
-			inputFile = memoryBufferFreeChain(inputFile);
-			return EXIT_FAILURE;
+			fileDecryptorUpdate(decryptor, input, read, outputStdout());
+			continue;
 		}
-		else
+
+		for (size_t i = 0; i < read; i++)
 		{
-			inputFile = memoryBufferFreeChain(inputFile);
-			inputFile = consolidated;
-			verboseMessage(verboseInputDataConsolidated, memoryBufferDataSize(inputFile));
+			if (!isspace(input[i]))
+				text[textSize++] = input[i];
 		}
-	}
 
-	size_t				inSize = memoryBufferDataSize(inputFile);
-	size_t				binSize = 0;
-	char *				binBuffer = NULL;
-	char *				buffer;
+		usable = textSize - (textSize % (b64Input ? 4 : 2));
 
-	if (binInput)
-	{
-		binSize = inSize;
-		buffer = inputFile->data;
-	}
-	else
-	{
 		if (b64Input)
-		{
-			binSize = base64ToBinary(inputFile->data, -1, NULL, 0, false, true);
-
-			if (isError(BUF_TOO_SMALL))
-			{
-				resetError();
+			binSize = base64ToBinary(text, usable, binary, sizeof(binary), false, false);
+		else
+			binSize = hexadecimalToBinary(text, usable, binary, sizeof(binary));
 
-				binBuffer = (char *) malloc(binSize);
+		if (!isAnyError())
+			fileDecryptorUpdate(decryptor, binary, binSize, outputStdout());
 
-				if (!binBuffer)
-				{
-					setError(NO_MEMORY);
-					errorMessage(errorNoMemory);
-					inputFile = memoryBufferFreeChain(inputFile);
-					return EXIT_FAILURE;
-				}
-
-				binSize = base64ToBinary(inputFile->data, -1, binBuffer, binSize, false, true);	
-				if (binSize == 0)
-				{
-					if (isError(INV_B64_DATA))
-					{
-						errorMessage(errorInvalidValue);
-					}
-					else if (isError(INV_B64_SIZE))
-					{
-						errorMessage(errorInvalidDataSize);
-					}
-					else
-					{
-						errorMessage(errorUnexpectedError, getError(), getErrorText(getError()));
-					}
-				}
-			}
+		textSize -= usable;
+		memmove(text, text + usable, textSize);
+	}
 
-			buffer = binBuffer;
-		}
+	if (!isAnyError() && ferror(stdin))
+	{
+		errorMessage(errorReadToMemory);
+		setError(IO_ERROR);
+	}
+	else if (!isAnyError() && textSize > 0) /* incomplete character group at the end */
+	{
+		if (b64Input)
+			setError(INV_B64_SIZE);
 		else
-		{
-			binBuffer = (char *) malloc(inSize / 2);
+			setError(INV_HEX_SIZE);
+	}
 
-			if (!binBuffer)
-			{
-				setError(NO_MEMORY);
-				errorMessage(errorNoMemory);
-				inputFile = memoryBufferFreeChain(inputFile);
-				return EXIT_FAILURE;
-			}
+	if (!isAnyError() && total > 0) /* empty input is no error */
+		fileDecryptorFinish(decryptor, outputStdout());
 
-			binSize = inSize / 2;
-			binSize = hexadecimalToBinary(inputFile->data, inputFile->used, binBuffer, binSize);
-			buffer = binBuffer;
-			if (binSize == 0)
-			{
-				errorMessage(errorInvalidHexValue);
-				setError(INV_HEX_DATA);
-			}
-		}
+	if (isError(DECRYPT_ERR))
+	{
+		errorMessage(errorDecryptFileData);
 	}
-
-	if (!isAnyError())
+	else if (isError(INV_B64_DATA))
+	{
+		errorMessage(errorInvalidValue);
+	}
+	else if (isError(INV_B64_SIZE))
+	{
+		errorMessage(errorInvalidDataSize);
+	}
+	else if (isError(INV_HEX_DATA))
 	{
-		decryptFile(buffer, binSize, stdout, NULL, key, hexOutput);
-		if (isError(DECRYPT_ERR))
-			errorMessage(errorDecryptFileData);
+		errorMessage(errorInvalidHexValue);
 	}
+	else if (isError(INV_HEX_SIZE))
+	{
+		errorMessage(errorInvalidHexSize);
+	}
+	else if (isError(NO_MEMORY))
+	{
+		errorMessage(errorNoMemory);
+	}
+
+	decryptor = fileDecryptorFree(decryptor);
+	clearMemory(binary, sizeof(binary), false);
 
-	binBuffer = clearMemory(binBuffer, binSize, true);
-	inputFile = memoryBufferFreeChain(inputFile);
+	if (!outputClose())
+		errorMessage(errorWriteFailed);
 
 	return (isAnyError() ? EXIT_FAILURE : EXIT_SUCCESS);
 }
@@ -62,6 +62,7 @@ void 	deccb_usage(const bool help, UNUSED const bool version)
 	addOptionsEntry("-x, --hex-output", "output data as a hexadecimal string", 0);
 	addOptionsEntry("-w, --wrap-lines [ " __undl("width") " ]", "enable line breaks (wrap lines) for textual output data and (opt.) define the maximum width of a line (instead of the default value " STRING(DECODER_CONFIG_WRAP_LINE_SIZE) ")", 8);
 	addOptionsEntry("-a, --alt-env " __undl("filename"), "use an alternative source for the 'urlader environment'", 8);
+	addOptionsEntry("-K, --key-cache " __undl("seconds"), "keep the device key in the kernel keyring for " __undl("seconds"), 8);
 	addOptionsEntryVerbose();
 	addOptionsEntryQuiet();
 	addOptionsEntryStrict();
@@ -95,9 +96,21 @@ void 	deccb_usage(const bool help, UNUSED const bool version)
 		showUndl("serial"), showUndl("maca"), showUndl("password")
 	);
 
+	fprintf(out,
+		"\nThe option '--key-cache' (or '-K') keeps the key, which was computed from the properties of the\n"
+		"device, for the specified number of %s (up to one week) in the session keyring of the kernel.\n"
+		"Further calls within this time find it there and only the checksum of the 'urlader environment' is\n"
+		"computed - the key is bound to this checksum and a changed environment leads to a new key. The key\n"
+		"is never written to a file and the option has no effect, if a %s or the %s and %s\n"
+		"values were specified.\n",
+		showUndl("seconds"), showUndl("password"), showUndl("serial"), showUndl("maca")
+	);
+
 	fprintf(out,
 		"\nIf the content can not be decrypted (decrypted raw data contain 16 bytes at the end, where we can\n"
-		"check a successful decryption), nothing is written to STDOUT. Without any further options, output\n"
+		"check a successful decryption), nothing is written to STDOUT. Data is decrypted while it's read - if\n"
+		"STDIN isn't a regular file (e.g. a pipe), these bytes can't be checked in advance and some data may\n"
+		"have been written already, when the check fails at the end. Without any further options, output\n"
 		"data will be written in 'raw' format - that means, the decrypted content will be written 'as is'.\n"
 		"This could be a problem with binary files and you may specify the '--hex-output' (or '-x') option\n"
 		"to output data with hexadecimal encoding. If you use this option, you can force lines with limited\n"
@@ -36,6 +36,55 @@ static	char * *			commandNames = &__commandNames[0];
 static	commandEntry_t 		__decexp_command = { .names = &commandNames, .ep = &decexp_entry, .usage = &decexp_usage, .short_desc = &decexp_shortdesc, .usesCrypto = true };
 EXPORTED commandEntry_t *	decexp_command = &__decexp_command;
 
+// write a record for each value from the text files of an export - the file names are only known, if
+// the data is contiguous and each file is handled on its own then
+
+static	bool	extractExportValues(memoryIndex_t * index, size_t position, char * key, outputSink_t * out)
+{
+	char *				data = (char *) index->segments[0].iov_base;
+	exportIndexEntry_t *	entries;
+	size_t				count = 0;
+	bool				success = true;
+	bool				failed = false;
+
+	if (index->count != 1)
+		return memoryBufferExtractValues(index, position, key, NULL, 0, 0, out, NULL);
+
+	if (!(entries = exportIndexSections(data + position, index->size - position, &count)))
+		return !isAnyError();
+
+	for (size_t i = 0; success && i < count; i++)
+	{
+		memoryIndex_t *	file;
+
+		if (entries[i].section != EXPORT_SECTION_CFGFILE)
+			continue;
+
+		if (!(file = memoryIndexFromData(entries[i].data, entries[i].size)))
+		{
+			setError(NO_MEMORY);
+			break;
+		}
+
+		success = memoryBufferExtractValues(file, 0, key, entries[i].name, entries[i].nameSize, entries[i].data - data, out, NULL);
+		file = memoryIndexFree(file);
+
+		if (!success && isError(DECRYPT_ERR)) /* values, which can't be decrypted, don't stop the other files */
+		{
+			resetError();
+			failed = true;
+			success = true;
+		}
+	}
+
+	free(entries);
+
+	if (failed && !isAnyError())
+		setError(DECRYPT_ERR);
+
+	return !isAnyError();
+}
+
 // 'decode_export' function - decode all secret values from the export file on STDIN and copy it with replaced values to STDOUT
 
 int		decexp_entry(int argc, char** argv, int argo, commandEntry_t * entry)
@@ -51,6 +100,7 @@ int		decexp_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 	bool				noConsolidate = false;
 	bool				newChecksum = false;
 	bool				decryptFiles = false;
+	outputFormat_t		format = OUTPUT_FORMAT_TEXT;
 	char *				passwordEntry = NULL;
 
 	if (argc > argo + 1)
@@ -64,11 +114,13 @@ int		decexp_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 			{ "decrypt", no_argument, NULL, 'd' },
 			{ "block-size", required_argument, NULL, 'b' },
 			{ "low-memory", no_argument, NULL, 'l' },
+			format_options_long,
 			altenv_options_long,
+			keycache_options_long,
 			verbosity_options_long,
 			options_long_end,
 		};
-		char *			options_short = ":" "tcdb:l" altenv_options_short verbosity_options_short;
+		char *			options_short = ":" "tcdb:l" format_options_short altenv_options_short keycache_options_short verbosity_options_short;
 
 		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
 		{
@@ -100,7 +152,9 @@ int		decexp_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 						noConsolidate = true;
 					break;
 
+				check_format_options_short();
 				check_altenv_options_short();
+				check_keycache_options_short();
 				check_verbosity_options_short();
 				help_option();
 				getopt_argument_missing();
@@ -147,6 +201,13 @@ int		decexp_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 	if (isAnyError())
 		return EXIT_FAILURE;
 
+	if (format == OUTPUT_FORMAT_NDJSON && newChecksum) /* there's no export file to sign */
+	{
+		errorMessage(errorConflictingOptions);
+		setError(OPTIONS_CONFLICT);
+		return EXIT_FAILURE;
+	}
+
 	resetError();
 
 	CipherSizes();
@@ -255,15 +316,7 @@ int		decexp_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 		}
 	}
 	else
-	{
-		if (newChecksum)
-		{
-			errorMessage(errorNoConsolidate);
-			setError(OPTIONS_CONFLICT);
-			return EXIT_FAILURE;
-		}
 		verboseMessage(verboseNoConsolidate);
-	}
 
 	if (!inputFile)
 	{
@@ -273,49 +326,45 @@ int		decexp_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 		return EXIT_FAILURE;
 	}
 
-	memoryBuffer_t *	current = inputFile;
-	memoryBuffer_t *	found = current;
-	size_t				offset = 0;
-	size_t				foundOffset = offset;
+	memoryIndex_t *		index = memoryIndexNew(inputFile);
+	size_t				found = 0;
 	size_t				valueSize = 0;
-	char *				varName;
-	bool				split = false;
 	char				exportKey[*cipher_keyLen];
+	memoryView_t *		output = NULL;
+	outputSink_t *		sink = NULL;
+	bool				valuesFailed = false;
 
-	if ((varName = memoryBufferFindString(&found, &foundOffset, passwordEntry, strlen(passwordEntry) , &split)) != NULL)
+	if (!index)
 	{
-		current = found;
-		offset = foundOffset;
+		errorMessage(errorNoMemory);
+		inputFile = memoryBufferFreeChain(inputFile);
+		return EXIT_FAILURE;
+	}
 
-		memoryBufferAdvancePointer(&current, &offset, strlen(passwordEntry));
-		found = current;
-		foundOffset = offset;
-		memoryBufferSearchValueEnd(&found, &foundOffset, &valueSize, &split);
+	if ((found = memoryIndexFindString(index, 0, passwordEntry, strlen(passwordEntry))) < index->size)
+	{
+		found += strlen(passwordEntry);
+		valueSize = memoryIndexValueSize(index, found);
 
 		if (valueSize != 104)
 		{
 			errorMessage(errorInvalidFirstStageLength, valueSize, passwordEntry);
 			setError(INV_DATA_SIZE);
+			index = memoryIndexFree(index);
 			inputFile = memoryBufferFreeChain(inputFile);
 			return EXIT_FAILURE;
 		}
 
-		char *			copy;
-		char *			cipherText = (char *) malloc(valueSize + 1);
+		struct iovec	cipherText[(104 / 32) + 2]; /* value crosses at most this number of segments (minimum block size is 32) */
+		int				count = memoryIndexGetVector(index, found, valueSize, cipherText, sizeof(cipherText) / sizeof(struct iovec));
 		bool			passwordIsCorrect = false;
-			
-		memset(cipherText, 0, valueSize + 1);
-		copy = cipherText;
-		while (current && (current != found))
-		{
-			memcpy(copy, current->data + offset, current->used - offset);
-			copy += (current->used - offset);
-			current = current->next;
-			offset = 0;
-		}
-		memcpy(copy, current->data + offset, foundOffset - offset);
-		passwordIsCorrect = decryptValue(NULL, cipherText, valueSize, NULL, exportKey, key, false);
+
+		if (count > (int) (sizeof(cipherText) / sizeof(struct iovec))) /* incomplete vector, decryption will fail */
+			count = sizeof(cipherText) / sizeof(struct iovec);
+
+		passwordIsCorrect = decryptValueVector(NULL, cipherText, count, NULL, exportKey, key, false);
 		memset(exportKey + *cipher_ivLen, 0, *cipher_keyLen - *cipher_ivLen);
+		found += valueSize;
 		if (passwordIsCorrect)
 		{
 			char 		hex[(MAX_DIGEST_SIZE * 2) + 1];
@@ -324,26 +373,16 @@ int		decexp_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 			hex[hexLen] = 0;
 			verboseMessage(verboseUsingKey, hex);
 
-			cipherText = clearMemory(cipherText, valueSize + 1, true);
-			current = inputFile;
-			offset = 0;
-			while (current && (current != found)) /* output data in front of password field */
-			{
-				if (!newChecksum && fwrite(current->data + offset, current->used - offset, 1, stdout) != 1)
-				{
-					setError(WRITE_FAILED);
-					break;
-				}
-				current = current->next;
-				offset = 0;
-			}
-			if (current)
-			{
-				if (!newChecksum && fwrite(current->data + offset, foundOffset - offset, 1, stdout) != 1)
-					setError(WRITE_FAILED);
-				else
-					offset = foundOffset;
-			}
+			if (newChecksum) /* the checksum is written after all data was processed, collect it in memory */
+				sink = ((output = memoryViewNew()) ? outputSinkForView(output) : NULL);
+			else
+				sink = outputStdout();
+
+			if (!sink)
+				errorMessage(errorNoMemory);
+
+			if (!isAnyError() && format == OUTPUT_FORMAT_TEXT) /* output data up to the end of password field */
+				memoryIndexWrite(index, 0, found, sink);
 		}
 		else
 		{
@@ -358,17 +397,35 @@ int		decexp_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 	}
 
 	if (!isAnyError())
-		memoryBufferProcessFile(&found, foundOffset, exportKey, (newChecksum ? NULL : stdout), (decryptFiles ? key : NULL));
+	{
+		if (format == OUTPUT_FORMAT_NDJSON) /* only the decrypted values are written, encrypted files are ignored */
+			extractExportValues(index, found, exportKey, sink);
+		else
+			memoryBufferProcessFile(index, found, exportKey, sink, (decryptFiles ? key : NULL), NULL);
+
+		if (isError(DECRYPT_ERR)) /* the data was written, a new checksum is computed for it anyway */
+		{
+			resetError();
+			valuesFailed = true;
+		}
+	}
 
 	clearMemory(exportKey, *cipher_keyLen, false);
 	clearMemory(key, *cipher_keyLen, false);
 
-	if (!isAnyError() && newChecksum)
-		computeExportFileChecksum(inputFile, stdout);
+	if (!isAnyError() && output)
+		computeExportViewChecksum(output, outputStdout());
+
+	if (!outputClose()) /* input buffers are referenced until the data was written */
+		errorMessage(errorWriteFailed);
 
+	if (output)
+		sink = outputSinkFree(sink);
+	output = memoryViewFree(output);
+	index = memoryIndexFree(index);
 	inputFile = memoryBufferFreeChain(inputFile);
 
-	return (isAnyError() ? EXIT_FAILURE : EXIT_SUCCESS);
+	return ((isAnyError() || valuesFailed) ? EXIT_FAILURE : EXIT_SUCCESS);
 }
 
 #pragma GCC diagnostic pop
@@ -65,7 +65,10 @@ void 	decexp_usage(const bool help, UNUSED const bool version)
 	showOptionsHeader("options");
 	addOptionsEntry("-t, --tty", "don't quit execution, if STDIN is connected to a terminal device", 0);
 	addOptionsEntry("-a, --alt-env " __undl("filename"), "use an alternative source for the 'urlader environment'", 8);
+	addOptionsEntry("-K, --key-cache " __undl("seconds"), "keep the device key in the kernel keyring for " __undl("seconds"), 8);
 	addOptionsEntry("-c, --checksum", "re-compute (and replace) the checksum for the provided export file, after the cipher-text values were replaced with the corresponding clear-text", 0);
+	addOptionsEntry("-d, --decrypt", "decrypt the content of encrypted files (CRYPTEDBINFILE and CRYPTEDB64FILE) too, they are written as BINFILE and B64FILE with the same encoding", 0);
+	addOptionsEntry("-f, --format " __undl("format"), "write the export file with clear-text values ('text', the default) or only the values as 'ndjson'", 8);
 	addOptionsEntry("-l, --low-memory", "do not try to consolidate input data into a single buffer", 0);
 	addOptionsEntry("-b, --block-size " __undl("size"), "read input data in blocks of the specified " __undl("size"), 8);
 	addOptionsEntryVerbose();
@@ -127,8 +130,17 @@ void 	decexp_usage(const bool help, UNUSED const bool version)
 
 	fprintf(out,
 		"\nIf you want to import the created output file into a FRITZ!OS device, the program can set a valid\n"
-		"checksum at the end of the file, if you've specified the option '--checksum' (or '-c'). This option\n"
-		"is mutually exclusive with the '--low-memory' option.\n"
+		"checksum at the end of the file, if you've specified the option '--checksum' (or '-c').\n"
+	);
+
+	fprintf(out,
+		"\nThe option '--key-cache' (or '-K') keeps the key, which was computed from the properties of the\n"
+		"device, for the specified number of %s (up to one week) in the session keyring of the kernel.\n"
+		"Further calls within this time find it there and only the checksum of the 'urlader environment' is\n"
+		"computed - the key is bound to this checksum and a changed environment leads to a new key. The key\n"
+		"is never written to a file and the option has no effect, if a %s or the %s and %s\n"
+		"values were specified.\n",
+		showUndl("seconds"), showUndl("password"), showUndl("serial"), showUndl("maca")
 	);
 
 	fprintf(out,
@@ -144,6 +156,17 @@ void 	decexp_usage(const bool help, UNUSED const bool version)
 		"buffer (as if the option '--low-memory' was used).\n"
 	);
 
+	fprintf(out,
+		"\nWith '--format=ndjson' (or '-f ndjson') the export file isn't copied - each decrypted value from its\n"
+		"text files is written as a JSON object on its own line with the members 'file' (the name of the file\n"
+		"within the export), 'section' (the path of the enclosing section like 'ddns.accounts[1]'), 'key'\n"
+		"(the name of the setting), 'offset' (of the cipher-text in the input data) and 'isString'. The\n"
+		"clear-text is stored as 'value' for strings and as hexadecimal string in 'hex' for binary data.\n"
+		"The file name and the section path are only known, if the input data was held in a single buffer,\n"
+		"they're null otherwise. Values, which can't be decrypted, are skipped and encrypted files are never\n"
+		"decrypted in this mode. The option can't be used together with '--checksum'.\n"
+	);
+
 	showUsageFinalize(out, help, version);
 }
 
@@ -40,17 +40,17 @@ EXPORTED commandEntry_t *	decfile_command = &__decfile_command;
 
 int		decfile_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 {
-	char 				hash[MAX_DIGEST_SIZE];
-	size_t				hashLen = sizeof(hash);
 	char *				serial = NULL;
 	char *				maca = NULL;
 	char *				wlanKey = NULL;
 	char *				tr069Passphrase = NULL;
 	bool				altEnv = false;
 	bool				tty = false;
-	size_t				hexLen = 0;
-	char *				hexBuffer = NULL;
 	bool				noConsolidate = false;
+	char *				cachePath = NULL;
+	valueCache_t *		cache = NULL;
+	char *				keyFilter = NULL;
+	outputFormat_t		format = OUTPUT_FORMAT_TEXT;
 
 	if (argc > argo + 1)
 	{
@@ -61,11 +61,16 @@ int		decfile_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 			{ "tty", no_argument, NULL, 't' },
 			{ "block-size", required_argument, NULL, 'b' },
 			{ "low-memory", no_argument, NULL, 'l' },
+			{ "value-cache", required_argument, NULL, 'c' },
+			{ "only-keys", required_argument, NULL, 'o' },
+			{ "exclude-keys", required_argument, NULL, 'x' },
+			format_options_long,
 			altenv_options_long,
+			keycache_options_long,
 			verbosity_options_long,
 			options_long_end,
 		};
-		char *			options_short = ":" "tb:l" altenv_options_short verbosity_options_short;
+		char *			options_short = ":" "tb:lc:o:x:" format_options_short altenv_options_short keycache_options_short verbosity_options_short;
 
 		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
 		{
@@ -79,6 +84,28 @@ int		decfile_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 					noConsolidate = true;
 					break;
 
+				case 'c':
+					cachePath = optarg;
+					break;
+
+				case 'o':
+				case 'x':
+					if (keyFilter)
+					{
+						errorMessage(errorConflictingOptions);
+						setError(OPTIONS_CONFLICT);
+						return EXIT_FAILURE;
+					}
+					if (!memoryValueFilterSet(optarg, (opt == 'x')))
+					{
+						errorMessage(errorInvalidKeyNames, optarg);
+						if (!isAnyError())
+							setError(OPTION_VALUE_INVALID);
+						return EXIT_FAILURE;
+					}
+					keyFilter = optarg;
+					break;
+
 				case 'b':
 					if (!setInputBufferSize(optarg, argv[optind]))
 					{
@@ -89,7 +116,9 @@ int		decfile_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 						noConsolidate = true;
 					break;
 
+				check_format_options_short();
 				check_altenv_options_short();
+				check_keycache_options_short();
 				check_verbosity_options_short();
 				help_option();
 				getopt_argument_missing();
@@ -144,134 +173,96 @@ int		decfile_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 
 	char				key[*cipher_keyLen];
 
-	memset(key, 0, *cipher_keyLen);
+	if (!keyFromArguments(key, serial, maca, wlanKey, tr069Passphrase, altEnv))
+		return EXIT_FAILURE;
 
-	if (!serial) /* use device properties from running system */
+	if (isatty(0) && !tty)
 	{
-		altenv_verbose_message();
-
-		if (!keyFromDevice(hash, &hashLen, false))
-			return EXIT_FAILURE; /* error message was displayed from called function */
+		errorMessage(errorReadFromTTY);
+		return EXIT_FAILURE;
+	}
 
-		memcpy(key, hash, *cipher_ivLen);
-		hexBuffer = malloc((hashLen * 2) + 1);
+	memoryBuffer_t		*inputFile = NULL;
+	memoryIndex_t		*index = NULL;
+	size_t				mappedSize = 0;
+	char *				mapped = memoryMapFile(stdin, &mappedSize);
 
-		if (hexBuffer)
-		{
-			hexLen = binaryToHexadecimal((char *) hash, hashLen, hexBuffer, (hashLen * 2) + 1);
-			*(hexBuffer + hexLen) = 0;
-			verboseMessage(verboseDeviceKeyHash, hexBuffer);
-			free(hexBuffer);
-		}
+	if (mapped) /* unchanged data may be passed through to the output without copying it to user space */
+	{
+		verboseMessage(verboseInputFileMapped, mappedSize);
+		index = memoryIndexFromData(mapped, mappedSize);
+		if (outputStdout())
+			outputSinkSetSource(outputStdout(), fileno(stdin), mapped, mappedSize);
 	}
-	else if (!maca) /* single argument - assume it's a hexadecimal key already */
+	else
 	{
-		if (altEnv)
-		{
-			warningMessage(verboseAltEnvIgnored);
-			failOnStrict();
-		}
-
-		if (strlen(serial) != 32)
-		{
-			errorMessage(errorWrongHexKeyLength, serial);
-			return EXIT_FAILURE;
-		}
-
-		hexadecimalToBinary(serial, strlen(serial), key, *cipher_keyLen);
+		inputFile = memoryBufferReadFile(stdin, -1);
 
-		if (isAnyError())
+		if (!noConsolidate)
 		{
-			errorMessage(errorInvalidKeyValue, serial);
-			return EXIT_FAILURE;
-		}
+			memoryBuffer_t	*consolidated = memoryBufferConsolidateData(inputFile);
 
-		verboseMessage(verboseUsingKey, serial);
-	}
-	else if (!wlanKey) /* serial and maca - use an export key from device */
-	{
-		if (altEnv)
-		{
-			warningMessage(verboseAltEnvIgnored);
-			failOnStrict();
+			if (!consolidated)
+			{
+				errorMessage(errorNoMemory);
+				inputFile = memoryBufferFreeChain(inputFile);
+				return EXIT_FAILURE;
+			}
+			else
+			{
+				inputFile = memoryBufferFreeChain(inputFile);
+				inputFile = consolidated;
+				verboseMessage(verboseInputDataConsolidated, memoryBufferDataSize(inputFile));
+			}
 		}
-
-		errorMessage(errorDeviceProperties, URLADER_SERIAL_NAME, URLADER_MACA_NAME, URLADER_WLANKEY_NAME);
-
-		return EXIT_FAILURE;
-	}
-	else
-	{
-		if (altEnv)
+		else
 		{
-			warningMessage(verboseAltEnvIgnored);
-			failOnStrict();
+			verboseMessage(verboseNoConsolidate);
 		}
-
-		verboseMessage(verboseSerialUsed, serial);
-		verboseMessage(verboseMACUsed, maca);
-		verboseMessage(verboseWLANKeyUsed, wlanKey);
-		if (tr069Passphrase)
-			verboseMessage(verboseTR069PPUsed, tr069Passphrase);
-
-		if (!keyFromProperties(hash, &hashLen, serial, maca, wlanKey, tr069Passphrase))
+	
+		if (!inputFile)
 		{
+			if (!isAnyError()) /* empty input file */
+				return EXIT_SUCCESS;	
+			errorMessage(errorReadToMemory);
 			return EXIT_FAILURE;
 		}
 
-		memcpy(key, hash, *cipher_ivLen);
-		hexBuffer = malloc((hashLen * 2) + 1);
-
-		if (hexBuffer)
-		{
-			hexLen = binaryToHexadecimal((char *) hash, hashLen, hexBuffer, (hashLen * 2) + 1);
-			*(hexBuffer + hexLen) = 0;
-			verboseMessage(verboseUsingKey, hexBuffer);
-			free(hexBuffer);
-		}
+		index = memoryIndexNew(inputFile);
 	}
 
-	if (isatty(0) && !tty)
+	if (!index)
 	{
-		errorMessage(errorReadFromTTY);
+		errorMessage(errorNoMemory);
+		inputFile = memoryBufferFreeChain(inputFile);
+		mapped = memoryUnmapFile(mapped, mappedSize);
 		return EXIT_FAILURE;
 	}
 
-	memoryBuffer_t		*inputFile = memoryBufferReadFile(stdin, -1);
-
-	if (!noConsolidate)
+	if (cachePath && !(cache = valueCacheOpen(cachePath, key)))
 	{
-		memoryBuffer_t	*consolidated = memoryBufferConsolidateData(inputFile);
-
-		if (!consolidated)
-		{
-			errorMessage(errorNoMemory);
-			inputFile = memoryBufferFreeChain(inputFile);
-			return EXIT_FAILURE;
-		}
-		else
-		{
-			inputFile = memoryBufferFreeChain(inputFile);
-			inputFile = consolidated;
-			verboseMessage(verboseInputDataConsolidated, memoryBufferDataSize(inputFile));
-		}
+		warningMessage(verboseValueCacheNotUsed, cachePath);
+		resetError();
 	}
+
+	if (format == OUTPUT_FORMAT_NDJSON) /* only the decrypted values are written */
+		memoryBufferExtractValues(index, 0, key, NULL, 0, 0, outputStdout(), cache);
 	else
+		memoryBufferProcessFile(index, 0, key, outputStdout(), NULL, cache);
+
+	if (cache)
 	{
-		verboseMessage(verboseNoConsolidate);
-	}
-	
-	if (!inputFile)
-	{
-		if (!isAnyError()) /* empty input file */
-			return EXIT_SUCCESS;	
-		errorMessage(errorReadToMemory);
-		return EXIT_FAILURE;
+		verboseMessage(verboseValueCacheStatistics, cache->hits, cache->misses, cache->stored);
+		cache = valueCacheClose(cache);
 	}
 
-	memoryBufferProcessFile(&inputFile, 0, key, stdout, NULL);
+	clearMemory(key, *cipher_keyLen, false);
+	if (!outputClose()) /* input buffers are referenced until the data was written */
+		errorMessage(errorWriteFailed);
 
+	index = memoryIndexFree(index);
 	inputFile = memoryBufferFreeChain(inputFile);
+	mapped = memoryUnmapFile(mapped, mappedSize);
 
 	return (isAnyError() ? EXIT_FAILURE : EXIT_SUCCESS);
 }
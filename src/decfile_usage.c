@@ -65,8 +65,13 @@ void 	decfile_usage(const bool help, UNUSED const bool version)
 	showOptionsHeader("options");
 	addOptionsEntry("-t, --tty", "don't quit execution, if STDIN is connected to a terminal device", 0);
 	addOptionsEntry("-a, --alt-env " __undl("filename"), "use an alternative source for the 'urlader environment'", 8);
+	addOptionsEntry("-K, --key-cache " __undl("seconds"), "keep the device key in the kernel keyring for " __undl("seconds"), 8);
 	addOptionsEntry("-l, --low-memory", "do not try to consolidate input data into a single buffer", 0);
 	addOptionsEntry("-b, --block-size " __undl("size"), "read input data in blocks of the specified " __undl("size"), 8);
+	addOptionsEntry("-c, --value-cache " __undl("directory"), "keep decrypted values in a cache file within " __undl("directory"), 8);
+	addOptionsEntry("-o, --only-keys " __undl("names"), "decrypt only values of the settings with the specified (comma-separated) " __undl("names"), 8);
+	addOptionsEntry("-x, --exclude-keys " __undl("names"), "don't decrypt values of the settings with the specified (comma-separated) " __undl("names"), 8);
+	addOptionsEntry("-f, --format " __undl("format"), "write the input data with clear-text values ('text', the default) or only the values as 'ndjson'", 8);
 	addOptionsEntryVerbose();
 	addOptionsEntryQuiet();
 	addOptionsEntryStrict();
@@ -123,6 +128,15 @@ void 	decfile_usage(const bool help, UNUSED const bool version)
 		showUndl("input-file")
 	);
 
+	fprintf(out,
+		"\nThe option '--key-cache' (or '-K') keeps the key, which was computed from the properties of the\n"
+		"device, for the specified number of %s (up to one week) in the session keyring of the kernel.\n"
+		"Further calls within this time find it there and only the checksum of the 'urlader environment' is\n"
+		"computed - the key is bound to this checksum and a changed environment leads to a new key. The key\n"
+		"is never written to a file and the option has no effect, if any %s was specified.\n",
+		showUndl("seconds"), showUndl("parameter")
+	);
+
 	fprintf(out,
 		"\nThe option '--low-memory' (or '-l') may be used, if your system has not enough free memory to hold\n"
 		"the input data (from really huge files) twice in memory for a short time.\n"
@@ -136,6 +150,34 @@ void 	decfile_usage(const bool help, UNUSED const bool version)
 		"buffer (as if the option '--low-memory' was used).\n"
 	);
 
+	fprintf(out,
+		"\nThe option '--value-cache' (or '-c') keeps decrypted values in the file '%s' within\n"
+		"the specified %s - it's created with access rights for the owner only, if it doesn't exist.\n"
+		"The values are stored encrypted with a key, which is derived from the decryption key, and only the\n"
+		"entries for the same key can be found again. If the same cipher-text is processed again (e.g. while\n"
+		"decoding many backups of the same device), its clear-text is taken from the cache. The least\n"
+		"recently used values are replaced, if the cache is full, and values longer than %u bytes are never\n"
+		"stored there. If the cache can't be used, the values are decrypted without it.\n",
+		VALUE_CACHE_FILE_NAME, showUndl("directory"), VALUE_CACHE_DATA_SIZE
+	);
+
+	fprintf(out,
+		"\nThe options '--only-keys' (or '-o') and '--exclude-keys' (or '-x') select the values to decrypt by\n"
+		"the name of their setting - it's the name in front of the value in an assignment like 'name = \"...\";'.\n"
+		"All other cipher-text is copied unchanged and it's never decrypted. Only one of these options may be\n"
+		"specified.\n"
+	);
+
+	fprintf(out,
+		"\nWith '--format=ndjson' (or '-f ndjson') the input data isn't copied - each decrypted value is written\n"
+		"as a JSON object on its own line with the members 'file' (always null here), 'section' (the path of\n"
+		"the enclosing section like 'ddns.accounts[1]'), 'key' (the name of the setting), 'offset' (of the\n"
+		"cipher-text in the input data) and 'isString'. The clear-text is stored as 'value' for strings and as\n"
+		"hexadecimal string in 'hex' for binary data. The section path is only known, if the input data was\n"
+		"held in a single buffer and it could be parsed as configuration file, it's null otherwise. Values,\n"
+		"which can't be decrypted, are skipped.\n"
+	);
+
 	showUsageFinalize(out, help, version);
 }
 
@@ -167,6 +167,11 @@ int main(int argc, char** argv)
 				opterr = 0;
 				setAppletName(*name);
 				int exitCode = (*current->ep)(argumentCount, arguments, argumentOffset, current);
+				if (!outputClose() && exitCode == EXIT_SUCCESS) /* pending output couldn't be written */
+				{
+					errorMessage(errorWriteFailed);
+					exitCode = EXIT_FAILURE;
+				}
 				if (exitCode == EXIT_SUCCESS)
 				{
 					if (current->finalNewlineOnTTY && isatty(1) && !isAnyError())
@@ -43,6 +43,7 @@ int		decompose_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 	char *				outputDir = NULL;
 	struct stat			fileStat;
 	bool				withDictionary = false;
+	unsigned int		jobs = 0;
 
 	if (argc > argo + 1)
 	{
@@ -52,10 +53,11 @@ int		decompose_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 		static struct option options_long[] = {
 			{ "output-directory", required_argument, NULL, 'o' },
 			{ "dictionary", required_argument, NULL, 'd' },
+			{ "jobs", required_argument, NULL, 'j' },
 			verbosity_options_long,
 			options_long_end,
 		};
-		char *			options_short = ":" "o:d" verbosity_options_short;
+		char *			options_short = ":" "o:dj:" verbosity_options_short;
 
 		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
 		{
@@ -77,6 +79,20 @@ int		decompose_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 					withDictionary = true;
 					break;
 
+				case 'j':
+					{
+						char *	endString = NULL;
+
+						jobs = strtoul(optarg, &endString, 10);
+						if (!*optarg || *endString || jobs < 1 || jobs > EXPORT_MAX_JOBS)
+						{
+							errorMessage(errorInvalidJobCount, optarg);
+							setError(OPTION_VALUE_INVALID);
+							return EXIT_FAILURE;
+						}
+					}
+					break;
+
 				check_verbosity_options_short();
 				help_option();
 				getopt_invalid_option();
@@ -111,39 +127,73 @@ int		decompose_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 
 	resetError();
 
-	memoryBuffer_t	*inputFile = memoryBufferReadFile(stdin, -1);
-
-	if (!inputFile)
+	if (jobs > 0) /* sections are indexed first, the whole input is needed in memory */
 	{
-		if (!isAnyError()) /* empty input file */
+		memoryBuffer_t	*inputFile = NULL;
+		size_t			mappedSize = 0;
+		char *			mapped = memoryMapFile(stdin, &mappedSize);
+
+		if (mapped)
 		{
-			errorMessage(errorEmptyInputFile);
+			verboseMessage(verboseInputFileMapped, mappedSize);
+			decomposeExportData(mapped, mappedSize, outputDir, withDictionary, jobs);
+			mapped = memoryUnmapFile(mapped, mappedSize);
 		}
 		else
 		{
-			errorMessage(errorReadToMemory);
+			inputFile = memoryBufferReadFile(stdin, -1);
+
+			if (!inputFile)
+			{
+				if (!isAnyError()) /* empty input file */
+				{
+					errorMessage(errorEmptyInputFile);
+				}
+				else
+				{
+					errorMessage(errorReadToMemory);
+				}
+				return EXIT_FAILURE;
+			}
+
+			memoryBuffer_t	*consolidated = memoryBufferConsolidateData(inputFile);
+
+			inputFile = memoryBufferFreeChain(inputFile);
+			if (!consolidated)
+			{
+				errorMessage(errorNoMemory);
+				return EXIT_FAILURE;
+			}
+
+			decomposeExportData(consolidated->data, consolidated->used, outputDir, withDictionary, jobs);
+			consolidated = memoryBufferFreeChain(consolidated);
 		}
-		return EXIT_FAILURE;
+
+		if (isError(WRITE_FAILED))
+		{
+			errorMessage(errorWriteFailed);
+		}
+
+		return (!isAnyError() ? EXIT_SUCCESS : EXIT_FAILURE);
 	}
 
-	memoryBuffer_t	*consolidated = memoryBufferConsolidateData(inputFile);
+	int				first = fgetc(stdin);
 
-	if (!consolidated)
+	if (first == EOF)
 	{
-		errorMessage(errorNoMemory);
-		inputFile = memoryBufferFreeChain(inputFile);
+		if (!ferror(stdin)) /* empty input file */
+		{
+			errorMessage(errorEmptyInputFile);
+		}
+		else
+		{
+			errorMessage(errorReadToMemory);
+		}
 		return EXIT_FAILURE;
 	}
-	else
-	{
-		inputFile = memoryBufferFreeChain(inputFile);
-		inputFile = consolidated;
-		verboseMessage(verboseInputDataConsolidated, memoryBufferDataSize(inputFile));
-	}
-
-	decomposeExportFile(inputFile, outputDir, withDictionary);
+	ungetc(first, stdin);
 
-	memoryBufferFreeChain(inputFile);
+	decomposeExportFile(stdin, outputDir, withDictionary);
 
 	return (!isAnyError() ? EXIT_SUCCESS : EXIT_FAILURE);
 }
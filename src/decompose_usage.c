@@ -46,6 +46,7 @@ void 	decompose_usage(const bool help, UNUSED const bool version)
 	showOptionsHeader("options");
 	addOptionsEntry("-o, --output " __undl("directory"), "specifies the " __undl("directory") ", where the files will be stored; this option is mandatory (and therefore not really an option)", 8);
 	addOptionsEntry("-d, --dictionary", "create a dictionary file and store header data separately", 0);
+	addOptionsEntry("-j, --jobs " __undl("number"), "decode and write the contained files with the specified " __undl("number") " of parallel jobs", 8);
 	addOptionsEntryVerbose();
 	addOptionsEntryQuiet();
 	addOptionsEntryStrict();
@@ -63,6 +64,9 @@ void 	decompose_usage(const bool help, UNUSED const bool version)
 		"\nIf you want to create a new file to be imported from the decomposed export file, you may specify the\n"
 		"'--dictionary' (or '-d') option to store the original header lines and a list of all contained files,\n"
 		"preserving their order.\n"
+		"\nIf the '--jobs' (or '-j') option is specified, the input data is read completely and indexed first.\n"
+		"The contained files are written by the specified number of parallel jobs afterwards. This may speed\n"
+		"up the processing of large export files with big binary files therein.\n"
 	);
 
 	showUsageFinalize(out, help, version);
@@ -0,0 +1,233 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#define DECTFFS_C
+
+#include "common.h"
+#include "dectffs_usage.c"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+static	char *				__commandNames[] = {
+#include "dectffs_commands.c"
+		NULL
+};
+static	char * *			commandNames = &__commandNames[0];
+static	commandEntry_t 		__dectffs_command = { .names = &commandNames, .ep = &dectffs_entry, .short_desc = &dectffs_shortdesc, .usage = &dectffs_usage, .usesCrypto = true };
+EXPORTED commandEntry_t *	dectffs_command = &__dectffs_command;
+
+// compute the device key from the environment in the image or from the alternative environment file
+
+static	bool	dectffsKey(tffsImage_t * image, char * key, bool altEnv)
+{
+	char				hash[MAX_DIGEST_SIZE];
+	size_t				hashLen = sizeof(hash);
+	char				hex[(MAX_DIGEST_SIZE * 2) + 1];
+	size_t				hexLen;
+	environment_t *		env = NULL;
+	bool				success;
+
+	memset(key, 0, *cipher_keyLen);
+
+	if (altEnv)
+	{
+		verboseMessage(verboseAltEnv, getEnvironmentPath());
+		success = keyFromEnvironment(getEnvironment(), hash, &hashLen, false);
+	}
+	else
+	{
+		size_t			size = 0;
+		char *			text = tffsImageEnvironment(image, &size);
+
+		if (text && !(env = environmentParse(text, size)))
+			clearMemory(text, size + 1, true);
+
+		success = (env ? keyFromEnvironment(env, hash, &hashLen, false) : false);
+		env = environmentFree(env);
+	}
+
+	if (!success)
+		return false;
+
+	memcpy(key, hash, *cipher_ivLen);
+	hexLen = binaryToHexadecimal(hash, hashLen, hex, sizeof(hex));
+	hex[hexLen] = 0;
+	verboseMessage(verboseDeviceKeyHash, hex);
+	clearMemory(hash, sizeof(hash), false);
+
+	return true;
+}
+
+// 'decode_tffs' function - extract the nodes of a TFFS image and decode the secrets therein
+
+int		dectffs_entry(int argc, char** argv, int argo, commandEntry_t * entry)
+{
+	char *				outputDir = NULL;
+	struct stat			fileStat;
+	bool				altEnv = false;
+	bool				noDecode = false;
+
+	if (argc > argo + 1)
+	{
+		int				opt;
+		int				optIndex = 0;
+
+		static struct option options_long[] = {
+			{ "output-directory", required_argument, NULL, 'o' },
+			{ "no-decode", no_argument, NULL, 'n' },
+			altenv_options_long,
+			verbosity_options_long,
+			options_long_end,
+		};
+		char *			options_short = ":" "o:n" altenv_options_short verbosity_options_short;
+
+		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
+		{
+			switch (opt)
+			{
+				case 'o':
+					{
+						if (!optarg)
+						{
+							errorMessage(errorMissingDirectoryName);
+							setError(OPTION_VALUE_MISSING);
+							return EXIT_FAILURE;
+						}
+						outputDir = optarg;
+					}
+					break;
+
+				case 'n':
+					noDecode = true;
+					break;
+
+				check_altenv_options_short();
+				check_verbosity_options_short();
+				help_option();
+				getopt_argument_missing();
+				getopt_invalid_option();
+				invalid_option(opt);
+			}
+		}
+		if (optind < argc)
+			warnAboutExtraArguments(argv, optind + 1);
+	}
+
+	if (isatty(0))
+	{
+		errorMessage(errorNoReadFromTTY);
+		return EXIT_FAILURE;
+	}
+
+	if (!outputDir)
+	{
+		errorMessage(errorMissingDirectoryName);
+		setError(OPTION_VALUE_MISSING);
+		return EXIT_FAILURE;
+	}
+
+	if (stat(outputDir, &fileStat) != 0 || !S_ISDIR(fileStat.st_mode))
+	{
+		errorMessage(errorInvalidDirectoryName, outputDir);
+		setError(OPTION_VALUE_INVALID);
+	}
+
+	if (isAnyError())
+		return EXIT_FAILURE;
+
+	resetError();
+
+	CipherSizes();
+
+	char				key[*cipher_keyLen];
+	memoryBuffer_t		*inputFile = NULL;
+	memoryBuffer_t		*consolidated = NULL;
+	size_t				mappedSize = 0;
+	char *				mapped = memoryMapFile(stdin, &mappedSize);
+	char *				data = mapped;
+	size_t				size = mappedSize;
+	tffsImage_t *		image = NULL;
+
+	if (mapped) /* the image is read in place, only compressed nodes are copied */
+	{
+		verboseMessage(verboseInputFileMapped, mappedSize);
+	}
+	else
+	{
+		inputFile = memoryBufferReadFile(stdin, -1);
+
+		if (!inputFile)
+		{
+			if (!isAnyError()) /* empty input file */
+			{
+				errorMessage(errorEmptyInputFile);
+			}
+			else
+			{
+				errorMessage(errorReadToMemory);
+			}
+			return EXIT_FAILURE;
+		}
+
+		consolidated = memoryBufferConsolidateData(inputFile);
+		inputFile = memoryBufferFreeChain(inputFile);
+
+		if (!consolidated)
+		{
+			errorMessage(errorNoMemory);
+			return EXIT_FAILURE;
+		}
+
+		data = consolidated->data;
+		size = consolidated->used;
+	}
+
+	if (!(image = tffsImageParse(data, size)))
+	{
+		if (isError(INVALID_FILE))
+		{
+			errorMessage(errorInvalidTffsImage);
+		}
+		else
+		{
+			errorMessage(errorNoMemory);
+		}
+	}
+	else if (noDecode || dectffsKey(image, key, altEnv))
+	{
+		if (!tffsDecodeNodes(image, (noDecode ? NULL : key), outputDir) && isError(WRITE_FAILED))
+		{
+			errorMessage(errorWriteFailed);
+		}
+	}
+
+	clearMemory(key, *cipher_keyLen, false);
+	image = tffsImageFree(image);
+	consolidated = memoryBufferFreeChain(consolidated);
+	mapped = memoryUnmapFile(mapped, mappedSize);
+
+	return (!isAnyError() ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+#pragma GCC diagnostic pop
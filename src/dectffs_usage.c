@@ -0,0 +1,78 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+// display usage help
+
+void 	dectffs_usage(const bool help, UNUSED const bool version)
+{
+	FILE *	out = (help || version ? stdout : stderr);
+
+	showUsageHeader(out, help, version);
+
+	if (version)
+	{
+		fprintf(out, "\n");
+		return;
+	}
+
+	showPurposeHeader(out);
+	fprintf(out,
+		"This program extracts the nodes of a TFFS image and decrypts the secret values in them.\n"
+	);
+
+	showFormatHeader(out);
+	addSpace();
+	addOption("options");
+	showFormatEnd(out);
+
+	showOptionsHeader("options");
+	addOptionsEntry("-o, --output " __undl("directory"), "specifies the " __undl("directory") ", where the files will be stored; this option is mandatory (and therefore not really an option)", 8);
+	addOptionsEntry("-n, --no-decode", "extract the files only, their content isn't decrypted", 0);
+	addOptionsEntry("-a, --alt-env " __undl("filename"), "use the device key computed from the alternative environment file instead of the environment within the image", 8);
+	addOptionsEntryVerbose();
+	addOptionsEntryQuiet();
+	addOptionsEntryStrict();
+	addOptionsEntryHelp();
+	addOptionsEntryVersion();
+	showOptionsEnd(out);
+
+	fprintf(out,
+		"\nThe raw TFFS image (a dump of the flash partition) is expected on STDIN. Execution will be aborted,\n"
+		"if STDIN is a terminal device.\n"
+	);
+
+	fprintf(out,
+		"\nThe image is read in a single pass, only the newest version of each node is used. Compressed nodes\n"
+		"are expanded. Each node with a name is written to a file with this name, nodes without a name are\n"
+		"stored as 'node_' followed by their ID. The variables of the 'urlader environment' are written to\n"
+		"the file 'environment', they're used to compute the key for the secrets in all other files, unless\n"
+		"the '--alt-env' (or '-a') option is specified.\n"
+		"\nThe output directory has to exist. Any data file therein may be overwritten without further warning.\n"
+	);
+
+	showUsageFinalize(out, help, version);
+}
+
+char *	dectffs_shortdesc(void)
+{
+	return "extract and decode the files from a TFFS image";
+}
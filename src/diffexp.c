@@ -0,0 +1,617 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#define DIFFEXP_C
+
+#include "common.h"
+#include "diffexp_usage.c"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+static	char *				__commandNames[] = {
+#include "diffexp_commands.c"
+		NULL
+};
+static	char * *			commandNames = &__commandNames[0];
+static	commandEntry_t 		__diffexp_command = { .names = &commandNames, .ep = &diffexp_entry, .usage = &diffexp_usage, .short_desc = &diffexp_shortdesc, .usesCrypto = true };
+EXPORTED commandEntry_t *	diffexp_command = &__diffexp_command;
+
+// an export file in memory with the key for its values and the index of its sections
+
+typedef struct {
+	char *				name;
+	char *				data;
+	size_t				size;
+	char *				mapped;
+	memoryBuffer_t *	buffer;
+	char *				key;
+	exportIndexEntry_t *	entries;
+	size_t				count;
+} diffExport_t;
+
+// a value from a configuration file with its complete path, values are compared in the order of their paths
+
+typedef struct {
+	char *				path;
+	size_t				node;
+} diffValue_t;
+
+// comparison state
+
+typedef struct {
+	CipherContext *		ctx;
+	outputFormat_t		format;
+	outputSink_t *		out;
+	size_t				unchanged;
+	size_t				decoded;
+	size_t				records;
+} diffState_t;
+
+// load an export file and decrypt the key of its second stage, the sections are indexed and their
+// checksums are computed
+
+static	bool	diffLoadExport(diffExport_t * export, char * key)
+{
+	FILE *				file = fopen(export->name, "r");
+	memoryIndex_t *		index;
+	size_t				found;
+	size_t				valueSize;
+	size_t				keySize = *cipher_keyLen;
+	bool				isString = false;
+
+	if (!file)
+	{
+		errorMessage(errorOpeningInputFile, export->name);
+		returnError(IO_ERROR, false);
+	}
+
+	if ((export->mapped = memoryMapFile(file, &export->size)) != NULL)
+		export->data = export->mapped;
+	else if ((export->buffer = memoryBufferReadFile(file, -1)) != NULL)
+	{
+		memoryBuffer_t *	consolidated = memoryBufferConsolidateData(export->buffer);
+
+		export->buffer = memoryBufferFreeChain(export->buffer);
+		if ((export->buffer = consolidated) != NULL)
+		{
+			export->data = export->buffer->data;
+			export->size = export->buffer->used;
+		}
+	}
+
+	fclose(file);
+
+	if (!export->data)
+	{
+		if (!isAnyError())
+			setError(INVALID_FILE);
+		errorMessage(errorReadToMemory);
+		return false;
+	}
+
+	if (!(index = memoryIndexFromData(export->data, export->size)))
+	{
+		errorMessage(errorNoMemory);
+		returnError(NO_MEMORY, false);
+	}
+
+	if ((found = memoryIndexFindString(index, 0, EXPORT_PASSWORD_NAME, strlen(EXPORT_PASSWORD_NAME))) == export->size)
+	{
+		index = memoryIndexFree(index);
+		errorMessage(errorNoPasswordEntry);
+		returnError(INVALID_FILE, false);
+	}
+
+	found += strlen(EXPORT_PASSWORD_NAME);
+	valueSize = memoryIndexValueSize(index, found);
+	index = memoryIndexFree(index);
+
+	if (valueSize != 104)
+	{
+		errorMessage(errorInvalidFirstStageLength, valueSize, EXPORT_PASSWORD_NAME);
+		returnError(INV_DATA_SIZE, false);
+	}
+
+	if (!decryptValueData(NULL, export->data + found, valueSize, key, export->key, &keySize, &isString))
+	{
+		errorMessage(errorDecryptionFailed);
+		return false;
+	}
+
+	memset(export->key + *cipher_ivLen, 0, *cipher_keyLen - *cipher_ivLen);
+
+	if (!(export->entries = exportIndexSections(export->data, export->size, &export->count)) && isAnyError())
+		return false;
+
+	return exportIndexChecksums(export->entries, export->count);
+}
+
+static	void	diffFreeExport(diffExport_t * export)
+{
+	if (export->entries)
+		free(export->entries);
+	export->entries = NULL;
+	export->buffer = memoryBufferFreeChain(export->buffer);
+	export->mapped = memoryUnmapFile(export->mapped, export->size);
+	if (export->key)
+		clearMemory(export->key, *cipher_keyLen, false);
+}
+
+// write a single difference - the path is missing for a whole file, a missing value is written as dash
+// or as null
+
+static	bool	diffWriteRecord(diffState_t * state, char * change, exportIndexEntry_t * file, char * path, char * oldValue, size_t oldSize, char * newValue, size_t newSize)
+{
+	outputSink_t *		out = state->out;
+	bool				success;
+
+	state->records++;
+
+	if (state->format == OUTPUT_FORMAT_NDJSON)
+	{
+		success = (outputSinkWrite(out, "{\"change\":\"", 11) && outputSinkWrite(out, change, strlen(change)) &&
+				   outputSinkWrite(out, "\",\"file\":", 9) && outputSinkWriteJson(out, file->name, file->nameSize) &&
+				   outputSinkWrite(out, ",\"path\":", 8) && (path ? outputSinkWriteJson(out, path, strlen(path)) : outputSinkWrite(out, "null", 4)) &&
+				   outputSinkWrite(out, ",\"old\":", 7) && (oldValue ? outputSinkWriteJson(out, oldValue, oldSize) : outputSinkWrite(out, "null", 4)) &&
+				   outputSinkWrite(out, ",\"new\":", 7) && (newValue ? outputSinkWriteJson(out, newValue, newSize) : outputSinkWrite(out, "null", 4)) &&
+				   outputSinkWrite(out, "}\n", 2));
+	}
+	else
+	{
+		success = (outputSinkWrite(out, change, strlen(change)) && outputSinkWrite(out, "\t", 1) &&
+				   outputSinkWrite(out, file->name, file->nameSize) && outputSinkWrite(out, "\t", 1) &&
+				   outputSinkWrite(out, (path ? path : "-"), (path ? strlen(path) : 1)) && outputSinkWrite(out, "\t", 1) &&
+				   outputSinkWrite(out, (oldValue ? oldValue : "-"), (oldValue ? oldSize : 1)) && outputSinkWrite(out, "\t", 1) &&
+				   outputSinkWrite(out, (newValue ? newValue : "-"), (newValue ? newSize : 1)) && outputSinkWrite(out, "\n", 1));
+	}
+
+	if (!success)
+		setError(WRITE_FAILED);
+
+	return success;
+}
+
+// get the value of a node with decrypted cipher-text in the syntax of the file, the result has to be
+// wiped and released by the caller
+
+static	char *	diffValueText(diffState_t * state, configNode_t * node, char * key, size_t * size)
+{
+	memoryView_t *		view = memoryViewNew();
+	outputSink_t *		sink = (view ? outputSinkForView(view) : NULL);
+	char *				text = NULL;
+
+	*size = 0;
+
+	if (sink && configWriteValue(node, state->ctx, key, OUTPUT_FORMAT_TEXT, sink, NULL) && outputSinkFlush(sink))
+	{
+		*size = memoryViewDataSize(view);
+
+		if ((text = (char *) malloc(*size + 1)) != NULL)
+		{
+			size_t		used = 0;
+
+			for (size_t i = 0; i < view->count; i++)
+			{
+				memcpy(text + used, view->spans[i].iov_base, view->spans[i].iov_len);
+				used += view->spans[i].iov_len;
+			}
+			*(text + used) = 0;
+		}
+		else
+			setError(NO_MEMORY);
+	}
+
+	if (memmem(node->value, node->valueSize, "$$$$", 4))
+		state->decoded++;
+
+	sink = outputSinkFree(sink);
+	view = memoryViewFree(view);
+
+	return text;
+}
+
+// collect the values of a configuration file with their paths and sort them
+
+static	int		compareValuePath(const void * left, const void * right)
+{
+	const diffValue_t *	leftValue = (const diffValue_t *) left;
+	const diffValue_t *	rightValue = (const diffValue_t *) right;
+	int					result = strcmp(leftValue->path, rightValue->path);
+
+	return (result ? result : (leftValue->node < rightValue->node ? -1 : (leftValue->node > rightValue->node ? 1 : 0)));
+}
+
+// number the sections with the same name and parent in the order of their appearance - a list is counted
+// like its instances, but a section may be repeated without the list syntax too and its values need an
+// unique path nevertheless
+
+static	size_t *	diffNumberSections(configIndex_t * index)
+{
+	size_t *			occurrence = (size_t *) malloc((index->count ? index->count : 1) * sizeof(size_t));
+
+	if (!occurrence)
+		returnError(NO_MEMORY, NULL);
+
+	for (size_t i = 0; i < index->count; i++)
+	{
+		configNode_t *	current = &index->nodes[i];
+		size_t			first = (current->parent == CONFIG_NO_PARENT ? 0 : current->parent + 1);
+
+		occurrence[i] = DIFF_SINGLE_SECTION;
+
+		if (current->type != CONFIG_NODE_SECTION)
+			continue;
+
+		for (size_t j = i; j-- > first; )
+		{
+			configNode_t *	sibling = &index->nodes[j];
+
+			if (sibling->type != CONFIG_NODE_SECTION || sibling->parent != current->parent || sibling->nameSize != current->nameSize || memcmp(sibling->name, current->name, current->nameSize))
+				continue;
+
+			if (occurrence[j] == DIFF_SINGLE_SECTION)
+				occurrence[j] = 0;
+			occurrence[i] = occurrence[j] + 1;
+			break;
+		}
+	}
+
+	return occurrence;
+}
+
+// build the path of a value with the number of each repeated section, the result is truncated to the
+// size of the buffer and the length of the complete path is returned
+
+static	size_t	diffPathString(configIndex_t * index, size_t * occurrence, size_t node, char * buffer, size_t size)
+{
+	configNode_t *		current = &index->nodes[node];
+	size_t				used = 0;
+	int					added;
+
+	if (current->parent != CONFIG_NO_PARENT)
+	{
+		used = diffPathString(index, occurrence, current->parent, buffer, size);
+		used += snprintf(buffer + (used < size ? used : size), (used < size ? size - used : 0), ".");
+	}
+
+	if (occurrence[node] != DIFF_SINGLE_SECTION)
+		added = snprintf(buffer + (used < size ? used : size), (used < size ? size - used : 0), "%.*s[%lu]", (int) current->nameSize, current->name, (unsigned long) occurrence[node]);
+	else
+		added = snprintf(buffer + (used < size ? used : size), (used < size ? size - used : 0), "%.*s", (int) current->nameSize, current->name);
+
+	return used + (added > 0 ? (size_t) added : 0);
+}
+
+static	diffValue_t *	diffCollectValues(configIndex_t * index, size_t * count)
+{
+	diffValue_t *		values = (diffValue_t *) calloc((index->count ? index->count : 1), sizeof(diffValue_t));
+	size_t *			occurrence = (values ? diffNumberSections(index) : NULL);
+	char				path[DIFF_PATH_SIZE];
+
+	*count = 0;
+
+	if (!occurrence)
+	{
+		free(values);
+		returnError(NO_MEMORY, NULL);
+	}
+
+	for (size_t i = 0; i < index->count; i++)
+	{
+		size_t			size;
+
+		if (index->nodes[i].type != CONFIG_NODE_VALUE)
+			continue;
+
+		size = diffPathString(index, occurrence, i, path, sizeof(path));
+		if (size >= sizeof(path))
+			size = sizeof(path) - 1;
+
+		if (!(values[*count].path = strndup(path, size)))
+		{
+			for (size_t j = 0; j < *count; j++)
+				free(values[j].path);
+			free(values);
+			free(occurrence);
+			*count = 0;
+			returnError(NO_MEMORY, NULL);
+		}
+
+		values[(*count)++].node = i;
+	}
+
+	free(occurrence);
+	qsort(values, *count, sizeof(diffValue_t), &compareValuePath);
+
+	return values;
+}
+
+static	diffValue_t *	diffFreeValues(diffValue_t * values, size_t count)
+{
+	if (values)
+	{
+		for (size_t i = 0; i < count; i++)
+			free(values[i].path);
+		free(values);
+	}
+
+	return NULL;
+}
+
+// compare the values of a changed configuration file - a value is only decrypted, if its text differs
+// from the other file or if it exists only in one of them
+
+static	bool	diffConfigFile(diffState_t * state, exportIndexEntry_t * oldFile, char * oldKey, exportIndexEntry_t * newFile, char * newKey)
+{
+	configIndex_t *		oldIndex = configIndexParse(oldFile->data, oldFile->size, false);
+	configIndex_t *		newIndex = (oldIndex ? configIndexParse(newFile->data, newFile->size, false) : NULL);
+	diffValue_t *		oldValues = NULL;
+	diffValue_t *		newValues = NULL;
+	size_t				oldCount = 0;
+	size_t				newCount = 0;
+	size_t				o = 0;
+	size_t				n = 0;
+
+	if (!oldIndex || !newIndex) /* no configuration file, the difference is shown for the whole file */
+	{
+		oldIndex = configIndexFree(oldIndex);
+		if (!isError(INVALID_FILE))
+			return false;
+		resetError();
+		return diffWriteRecord(state, "changed", newFile, NULL, NULL, 0, NULL, 0);
+	}
+
+	if ((oldValues = diffCollectValues(oldIndex, &oldCount)) != NULL)
+		newValues = diffCollectValues(newIndex, &newCount);
+
+	while (newValues && !isAnyError() && (o < oldCount || n < newCount))
+	{
+		int				order = (o == oldCount ? 1 : (n == newCount ? -1 : strcmp(oldValues[o].path, newValues[n].path)));
+		configNode_t *	oldNode = (order <= 0 ? &oldIndex->nodes[oldValues[o].node] : NULL);
+		configNode_t *	newNode = (order >= 0 ? &newIndex->nodes[newValues[n].node] : NULL);
+		char *			oldText = NULL;
+		char *			newText = NULL;
+		size_t			oldSize = 0;
+		size_t			newSize = 0;
+
+		if (oldNode && newNode && oldNode->valueSize == newNode->valueSize && !memcmp(oldNode->value, newNode->value, oldNode->valueSize))
+		{
+			o++;
+			n++;
+			continue;
+		}
+
+		if (oldNode && !(oldText = diffValueText(state, oldNode, oldKey, &oldSize)))
+			break;
+
+		if (newNode && !(newText = diffValueText(state, newNode, newKey, &newSize)))
+		{
+			oldText = clearMemory(oldText, oldSize, true);
+			break;
+		}
+
+		if (!oldNode)
+			diffWriteRecord(state, "added", newFile, newValues[n].path, NULL, 0, newText, newSize);
+		else if (!newNode)
+			diffWriteRecord(state, "removed", newFile, oldValues[o].path, oldText, oldSize, NULL, 0);
+		else if (oldSize != newSize || memcmp(oldText, newText, oldSize))
+			diffWriteRecord(state, "changed", newFile, newValues[n].path, oldText, oldSize, newText, newSize);
+
+		oldText = clearMemory(oldText, oldSize, true);
+		newText = clearMemory(newText, newSize, true);
+
+		if (oldNode)
+			o++;
+		if (newNode)
+			n++;
+	}
+
+	oldValues = diffFreeValues(oldValues, oldCount);
+	newValues = diffFreeValues(newValues, newCount);
+	oldIndex = configIndexFree(oldIndex);
+	newIndex = configIndexFree(newIndex);
+
+	return !isAnyError();
+}
+
+// find a file section by its name
+
+static	exportIndexEntry_t *	diffFindFile(diffExport_t * export, exportIndexEntry_t * file)
+{
+	for (size_t i = 0; i < export->count; i++)
+	{
+		exportIndexEntry_t *	entry = &export->entries[i];
+
+		if (entry->section != EXPORT_SECTION_HEADER && entry->nameSize == file->nameSize && !memcmp(entry->name, file->name, file->nameSize))
+			return entry;
+	}
+
+	return NULL;
+}
+
+// compare the files of two exports - files with the same checksum are skipped, changed configuration
+// files are compared value by value and other files only as a whole
+
+static	bool	diffExports(diffState_t * state, diffExport_t * oldExport, diffExport_t * newExport)
+{
+	size_t				files = 0;
+
+	for (size_t i = 0; i < newExport->count && !isAnyError(); i++)
+	{
+		exportIndexEntry_t *	newFile = &newExport->entries[i];
+		exportIndexEntry_t *	oldFile;
+
+		if (newFile->section == EXPORT_SECTION_HEADER)
+			continue;
+
+		files++;
+
+		if (!(oldFile = diffFindFile(oldExport, newFile)))
+			diffWriteRecord(state, "added", newFile, NULL, NULL, 0, NULL, 0);
+		else if (oldFile->section == newFile->section && oldFile->checksum == newFile->checksum && oldFile->counted == newFile->counted)
+			state->unchanged++;
+		else if (oldFile->section == EXPORT_SECTION_CFGFILE && newFile->section == EXPORT_SECTION_CFGFILE)
+			diffConfigFile(state, oldFile, oldExport->key, newFile, newExport->key);
+		else
+			diffWriteRecord(state, "changed", newFile, NULL, NULL, 0, NULL, 0);
+	}
+
+	for (size_t i = 0; i < oldExport->count && !isAnyError(); i++)
+	{
+		exportIndexEntry_t *	oldFile = &oldExport->entries[i];
+
+		if (oldFile->section != EXPORT_SECTION_HEADER && !diffFindFile(newExport, oldFile))
+			diffWriteRecord(state, "removed", oldFile, NULL, NULL, 0, NULL, 0);
+	}
+
+	verboseMessage(verboseFilesCompared, (unsigned long) state->unchanged, (unsigned long) files, (unsigned long) state->decoded);
+
+	return !isAnyError();
+}
+
+// 'diff_export' function - show the differences between two export files of the same device
+
+int		diffexp_entry(int argc, char** argv, int argo, commandEntry_t * entry)
+{
+	char *				serial = NULL;
+	char *				maca = NULL;
+	bool				altEnv = false;
+	outputFormat_t		format = OUTPUT_FORMAT_TEXT;
+	diffExport_t		oldExport;
+	diffExport_t		newExport;
+
+	memset(&oldExport, 0, sizeof(diffExport_t));
+	memset(&newExport, 0, sizeof(diffExport_t));
+
+	if (argc > argo + 1)
+	{
+		int				opt;
+		int				optIndex = 0;
+
+		static struct option options_long[] = {
+			format_options_long,
+			altenv_options_long,
+			keycache_options_long,
+			verbosity_options_long,
+			options_long_end,
+		};
+		char *			options_short = ":" format_options_short altenv_options_short keycache_options_short verbosity_options_short;
+
+		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
+		{
+			switch (opt)
+			{
+				check_format_options_short();
+				check_altenv_options_short();
+				check_keycache_options_short();
+				check_verbosity_options_short();
+				help_option();
+				getopt_argument_missing();
+				getopt_invalid_option();
+				invalid_option(opt);
+			}
+		}
+		if (optind < argc)
+		{
+			int			i = optind + argo;
+			int			index = 0;
+
+			char *		*arguments[] = {
+				&oldExport.name,
+				&newExport.name,
+				&serial,
+				&maca,
+				NULL
+			};
+
+			while (argv[i])
+			{
+				*(arguments[index++]) = argv[i++];
+				if (!arguments[index])
+				{
+					warnAboutExtraArguments(argv, i);
+					break;
+				}
+			}
+		}
+	}
+
+	if (isAnyError())
+		return EXIT_FAILURE;
+
+	if (!newExport.name)
+	{
+		errorMessage(errorMissingExportFiles);
+		__autoUsage();
+		return EXIT_FAILURE;
+	}
+
+	resetError();
+
+	CipherSizes();
+
+	char				key[*cipher_keyLen];
+	char				oldKey[*cipher_keyLen];
+	char				newKey[*cipher_keyLen];
+	diffState_t			state;
+
+	if ((serial || maca) && altEnv)
+	{
+		warningMessage(verboseAltEnvIgnored);
+		failOnStrict();
+	}
+
+	if (!exportKeyFromArguments(key, (maca ? NULL : serial), serial, maca, altEnv))
+		return EXIT_FAILURE;
+
+	memset(&state, 0, sizeof(diffState_t));
+	state.format = format;
+	state.out = outputStdout();
+	oldExport.key = oldKey;
+	newExport.key = newKey;
+
+	if (diffLoadExport(&oldExport, key) && diffLoadExport(&newExport, key))
+	{
+		if ((state.ctx = CipherInit(NULL, CipherTypeValue, NULL, NULL, false)) != NULL)
+			diffExports(&state, &oldExport, &newExport);
+		else
+			errorMessage(errorNoMemory);
+	}
+
+	if (isError(NO_MEMORY))
+		errorMessage(errorNoMemory);
+
+	state.ctx = (state.ctx ? CipherCleanup(state.ctx) : NULL);
+	clearMemory(key, *cipher_keyLen, false);
+
+	if (!outputClose())
+		errorMessage(errorWriteFailed);
+
+	diffFreeExport(&oldExport);
+	diffFreeExport(&newExport);
+
+	return (isAnyError() ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,104 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+
+// display usage help
+
+void 	diffexp_usage(const bool help, UNUSED const bool version)
+{
+	FILE *	out = (help || version ? stdout : stderr);
+
+	showUsageHeader(out, help, version);
+
+	if (version)
+	{
+		fprintf(out, "\n");
+		return;
+	}
+
+	showPurposeHeader(out);
+	fprintf(out,
+		"This program compares two export files of the same device and writes the differences to STDOUT - for\n"
+		"configuration files, each changed setting is shown with its decrypted values.\n"
+	);
+
+	showFormatHeader(out);
+	addSpace();
+	addOption("options");
+	addSpace();
+	endOptions();
+	addSpace();
+	addArgument("old-export");
+	addSpace();
+	addArgument("new-export");
+	addSpace();
+	startOption();
+	addArgument("parameter");
+	addSpace();
+	startOption();
+	addArgument("parameter");
+	endOption();
+	endOption();
+	showFormatEnd(out);
+
+	showOptionsHeader("options");
+	addOptionsEntry("-f, --format " __undl("format"), "write the differences as 'text' (the default) or as 'ndjson'", 8);
+	addOptionsEntry("-a, --alt-env " __undl("filename"), "use an alternative source for the 'urlader environment'", 8);
+	addOptionsEntry("-K, --key-cache " __undl("seconds"), "keep the device key in the kernel keyring for " __undl("seconds"), 8);
+	addOptionsEntryVerbose();
+	addOptionsEntryQuiet();
+	addOptionsEntryStrict();
+	addOptionsEntryHelp();
+	addOptionsEntryVersion();
+	showOptionsEnd(out);
+
+	fprintf(out,
+		"\nThe %ss select the key of both files the same way as for 'decode_export' - a single\n"
+		"%s is the password used for the export, the serial number and the MAC address select the\n"
+		"device, and without any %s the properties of the running device are used.\n",
+		showUndl("parameter"), showUndl("parameter"), showUndl("parameter")
+	);
+
+	fprintf(out,
+		"\nThe checksum of each file within both exports is computed first and files with the same value are\n"
+		"skipped. Changed configuration files are compared setting by setting, the settings are matched with\n"
+		"their complete path (e.g. 'ar7cfg.ddns.accounts[1].passwd') and only values with a different text\n"
+		"are decrypted. A section, which is repeated without the list syntax, is numbered like the instances\n"
+		"of a list. Each export uses its own key for the values, so any file with encrypted values has\n"
+		"another checksum and it's always compared this way. Other files are only shown as changed.\n"
+	);
+
+	fprintf(out,
+		"\nEach difference is written as a line with the kind of the change ('added', 'removed' or 'changed'),\n"
+		"the name of the file, the path of the setting and the old and the new value (in the syntax of the\n"
+		"file), separated by tabs. A dash is written for a missing value and for the path of a whole file.\n"
+		"The 'ndjson' format writes a JSON object with the keys 'change', 'file', 'path', 'old' and 'new'\n"
+		"instead, missing values are null there.\n"
+	);
+
+	showUsageFinalize(out, help, version);
+}
+
+char *	diffexp_shortdesc(void)
+{
+	return "show the differences between two FRITZ!OS export files";
+}
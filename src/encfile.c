@@ -0,0 +1,194 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+#define ENCFILE_C
+
+#include "common.h"
+#include "encfile_usage.c"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+static	char *				__commandNames[] = {
+#include "encfile_commands.c"
+		NULL
+};
+static	char * *			commandNames = &__commandNames[0];
+static	commandEntry_t 		__encfile_command = { .names = &commandNames, .ep = &encfile_entry, .usage = &encfile_usage, .short_desc = &encfile_shortdesc, .usesCrypto = true };
+EXPORTED commandEntry_t *	encfile_command = &__encfile_command;
+
+// 'encrypt_secrets' function - encrypt all clear-text placeholders from STDIN content and copy it with replaced values to STDOUT
+
+int		encfile_entry(int argc, char** argv, int argo, commandEntry_t * entry)
+{
+	char *				serial = NULL;
+	char *				maca = NULL;
+	char *				wlanKey = NULL;
+	char *				tr069Passphrase = NULL;
+	bool				altEnv = false;
+	bool				tty = false;
+
+	if (argc > argo + 1)
+	{
+		int				opt;
+		int				optIndex = 0;
+
+		static struct option options_long[] = {
+			{ "tty", no_argument, NULL, 't' },
+			altenv_options_long,
+			verbosity_options_long,
+			options_long_end,
+		};
+		char *			options_short = ":" "t" altenv_options_short verbosity_options_short;
+
+		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
+		{
+			switch (opt)
+			{
+				case 't':
+					tty = true;
+					break;
+
+				check_altenv_options_short();
+				check_verbosity_options_short();
+				help_option();
+				getopt_argument_missing();
+				getopt_invalid_option();
+				invalid_option(opt);
+			}
+		}
+		if (optind < argc)
+		{
+			int			i = optind + argo;
+			int			index = 0;
+
+			char *		*arguments[] = {
+				&serial,
+				&maca,
+				&wlanKey,
+				&tr069Passphrase,
+				NULL
+			};
+
+			while (argv[i])
+			{
+				if (!argv[i + 1])
+				{
+					if (isatty(0) && !tty)
+					{
+						if (checkLastArgumentIsInputFile(argv[i]))
+							break;
+					}
+				}
+				*(arguments[index++]) = argv[i++];
+				if (!arguments[index])
+				{
+					if (argv[i])
+					{
+						if (checkLastArgumentIsInputFile(argv[i]))
+							i++;
+					}
+					warnAboutExtraArguments(argv,i);
+					break;
+				}
+			}
+		}
+	}
+
+	if (isAnyError())
+		return EXIT_FAILURE;
+
+	resetError();
+
+	CipherSizes();
+
+	char				key[*cipher_keyLen];
+
+	if (!keyFromArguments(key, serial, maca, wlanKey, tr069Passphrase, altEnv))
+		return EXIT_FAILURE;
+
+	if (isatty(0) && !tty)
+	{
+		errorMessage(errorReadFromTTY);
+		return EXIT_FAILURE;
+	}
+
+	memoryBuffer_t		*inputFile = NULL;
+	memoryIndex_t		*index = NULL;
+	valueEncryptor_t	*encryptor = valueEncryptorNew(key);
+	size_t				mappedSize = 0;
+	char *				mapped = memoryMapFile(stdin, &mappedSize);
+
+	clearMemory(key, *cipher_keyLen, false);
+
+	if (mapped) /* unchanged data may be passed through to the output without copying it to user space */
+	{
+		verboseMessage(verboseInputFileMapped, mappedSize);
+		index = memoryIndexFromData(mapped, mappedSize);
+		if (outputStdout())
+			outputSinkSetSource(outputStdout(), fileno(stdin), mapped, mappedSize);
+	}
+	else
+	{
+		inputFile = memoryBufferReadFile(stdin, -1);
+
+		if (!inputFile)
+		{
+			encryptor = valueEncryptorFree(encryptor);
+			if (!isAnyError()) /* empty input file */
+				return EXIT_SUCCESS;	
+			errorMessage(errorReadToMemory);
+			return EXIT_FAILURE;
+		}
+
+		index = memoryIndexNew(inputFile);
+	}
+
+	if (!index || !encryptor)
+	{
+		errorMessage(errorNoMemory);
+		encryptor = valueEncryptorFree(encryptor);
+		index = memoryIndexFree(index);
+		inputFile = memoryBufferFreeChain(inputFile);
+		mapped = memoryUnmapFile(mapped, mappedSize);
+		return EXIT_FAILURE;
+	}
+
+	if (!memoryBufferEncryptFile(index, 0, encryptor, outputStdout()) && isError(OSSL_CIPHER_ERR))
+	{
+		errorMessage(errorEncryptionFailed);
+	}
+
+	verboseMessage(verboseValuesEncrypted, encryptor->count);
+
+	if (!outputClose()) /* input buffers are referenced until the data was written */
+		errorMessage(errorWriteFailed);
+
+	encryptor = valueEncryptorFree(encryptor);
+	index = memoryIndexFree(index);
+	inputFile = memoryBufferFreeChain(inputFile);
+	mapped = memoryUnmapFile(mapped, mappedSize);
+
+	return (isAnyError() ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,108 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+// display usage help
+
+void 	encfile_usage(const bool help, UNUSED const bool version)
+{
+	FILE *	out = (help || version ? stdout : stderr);
+
+	showUsageHeader(out, help, version);
+
+	if (version)
+	{
+		fprintf(out, "\n");
+		return;
+	}
+
+	showPurposeHeader(out);
+	fprintf(out,
+		"This program encrypts all clear-text placeholders in data on STDIN and writes the data to STDOUT,\n"
+		"while replacing the placeholders with the corresponding cipher-text values.\n"
+	);
+
+	showFormatHeader(out);
+	addSpace();
+	addOption("options");
+	addSpace();
+	endOptions();
+	addSpace();
+	startOption();
+	addArgument("parameter");
+	addSpace();
+	startOption();
+	addNormalString("...");
+	endOption();
+	endOption();
+	addSpace();
+	startOption();
+	startOption();
+	addNormalString("<");
+	endOption();
+	addSpace();
+	addArgument("input-file");
+	endOption();
+	showFormatEnd(out);
+
+	showOptionsHeader("options");
+	addOptionsEntry("-t, --tty", "don't quit execution, if STDIN is connected to a terminal device", 0);
+	addOptionsEntry("-a, --alt-env " __undl("filename"), "use an alternative source for the 'urlader environment'", 8);
+	addOptionsEntryVerbose();
+	addOptionsEntryQuiet();
+	addOptionsEntryStrict();
+	addOptionsEntryHelp();
+	addOptionsEntryVersion();
+	showOptionsEnd(out);
+
+	fprintf(out,
+		"\nA placeholder starts with four dollar-signs and an opening brace and it ends with the next closing\n"
+		"brace, e.g. 'passwd = \"$$$${secret}\";'. A backslash within a placeholder escapes the following\n"
+		"character, like in the quoted strings of configuration files. The clear-text is encrypted as string\n"
+		"(with a terminating NUL character) and every value gets its own random IV, the result is written\n"
+		"with four dollar-signs in front of the Base32 encoded cipher-text.\n"
+	);
+
+	fprintf(out,
+		"\nA placeholder without a closing brace is written unchanged with a warning - this is an error in\n"
+		"strict mode.\n"
+	);
+
+	fprintf(out,
+		"\nThe key is specified with the same %ss as for %s: nothing to use the properties\n"
+		"of the running device (or of the 'urlader environment' from the '--alt-env' option), a hexadecimal\n"
+		"key or the '%s', '%s', '%s' (and '%s') values of another device.\n",
+		showUndl("parameter"), showBold("decode_secrets"), showUndl(URLADER_SERIAL_NAME),
+		showUndl(URLADER_MACA_NAME), showUndl(URLADER_WLANKEY_NAME), showUndl(URLADER_TR069PP_NAME)
+	);
+
+	fprintf(out,
+		"\nSTDIN has to be redirected or the program will be aborted, unless the '--tty' option (or '-t') was\n"
+		"specified or the last value from command line is the name of a readable %s.\n",
+		showUndl("input-file")
+	);
+
+	showUsageFinalize(out, help, version);
+}
+
+char *	encfile_shortdesc(void)
+{
+	return "encrypt clear-text placeholders in a text file";
+}
@@ -39,9 +39,18 @@ EXPORTED	void	encryptionInit(void)
 
 // decrypt a Base32 value using the specified key
 
-EXPORTED	bool	decryptValue(CipherContext * ctx, char * cipherText, size_t cipherTextSize, FILE * out, char * outBuffer, char * key, bool escaped)
+EXPORTED	bool	decryptValue(CipherContext * ctx, char * cipherText, size_t cipherTextSize, outputSink_t * out, char * outBuffer, char * key, bool escaped)
 {
-	size_t			cipherBufSize = base32ToBinary(cipherText, cipherTextSize, NULL, 0);
+	struct iovec	vector = { .iov_base = cipherText, .iov_len = cipherTextSize };
+
+	return decryptValueVector(ctx, &vector, 1, out, outBuffer, key, escaped);
+}
+
+// decrypt a Base32 value, which may be spread over more than one memory span
+
+EXPORTED	bool	decryptValueVector(CipherContext * ctx, struct iovec * cipherText, int count, outputSink_t * out, char * outBuffer, char * key, bool escaped)
+{
+	size_t			cipherBufSize = base32ToBinaryVector(cipherText, count, NULL, 0);
 	size_t			cipherSize;
 	char *			cipherBuffer = (char *) malloc(cipherBufSize + *cipher_blockSize + 1);
 	size_t			decryptedSize = 0;
@@ -50,17 +59,42 @@ EXPORTED	bool	decryptValue(CipherContext * ctx, char * cipherText, size_t cipher
 
 	resetError();
 
-	cipherSize = base32ToBinary(cipherText, (size_t) -1, (char *) cipherBuffer, cipherBufSize + *cipher_blockSize);
+	cipherSize = base32ToBinaryVector(cipherText, count, (char *) cipherBuffer, cipherBufSize + *cipher_blockSize);
 	
 	localCtx = (ctx ? ctx : CipherContextNew());
 	CipherInit(localCtx, CipherTypeValue, key, cipherBuffer, false);
 
-	verboseMessage(verboseFoundCipherText, cipherText);
+	if (isVerbose()) /* join the cipher-text parts for display */
+	{
+		size_t		textSize = 0;
+		char *		text;
+
+		for (int i = 0; i < count; i++)
+			textSize += cipherText[i].iov_len;
+
+		if ((text = (char *) malloc(textSize + 1)) != NULL)
+		{
+			textSize = 0;
+			for (int i = 0; i < count; i++)
+			{
+				memcpy(text + textSize, cipherText[i].iov_base, cipherText[i].iov_len);
+				textSize += cipherText[i].iov_len;
+			}
+			*(text + textSize) = 0;
+			verboseMessage(verboseFoundCipherText, text);
+			free(text);
+		}
+	}
 
-	if (!(cipherSize % *cipher_blockSize))
+	if (cipherSize < (*cipher_ivLen + *cipher_blockSize)) /* no room for any encrypted data */
+	{
+		setError(DECRYPT_ERR);
+		warningMessageNoApplet(verboseDecryptFailed);
+	}
+	else if (!(cipherSize % *cipher_blockSize))
 		cipherSize++;
 
-	if (CipherUpdate(localCtx, decryptedBuffer, &decryptedSize, cipherBuffer + *cipher_ivLen, cipherSize - *cipher_ivLen))
+	if (!isAnyError() && CipherUpdate(localCtx, decryptedBuffer, &decryptedSize, cipherBuffer + *cipher_ivLen, cipherSize - *cipher_ivLen))
 	{
 		char *		value;
 		size_t		valueSize = 0;
@@ -68,83 +102,13 @@ EXPORTED	bool	decryptValue(CipherContext * ctx, char * cipherText, size_t cipher
 
 		if (digestCheckValue(decryptedBuffer, decryptedSize, &value, &valueSize, &isString))
 		{
-			if (valueSize && escaped)
-			{
-				size_t	start = 0;
-				size_t	extraBufSize = cipherTextSize - valueSize + 4 - 3;
-
-				/*
-					escape processing may result in clear-text values, which are larger than their cipher-text;
-					space available = sizeof(cipherText) - sizeof(clearText) plus four dollar-signs in front of
-					cipherText minus 0xFF and the 16-bit value needed for gap marker; extra characters aren't a
-					problem for output to file, but the output buffer in memory could be too small
-				*/
-
-				if (isString)
-					verboseMessageNoApplet(verboseDecryptedTo, value);
-
-				for (size_t i = 0; i < valueSize; i++)
-				{
-					if (*(value + i) == '\\' || *(value + i) == '"') /* split output */
-					{
-						if (i > start && out && (fwrite((value + start), (i - start), 1, out) != 1)) /* data in front */
-						{
-							setError(WRITE_FAILED);
-							break;
-						}
-
-						if (out && (fwrite("\\", 1, 1, out) != 1)) /* additional backslash as escape */
-						{
-							setError(WRITE_FAILED);
-							break;
-						}
-
-						if (outBuffer) /* copy to memory and append escape character, as long as the space exists */
-						{
-							memcpy(outBuffer, (value + start), (i - start));
-							outBuffer += (i - start);
-							if (--extraBufSize > 0)
-							{
-								*(outBuffer) = '\\';
-								outBuffer++;
-							}
-						}
-
-						start = i;
-					}
-				}
-				valueSize -= start;
-				value += start;
-			}
-
-			if (out && (valueSize > 0) && (fwrite(value, valueSize, 1, out) != 1)) /* no more escapes needed (or wanted) */
-				setError(WRITE_FAILED);
-
-			if (!out && outBuffer) /* copy value and an end-of-value marker */
-			{
+			if (outBuffer) /* copy the raw value */
 				memcpy(outBuffer, value, valueSize);
-				*(outBuffer + valueSize) = '\xFF';
-			}
-
-			if (!isString)
-			{
-				char *	hexBuffer = malloc((valueSize * 2) + 1);
 
-				if (hexBuffer)
-				{
-					binaryToHexadecimal(value, valueSize, hexBuffer, (valueSize * 2) + 1);
-					*(hexBuffer + (valueSize * 2)) = 0;
-					verboseMessageNoApplet(verboseDecryptedToHex, hexBuffer);
-					free(hexBuffer);
-				}
-				else
-				{
-					warningMessageNoApplet(verboseDisplayFailed);
+			if (out)
+				writeDecryptedValue(out, value, valueSize, escaped);
 
-					if (isStrict())
-						setError(WARNING_ISSUED);
-				}
-			}
+			showDecryptedValue(value, valueSize, isString);
 		}
 		else
 		{
@@ -191,120 +155,724 @@ EXPORTED	bool	digestCheckValue(char *buffer, size_t bufferSize, char * *value, s
 	return dataLen;
 }
 
-// decrypt a binary encrypted file (CRYPTEDBINFILE/CRYPTEDB64FILE)
+// display a decrypted value in verbose mode, strings have to be terminated by a NUL character
 
-EXPORTED	bool	decryptFile(char * input, size_t inputSize, FILE * out, char * outBuffer, char * key, bool hexOutput)
+EXPORTED	void	showDecryptedValue(char * value, size_t valueSize, bool isString)
 {
-	char *				decryptedBuffer = malloc(inputSize + *cipher_blockSize);
-	CipherContext *		ctx = CipherContextNew();
-	char *				current = decryptedBuffer;
-	size_t				outSize = 0;
-	size_t				ivLen = *cipher_ivLen;
-	char * 				iv = (char *) malloc(ivLen);
-	size_t				dataSize = 0;
-	size_t				offset = 0;
+	if (!isVerbose())
+		return;
 
-	if (!ctx)
-		return false;
+	if (isString)
+	{
+		verboseMessageNoApplet(verboseDecryptedTo, value);
+	}
+	else
+	{
+		char *	hexBuffer = malloc((valueSize * 2) + 1);
+
+		if (hexBuffer)
+		{
+			binaryToHexadecimal(value, valueSize, hexBuffer, (valueSize * 2) + 1);
+			*(hexBuffer + (valueSize * 2)) = 0;
+			verboseMessageNoApplet(verboseDecryptedToHex, hexBuffer);
+			free(hexBuffer);
+		}
+		else
+		{
+			warningMessageNoApplet(verboseDisplayFailed);
 
-	if (!decryptedBuffer)
+			if (isStrict())
+				setError(WARNING_ISSUED);
+		}
+	}
+}
+
+// write a decrypted value, backslashes and quotation marks may be escaped for the use in quoted strings
+
+EXPORTED	bool	writeDecryptedValue(outputSink_t * out, char * value, size_t valueSize, bool escaped)
+{
+	size_t				start = 0;
+
+	if (valueSize && escaped)
 	{
+		for (size_t i = 0; i < valueSize; i++)
+		{
+			if (*(value + i) == '\\' || *(value + i) == '"') /* split output */
+			{
+				if (!outputSinkWrite(out, value + start, i - start) || /* data in front */
+					!outputSinkWrite(out, "\\", 1)) /* additional backslash as escape */
+					return false;
+
+				start = i;
+			}
+		}
+	}
+
+	return outputSinkWrite(out, value + start, valueSize - start); /* no more escapes needed (or wanted) */
+}
+
+// decrypt a Base32 value into a buffer - the value is returned with its type, nothing is displayed
+
+EXPORTED	bool	decryptValueData(CipherContext * ctx, char * cipherText, size_t cipherTextSize, char * key, char * output, size_t * outputSize, bool * isString)
+{
+	struct iovec	vector = { .iov_base = cipherText, .iov_len = cipherTextSize };
+
+	return decryptValueDataVector(ctx, &vector, 1, key, output, outputSize, isString);
+}
+
+// decrypt a Base32 value, which may be spread over more than one memory span, into a buffer
+
+EXPORTED	bool	decryptValueDataVector(CipherContext * ctx, struct iovec * cipherText, int count, char * key, char * output, size_t * outputSize, bool * isString)
+{
+	size_t			cipherTextSize = 0;
+	size_t			cipherBufSize;
+	size_t			cipherSize;
+	size_t			dataSize;
+	char *			cipherBuffer;
+	char *			decryptedBuffer;
+	size_t			decryptedSize = 0;
+	char *			value;
+	size_t			valueSize = 0;
+	CipherContext *	localCtx = (ctx ? ctx : CipherContextNew());
+	bool			success = false;
+
+	for (int i = 0; i < count; i++)
+		cipherTextSize += cipherText[i].iov_len;
+
+	cipherBufSize = (cipherTextSize / 8) * 5;
+	cipherBuffer = (char *) malloc(cipherBufSize + *cipher_blockSize);
+	decryptedBuffer = (char *) malloc(cipherBufSize + *cipher_blockSize);
+
+	if (cipherBuffer && decryptedBuffer && localCtx)
+	{
+		cipherSize = base32ToBinaryVector(cipherText, count, cipherBuffer, cipherBufSize + *cipher_blockSize);
+
+		if (cipherSize >= (*cipher_ivLen + *cipher_blockSize)) /* the IV is followed by complete blocks, the rest is filler */
+		{
+			dataSize = ((cipherSize - *cipher_ivLen) / *cipher_blockSize) * *cipher_blockSize;
+
+			success = (CipherInit(localCtx, CipherTypeValue, key, cipherBuffer, false) &&
+					   CipherUpdate(localCtx, decryptedBuffer, &decryptedSize, cipherBuffer + *cipher_ivLen, dataSize) &&
+					   decryptedSize >= 8 && digestCheckValue(decryptedBuffer, decryptedSize, &value, &valueSize, isString) &&
+					   (valueSize + 8) <= decryptedSize && valueSize <= *outputSize);
+		}
+
+		if (success)
+		{
+			memcpy(output, value, valueSize);
+			*outputSize = valueSize;
+		}
+		else
+			setError(DECRYPT_ERR);
+	}
+	else
 		setError(NO_MEMORY);
+
+	cipherBuffer = clearMemory(cipherBuffer, cipherBufSize + *cipher_blockSize, true);
+	decryptedBuffer = clearMemory(decryptedBuffer, cipherBufSize + *cipher_blockSize, true);
+
+	if (!ctx && localCtx)
+		localCtx = CipherCleanup(localCtx);
+
+	return success;
+}
+
+// check the key for an encrypted value with its first cipher block only - the context has to use ECB
+// mode and it has to be keyed by the caller, the IV is applied here; the size of the value behind the
+// digest has to fit into the decrypted data and a wrong key passes this test only very rarely
+
+EXPORTED	bool	checkValueKey(CipherContext * ctx, char * cipherText, size_t cipherTextSize)
+{
+	char			binary[((VALUE_CHECK_BASE32_SIZE / 8) * 5)];
+	char			plain[VALUE_CHECK_BLOCK_SIZE];
+	size_t			plainSize = 0;
+	size_t			cipherSize = (cipherTextSize / 8) * 5;
+	size_t			dataSize;
+	size_t			valueSize;
+	bool			success = false;
+
+	if (cipherTextSize < VALUE_CHECK_BASE32_SIZE || cipherSize < (*cipher_ivLen + *cipher_blockSize) ||
+		*cipher_ivLen + *cipher_blockSize > sizeof(binary) || *cipher_blockSize > sizeof(plain))
 		return false;
+
+	if (base32ToBinary(cipherText, VALUE_CHECK_BASE32_SIZE, binary, sizeof(binary)) < (*cipher_ivLen + *cipher_blockSize))
+		return false;
+
+	dataSize = ((cipherSize - *cipher_ivLen) / *cipher_blockSize) * *cipher_blockSize;
+
+	if (CipherUpdate(ctx, plain, &plainSize, binary + *cipher_ivLen, *cipher_blockSize) && plainSize == *cipher_blockSize)
+	{
+		for (size_t i = 0; i < *cipher_blockSize; i++)
+			plain[i] ^= binary[i];
+
+		valueSize = ((size_t) (unsigned char) plain[4] << 24) | ((size_t) (unsigned char) plain[5] << 16) |
+					((size_t) (unsigned char) plain[6] << 8) | (size_t) (unsigned char) plain[7];
+		success = (valueSize + 8 <= dataSize);
 	}
 
-	memset(iv, 0, ivLen);
-	CipherInit(ctx, CipherTypeFile, key, iv, false);
-	outSize = inputSize + *cipher_blockSize;
-	CipherUpdate(ctx, decryptedBuffer, &outSize, input, inputSize + *cipher_blockSize);
-	dataSize += outSize;
-	CipherFinal(ctx, decryptedBuffer, &outSize);
-	dataSize += outSize;
-	CipherCleanup(ctx);
-	offset = (isError(OSSL_CIPHER_ERR) ? 0 : *cipher_keyLen);
-	resetError();
+	clearMemory(plain, sizeof(plain), false);
+
+	return success;
+}
+
+// encrypt a value the same way as FRITZ!OS does it - the digest of the size and the data is stored in
+// front of them, strings get a terminating NUL character and the result is written as Base32 string
+// with the IV in front of the cipher-text - the work buffer may be reused for more values and a missing
+// key keeps the key schedule of the context
+
+static	bool	encryptValueBuffer(CipherContext * ctx, char * value, size_t valueSize, bool isString, char * key, char * iv, char * *buffer, size_t * bufferSize, outputSink_t * out)
+{
+	size_t			dataSize = valueSize + (isString ? 1 : 0);
+	size_t			plainSize = ((8 + dataSize + *cipher_blockSize - 1) / *cipher_blockSize) * *cipher_blockSize;
+	size_t			binarySize = ((*cipher_ivLen + plainSize + 4) / 5) * 5; /* Base32 encodes groups of 5 bytes */
+	size_t			base32Size = (binarySize / 5) * 8;
+	size_t			needed = plainSize + binarySize + base32Size;
+	char *			plain;
+	char *			binary;
+	char *			base32;
+	char			hash[MAX_DIGEST_SIZE];
+	size_t			encryptedSize = 0;
+	bool			success = false;
 
-	current = decryptedBuffer + dataSize - *cipher_blockSize - offset;
-	if (*(current) == 'A' && *(current + 1) == 'V' && *(current + 2) == 'M')
+	if (*bufferSize < needed)
 	{
-		current += 3;
-		for (int i = 0; i < 12 - 3; i++)
+		*buffer = clearMemory(*buffer, *bufferSize, true);
+		*bufferSize = 0;
+
+		if (!(*buffer = (char *) malloc(needed)))
+			returnError(NO_MEMORY, false);
+
+		*bufferSize = needed;
+	}
+
+	plain = *buffer;
+	binary = plain + plainSize;
+	base32 = binary + binarySize;
+
+	memset(plain, 0, plainSize);
+	memset(binary + *cipher_ivLen + plainSize, 0, binarySize - (*cipher_ivLen + plainSize));
+
+	*((unsigned char *) plain + 4) = (dataSize >> 24) & 0xFF;
+	*((unsigned char *) plain + 5) = (dataSize >> 16) & 0xFF;
+	*((unsigned char *) plain + 6) = (dataSize >> 8) & 0xFF;
+	*((unsigned char *) plain + 7) = dataSize & 0xFF;
+	memcpy(plain + 8, value, valueSize);
+	memcpy(binary, iv, *cipher_ivLen);
+
+	if (Digest(plain + 4, plainSize - 4, hash, sizeof(hash)) == 0)
+		setError(OSSL_CIPHER_ERR);
+	else
+	{
+		memcpy(plain, hash, 4);
+
+		if (CipherEncryptInit(ctx, CipherTypeValue, key, binary) &&
+			CipherEncryptUpdate(ctx, binary + *cipher_ivLen, &encryptedSize, plain, plainSize))
 		{
-			if (*(current + i) != 0)
-			{
-				setError(DECRYPT_ERR);
-				break;
-			}
+			base32Size = binaryToBase32(binary, binarySize, base32, base32Size);
+			success = outputSinkWrite(out, base32, base32Size);
 		}
+		else if (!isAnyError())
+			setError(OSSL_CIPHER_ERR);
 	}
+
+	memset(plain, 0, plainSize);
+
+	return success;
+}
+
+// encrypt a single value, a missing IV is created from random data
+
+EXPORTED	bool	encryptValue(CipherContext * ctx, char * value, size_t valueSize, bool isString, char * key, char * iv, outputSink_t * out)
+{
+	char			randomIV[*cipher_ivLen];
+	char *			buffer = NULL;
+	size_t			bufferSize = 0;
+	CipherContext *	localCtx = (ctx ? ctx : CipherContextNew());
+	bool			success = false;
+
+	if (!localCtx)
+		returnError(NO_MEMORY, false);
+
+	if (iv || RandomBytes(randomIV, *cipher_ivLen))
+		success = encryptValueBuffer(localCtx, value, valueSize, isString, key, (iv ? iv : randomIV), &buffer, &bufferSize, out);
 	else
-		setError(DECRYPT_ERR);
+		setError(OSSL_CIPHER_ERR);
 
-	if (!isAnyError())
+	buffer = clearMemory(buffer, bufferSize, true);
+
+	if (!ctx)
+		localCtx = CipherCleanup(localCtx);
+
+	return success;
+}
+
+// encryption of many values with the same key - random IVs are created in batches and the key schedule
+// is computed only once
+
+EXPORTED	valueEncryptor_t *	valueEncryptorNew(char * key)
+{
+	valueEncryptor_t *	encryptor = (valueEncryptor_t *) malloc(sizeof(valueEncryptor_t));
+
+	if (!encryptor)
+		returnError(NO_MEMORY, NULL);
+
+	memset(encryptor, 0, sizeof(valueEncryptor_t));
+
+	if (!(encryptor->ctx = CipherContextNew()) ||
+		!(encryptor->key = (char *) malloc(*cipher_keyLen)) ||
+		!(encryptor->ivs = (char *) malloc(VALUE_ENCRYPT_IV_BATCH * *cipher_ivLen)))
 	{
-		current = decryptedBuffer + dataSize - *cipher_blockSize - offset + 12;
+		encryptor = valueEncryptorFree(encryptor);
+		returnError(NO_MEMORY, NULL);
+	}
+
+	memcpy(encryptor->key, key, *cipher_keyLen);
+	encryptor->ivUsed = VALUE_ENCRYPT_IV_BATCH;
+
+	return encryptor;
+}
+
+EXPORTED	valueEncryptor_t *	valueEncryptorFree(valueEncryptor_t * encryptor)
+{
+	if (encryptor)
+	{
+		if (encryptor->ctx)
+			encryptor->ctx = CipherCleanup(encryptor->ctx);
+		encryptor->key = clearMemory(encryptor->key, *cipher_keyLen, true);
+		encryptor->ivs = clearMemory(encryptor->ivs, VALUE_ENCRYPT_IV_BATCH * *cipher_ivLen, true);
+		encryptor->buffer = clearMemory(encryptor->buffer, encryptor->bufferSize, true);
+		free(encryptor);
+	}
+
+	return NULL;
+}
+
+// encrypt the next value and write its Base32 representation to the output
+
+EXPORTED	bool	valueEncryptorWrite(valueEncryptor_t * encryptor, char * value, size_t valueSize, bool isString, outputSink_t * out)
+{
+	if (encryptor->ivUsed == VALUE_ENCRYPT_IV_BATCH)
+	{
+		if (!RandomBytes(encryptor->ivs, VALUE_ENCRYPT_IV_BATCH * *cipher_ivLen))
+			returnError(OSSL_CIPHER_ERR, false);
+
+		encryptor->ivUsed = 0;
+	}
+
+	if (!encryptValueBuffer(encryptor->ctx, value, valueSize, isString, (encryptor->keyed ? NULL : encryptor->key),
+		encryptor->ivs + (encryptor->ivUsed * *cipher_ivLen), &encryptor->buffer, &encryptor->bufferSize, out))
+		return false;
+
+	memset(encryptor->ivs + (encryptor->ivUsed++ * *cipher_ivLen), 0, *cipher_ivLen); /* each IV is used only once */
+	encryptor->keyed = true;
+	encryptor->count++;
+
+	return true;
+}
+
+// encrypt or decrypt a range of blocks from an encrypted file, blocks are independent of each other in ECB mode
+
+typedef struct {
+	char *				input;
+	char *				output;
+	size_t				size;
+	char *				key;
+	bool				encrypt;
+	bool				failed;
+	bool				threaded;
+	pthread_t			thread;
+} fileCipherJob_t;
+
+static	void *	fileCipherRange(void * context)
+{
+	fileCipherJob_t *	job = (fileCipherJob_t *) context;
+	CipherContext *		ctx = CipherContextNew();
+	char				iv[*cipher_ivLen];
+	size_t				outSize = 0;
+
+	memset(iv, 0, *cipher_ivLen);
+
+	if (!ctx)
+		job->failed = true;
+	else if (job->encrypt)
+		job->failed = (!CipherEncryptInit(ctx, CipherTypeFile, job->key, iv) || !CipherEncryptUpdate(ctx, job->output, &outSize, job->input, job->size));
+	else
+		job->failed = (!CipherInit(ctx, CipherTypeFile, job->key, iv, false) || !CipherUpdate(ctx, job->output, &outSize, job->input, job->size));
+
+	ctx = CipherCleanup(ctx);
+
+	return NULL;
+}
+
+// process all blocks of an encrypted file - large files are split into ranges, which are handled in parallel
+
+static	bool	fileCipherData(char * input, size_t inputSize, char * output, char * key, bool encrypt)
+{
+	size_t				blockSize = *cipher_blockSize;
+	size_t				blocks = inputSize / blockSize;
+	size_t				count = blocks / (FILE_DECRYPT_RANGE_SIZE / blockSize);
+	long				cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	fileCipherJob_t		jobs[EXPORT_MAX_JOBS];
+	bool				failed = false;
+
+	if (cpus > 0 && count > (size_t) cpus)
+		count = cpus;
+	if (count > EXPORT_MAX_JOBS)
+		count = EXPORT_MAX_JOBS;
+	if (count < 1)
+		count = 1;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t			first = (blocks * i) / count;
+		size_t			last = (blocks * (i + 1)) / count;
+
+		jobs[i].input = input + (first * blockSize);
+		jobs[i].output = output + (first * blockSize);
+		jobs[i].size = (last - first) * blockSize;
+		jobs[i].key = key;
+		jobs[i].encrypt = encrypt;
+		jobs[i].failed = false;
+		jobs[i].threaded = (i > 0 && pthread_create(&jobs[i].thread, NULL, &fileCipherRange, &jobs[i]) == 0);
+	}
+
+	for (size_t i = 0; i < count; i++) /* the calling thread handles all ranges without an own thread */
+	{
+		if (jobs[i].threaded)
+			pthread_join(jobs[i].thread, NULL);
+		else
+			fileCipherRange(&jobs[i]);
+
+		failed = (failed || jobs[i].failed);
+	}
+
+	if (count > 1)
+		verboseMessage(verboseFileDecryptJobs, inputSize, count);
+
+	return !failed;
+}
+
+// decrypt the content of an encrypted file (CRYPTEDBINFILE/CRYPTEDB64FILE) into a buffer of the same size
+// and locate the contained data
+
+EXPORTED	bool	decryptFileData(char * input, size_t inputSize, char * output, char * key, char * *data, size_t * dataSize)
+{
+	size_t				blockSize = *cipher_blockSize;
+	char *				trailer;
+	size_t				size;
+
+	if ((inputSize % blockSize) || (inputSize / blockSize) < 2) /* the last two blocks contain the trailer and the padding */
+		returnError(DECRYPT_ERR, false);
 
-		size_t	dataSize =	(*((unsigned char *) current) << 24) +
-							(*((unsigned char *) current + 1) << 16) +
-							(*((unsigned char *) current + 2) << 8) +
-							(*((unsigned char *) current + 3));
+	if (!fileCipherData(input, inputSize, output, key, false))
+		returnError(DECRYPT_ERR, false);
 
-		if (dataSize)
+	/* the trailer is stored in front of the last block: 'AVM', 9 zeros and the size of data */
+
+	trailer = output + inputSize - (2 * blockSize);
+	if (memcmp(trailer, "AVM\0\0\0\0\0\0\0\0\0", 12))
+		returnError(DECRYPT_ERR, false);
+
+	size =	(*((unsigned char *) trailer + 12) << 24) +
+			(*((unsigned char *) trailer + 13) << 16) +
+			(*((unsigned char *) trailer + 14) << 8) +
+			(*((unsigned char *) trailer + 15));
+
+	if (size > (size_t) (trailer - (output + 4))) /* data starts after a 4 byte prefix */
+		returnError(DECRYPT_ERR, false);
+
+	*data = output + 4;
+	*dataSize = size;
+
+	return true;
+}
+
+// encrypt the decrypted content of a file again, all blocks (including prefix, trailer and padding) are
+// used unchanged
+
+EXPORTED	bool	encryptFileData(char * input, size_t inputSize, char * output, char * key)
+{
+	if (inputSize % *cipher_blockSize)
+		returnError(INV_DATA_SIZE, false);
+
+	if (!fileCipherData(input, inputSize, output, key, true))
+		returnError(OSSL_CIPHER_ERR, false);
+
+	return true;
+}
+
+// streaming decryption of a binary encrypted file (CRYPTEDBINFILE/CRYPTEDB64FILE) - the last blocks of
+// decrypted data are held back, until the end of data is known and the trailer can be checked
+
+EXPORTED	fileDecryptor_t *	fileDecryptorNew(char * key, bool hexOutput)
+{
+	fileDecryptor_t *	decryptor = (fileDecryptor_t *) malloc(sizeof(fileDecryptor_t));
+	char				iv[*cipher_ivLen];
+
+	if (!decryptor)
+		returnError(NO_MEMORY, NULL);
+
+	memset(decryptor, 0, sizeof(fileDecryptor_t));
+	memset(iv, 0, *cipher_ivLen);
+
+	decryptor->blockSize = *cipher_blockSize;
+	decryptor->bufferSize = (FILE_DECRYPT_HOLD_BLOCKS * decryptor->blockSize) + FILE_DECRYPT_CHUNK_SIZE;
+	decryptor->written = 4; /* data starts after a 4 byte prefix */
+	decryptor->hexOutput = hexOutput;
+
+	if (!(decryptor->buffer = (char *) malloc(decryptor->bufferSize)) || !(decryptor->partial = (char *) malloc(decryptor->blockSize)))
+	{
+		decryptor = fileDecryptorFree(decryptor);
+		returnError(NO_MEMORY, NULL);
+	}
+
+	if (!(decryptor->ctx = CipherInit(NULL, CipherTypeFile, key, iv, false)))
+		decryptor = fileDecryptorFree(decryptor);
+
+	return decryptor;
+}
+
+EXPORTED	fileDecryptor_t *	fileDecryptorFree(fileDecryptor_t * decryptor)
+{
+	if (!decryptor)
+		return NULL;
+
+	decryptor->ctx = CipherCleanup(decryptor->ctx);
+	decryptor->buffer = clearMemory(decryptor->buffer, decryptor->bufferSize, true);
+	decryptor->partial = clearMemory(decryptor->partial, decryptor->blockSize, true);
+	free(decryptor);
+
+	return NULL;
+}
+
+// write decrypted data starting at the specified position of the decrypted stream, the prefix and data
+// written already are skipped
+
+static	bool	fileDecryptorWrite(fileDecryptor_t * decryptor, char * data, size_t size, size_t position, outputSink_t * out)
+{
+	if (position + size <= decryptor->written)
+		return true;
+
+	if (position < decryptor->written)
+	{
+		data += decryptor->written - position;
+		size -= decryptor->written - position;
+	}
+
+	decryptor->written += size;
+
+	if (!decryptor->hexOutput)
+		return outputSinkWrite(out, data, size);
+
+	while (size > 0)
+	{
+		char			hex[(FILE_DECRYPT_CHUNK_SIZE / 4) * 2 + 1];
+		size_t			chunk = (size > FILE_DECRYPT_CHUNK_SIZE / 4 ? FILE_DECRYPT_CHUNK_SIZE / 4 : size);
+		size_t			hexLen = binaryToHexadecimal(data, chunk, hex, sizeof(hex));
+		char *			writeFrom = wrapOutput(out, &decryptor->charsOnLine, &hexLen, hex);
+
+		if (!writeFrom || isAnyError() || !outputSinkWrite(out, writeFrom, hexLen))
+			return false;
+
+		decryptor->charsOnLine += hexLen;
+		data += chunk;
+		size -= chunk;
+	}
+
+	return true;
+}
+
+// decrypt complete blocks and write all data, which doesn't need to be held back
+
+static	bool	fileDecryptorBlocks(fileDecryptor_t * decryptor, char * input, size_t size, outputSink_t * out)
+{
+	size_t				hold = FILE_DECRYPT_HOLD_BLOCKS * decryptor->blockSize;
+	size_t				outSize = 0;
+
+	if (!CipherUpdate(decryptor->ctx, decryptor->buffer + decryptor->held, &outSize, input, size))
+		return false;
+
+	decryptor->held += size;
+	decryptor->position += size;
+
+	if (decryptor->held > hold)
+	{
+		size_t			release = decryptor->held - hold;
+
+		if (!fileDecryptorWrite(decryptor, decryptor->buffer, release, decryptor->position - decryptor->held, out))
+			return false;
+
+		memmove(decryptor->buffer, decryptor->buffer + release, hold);
+		decryptor->held = hold;
+	}
+
+	return true;
+}
+
+// add more encrypted data, it may end anywhere in a block
+
+EXPORTED	bool	fileDecryptorUpdate(fileDecryptor_t * decryptor, char * input, size_t size, outputSink_t * out)
+{
+	size_t				blockSize = decryptor->blockSize;
+
+	while (size > 0)
+	{
+		if (decryptor->partialSize > 0 || size < blockSize)
 		{
-			if (!hexOutput)
-			{
-				if (out && (fwrite(decryptedBuffer + 4, dataSize, 1, out) != 1))
-					setError(WRITE_FAILED);
+			size_t		missing = blockSize - decryptor->partialSize;
+			size_t		used = (size < missing ? size : missing);
 
-				if (outBuffer)
-					memcpy(outBuffer, decryptedBuffer + 4, dataSize);
-			}
-			else
-			{
-				char *	hexBuffer = malloc((dataSize * 2) + 1);
-				size_t	charsOnLine = 0;
-				size_t	hexLen = 0;
-				char *	writeFrom = NULL;
+			memcpy(decryptor->partial + decryptor->partialSize, input, used);
+			decryptor->partialSize += used;
+			input += used;
+			size -= used;
 
-				if (hexBuffer)
-				{
-					hexLen = binaryToHexadecimal(decryptedBuffer + 4, dataSize, hexBuffer, (dataSize * 2) + 1);
-					*(hexBuffer + hexLen) = 0;
-
-					if (out)
-					{
-						writeFrom = wrapOutput(out, &charsOnLine, &hexLen, hexBuffer);
-						if (hexLen > 0)
-						{
-							if (!isAnyError() && fwrite(writeFrom, hexLen, 1, out) != 1)
-								setError(WRITE_FAILED);
-						}
-						// charsOnLine += hexLen; // unnecessary, charsOnLine runs out of scope soon
-					}
-					else if (outBuffer)
-					{
-						memcpy(outBuffer, hexBuffer, hexLen + 1);
-					}
-
-					free(hexBuffer);
-				}
+			if (decryptor->partialSize == blockSize)
+			{
+				decryptor->partialSize = 0;
+				if (!fileDecryptorBlocks(decryptor, decryptor->partial, blockSize, out))
+					return false;
 			}
 		}
+		else
+		{
+			size_t		chunk = size - (size % blockSize);
+
+			if (chunk > FILE_DECRYPT_CHUNK_SIZE)
+				chunk = FILE_DECRYPT_CHUNK_SIZE;
+
+			if (!fileDecryptorBlocks(decryptor, input, chunk, out))
+				return false;
+
+			input += chunk;
+			size -= chunk;
+		}
 	}
 
-	clearMemory(decryptedBuffer, inputSize, true);
-	clearMemory(iv, ivLen, true);
+	return true;
+}
+
+// check the trailer of an encrypted file in advance - the last two blocks of the file are decrypted
+// on their own, this is possible with ECB mode and nothing needs to be written on a wrong key
 
-	return !isAnyError();
+EXPORTED	bool	fileDecryptorCheckTail(fileDecryptor_t * decryptor, char * tail)
+{
+	char				trailer[2 * decryptor->blockSize];
+	size_t				outSize = 0;
+	bool				valid;
+
+	if (!CipherUpdate(decryptor->ctx, trailer, &outSize, tail, 2 * decryptor->blockSize))
+		return false;
+
+	valid = (memcmp(trailer, "AVM\0\0\0\0\0\0\0\0\0", 12) == 0);
+	clearMemory(trailer, sizeof(trailer), false);
+
+	if (!valid)
+		returnError(DECRYPT_ERR, false);
+
+	return true;
+}
+
+// check the trailer (it's stored in front of the last block: 'AVM', 9 zeros and the size of data) and
+// write the remaining data
+
+EXPORTED	bool	fileDecryptorFinish(fileDecryptor_t * decryptor, outputSink_t * out)
+{
+	size_t				blockSize = decryptor->blockSize;
+	size_t				start = decryptor->position - decryptor->held; /* position of held data */
+	char *				trailer;
+	size_t				end;
+
+	if (decryptor->partialSize > 0 || decryptor->position < (2 * blockSize) + 4)
+		returnError(DECRYPT_ERR, false);
+
+	trailer = decryptor->buffer + decryptor->held - (2 * blockSize);
+
+	if (memcmp(trailer, "AVM\0\0\0\0\0\0\0\0\0", 12))
+		returnError(DECRYPT_ERR, false);
+
+	end =	(*((unsigned char *) trailer + 12) << 24) +
+			(*((unsigned char *) trailer + 13) << 16) +
+			(*((unsigned char *) trailer + 14) << 8) +
+			(*((unsigned char *) trailer + 15));
+	end += 4;
+
+	if (end < decryptor->written || end > decryptor->position - (2 * blockSize)) /* size doesn't match the held back data */
+		returnError(DECRYPT_ERR, false);
+
+	return fileDecryptorWrite(decryptor, decryptor->buffer, end - start, start, out);
 }
 
 EXPORTED	bool	keyFromDevice(char * hash, size_t * hashSize, bool forExport)
 {
-	memoryBuffer_t *	env = getEnvironmentFile();
+	environment_t *		env;
+	char *				path;
+	char *				data;
+	size_t				size = 0;
+	char				name[64];
+	bool				success;
+
+	if (!getKeyCacheTimeout())
+	{
+		if (!(env = getEnvironment()))
+			return false;
+
+		return keyFromEnvironment(env, hash, hashSize, forExport);
+	}
+
+	/* the key may be found in the kernel keyring, only the digest of the environment is needed then */
+
+	if (!(path = getEnvironmentPath()))
+		returnError(NO_MEMORY, false);
+
+	data = environmentRead(path, &size);
+	free(path);
 
-	if (!env)
+	if (!data)
 		return false;
 
+	if (!keyCacheName(name, sizeof(name), data, size, forExport))
+	{
+		clearMemory(data, size + 1, true);
+		return false;
+	}
+
+	if (keyCacheLookup(name, hash, *digest_blockSize))
+	{
+		clearMemory(data, size + 1, true);
+		*hashSize = *digest_blockSize;
+		verboseMessage(verboseKeyFromCache, name);
+		return true;
+	}
+
+	if (!(env = environmentParse(data, size)))
+	{
+		clearMemory(data, size + 1, true);
+		return false;
+	}
+
+	if ((success = keyFromEnvironment(env, hash, hashSize, forExport)))
+	{
+		if (keyCacheStore(name, hash, *hashSize))
+		{
+			verboseMessage(verboseKeyCached, name, getKeyCacheTimeout());
+		}
+		else
+		{
+			verboseMessage(verboseKeyNotCached);
+		}
+	}
+
+	env = environmentFree(env);
+
+	return success;
+}
+
+// compute the key from the properties in an environment, more than one environment may be loaded to
+// get the keys of other devices
+
+EXPORTED	bool	keyFromEnvironment(environment_t * env, char * hash, size_t * hashSize, bool forExport)
+{
 	DigestContext	 	*ctx = DigestInit();
 
 	struct variables {
@@ -325,7 +893,7 @@ EXPORTED	bool	keyFromDevice(char * hash, size_t * hashSize, bool forExport)
 
 	while (var && var->name)
 	{
-		char *			value = getEnvironmentValue(env, var->name);
+		char *			value = environmentValue(env, var->name);
 
 		if (value)
 		{
@@ -361,8 +929,6 @@ EXPORTED	bool	keyFromDevice(char * hash, size_t * hashSize, bool forExport)
 			break;
 	}
 
-	env = memoryBufferFreeChain(env);
-
 	if (!isAnyError())
 	{
 		*hashSize = *digest_blockSize;
@@ -495,6 +1061,125 @@ EXPORTED	bool	keyFromProperties(char * hash, size_t * hashSize, char * serial, c
 	return !isAnyError();
 }
 
+// compute the key for secrets in configuration files from command line arguments - without arguments the
+// running device is used, a single argument is a hexadecimal key and otherwise the properties of another
+// device have to be specified
+
+EXPORTED	bool	keyFromArguments(char * key, char * serial, char * maca, char * wlanKey, char * tr069Passphrase, bool altEnv)
+{
+	char 				hash[MAX_DIGEST_SIZE];
+	size_t				hashLen = sizeof(hash);
+	char				hex[(MAX_DIGEST_SIZE * 2) + 1];
+	size_t				hexLen;
+
+	memset(key, 0, *cipher_keyLen);
+
+	if (serial && altEnv)
+	{
+		warningMessage(verboseAltEnvIgnored);
+		if (isStrict())
+			return false;
+	}
+
+	if (!serial) /* use device properties from running system */
+	{
+		if (altEnv)
+			verboseMessage(verboseAltEnv, getEnvironmentPath());
+
+		if (!keyFromDevice(hash, &hashLen, false))
+			return false; /* error message was displayed from called function */
+
+		memcpy(key, hash, *cipher_ivLen);
+		hexLen = binaryToHexadecimal(hash, hashLen, hex, sizeof(hex));
+		hex[hexLen] = 0;
+		verboseMessage(verboseDeviceKeyHash, hex);
+	}
+	else if (!maca) /* single argument - assume it's a hexadecimal key already */
+	{
+		if (strlen(serial) != 32)
+		{
+			errorMessage(errorWrongHexKeyLength, serial);
+			return false;
+		}
+
+		hexadecimalToBinary(serial, strlen(serial), key, *cipher_keyLen);
+
+		if (isAnyError())
+		{
+			errorMessage(errorInvalidKeyValue, serial);
+			return false;
+		}
+
+		verboseMessage(verboseUsingKey, serial);
+	}
+	else if (!wlanKey) /* serial and maca - use an export key from device */
+	{
+		errorMessage(errorDeviceProperties, URLADER_SERIAL_NAME, URLADER_MACA_NAME, URLADER_WLANKEY_NAME);
+		return false;
+	}
+	else
+	{
+		verboseMessage(verboseSerialUsed, serial);
+		verboseMessage(verboseMACUsed, maca);
+		verboseMessage(verboseWLANKeyUsed, wlanKey);
+		if (tr069Passphrase)
+			verboseMessage(verboseTR069PPUsed, tr069Passphrase);
+
+		if (!keyFromProperties(hash, &hashLen, serial, maca, wlanKey, tr069Passphrase))
+			return false;
+
+		memcpy(key, hash, *cipher_ivLen);
+		hexLen = binaryToHexadecimal(hash, hashLen, hex, sizeof(hex));
+		hex[hexLen] = 0;
+		verboseMessage(verboseUsingKey, hex);
+	}
+
+	clearMemory(hash, sizeof(hash), false);
+
+	return true;
+}
+
+// compute the key for the first stage of an export file from a password or from device properties, a
+// missing serial number selects the properties of the running device
+
+EXPORTED	bool	exportKeyFromArguments(char * key, char * password, char * serial, char * maca, bool altEnv)
+{
+	char 				hash[MAX_DIGEST_SIZE];
+	size_t				hashLen = sizeof(hash);
+	char				hex[(MAX_DIGEST_SIZE * 2) + 1];
+	size_t				hexLen;
+
+	if (password)
+	{
+		verboseMessage(verbosePasswordUsed, password);
+		if ((hashLen = Digest(password, strlen(password), hash, hashLen)) == 0)
+			return false;
+	}
+	else if (serial && maca)
+	{
+		verboseMessage(verboseSerialUsed, serial);
+		verboseMessage(verboseMACUsed, maca);
+		if (!keyFromProperties(hash, &hashLen, serial, maca, NULL, NULL))
+			return false;
+	}
+	else
+	{
+		altenv_verbose_message();
+		if (!keyFromDevice(hash, &hashLen, true))
+			return false;
+	}
+
+	memset(key, 0, *cipher_keyLen);
+	memcpy(key, hash, *cipher_ivLen);
+
+	hexLen = binaryToHexadecimal(hash, hashLen, hex, sizeof(hex));
+	hex[hexLen] = 0;
+	verboseMessage(verboseUsingKey, hex);
+	clearMemory(hash, sizeof(hash), false);
+
+	return true;
+}
+
 EXPORTED	bool	privateKeyPassword(char * out, size_t * outLen, char * maca)
 {
 	char *				value = maca;
@@ -510,7 +1195,7 @@ EXPORTED	bool	privateKeyPassword(char * out, size_t * outLen, char * maca)
 
 	if (!value)
 	{
-		value = getEnvironmentValue(NULL, URLADER_MACA_NAME);
+		value = environmentValue(getEnvironment(), URLADER_MACA_NAME);
 
 		if (!value)
 		{
@@ -37,17 +37,80 @@
 
 #define	PRIVKEY_PASSWORD_SIZE	8
 
-// decrytion related functions
+// the first cipher block of a value (behind the IV) is contained in this number of Base32 characters
+
+#define	VALUE_CHECK_BASE32_SIZE	56
+#define	VALUE_CHECK_BLOCK_SIZE	16
+
+// encrypted files from this size on are decrypted by more than one thread
+
+#define	FILE_DECRYPT_RANGE_SIZE	(256 * 1024)
+
+// streaming decryption of encrypted files - the trailer and the padding occupy the last two blocks, the
+// data ends within the block in front of them
+
+#define	FILE_DECRYPT_CHUNK_SIZE		4096
+#define	FILE_DECRYPT_HOLD_BLOCKS	3
+
+typedef struct {
+	CipherContext *		ctx;
+	size_t				blockSize;
+	char *				buffer;			/* held back data and room for a decrypted chunk */
+	size_t				bufferSize;
+	size_t				held;
+	char *				partial;		/* incomplete block from input */
+	size_t				partialSize;
+	size_t				position;		/* size of decrypted data */
+	size_t				written;		/* end of data written to output */
+	bool				hexOutput;
+	size_t				charsOnLine;
+} fileDecryptor_t;
+
+// encryption of many values with the same key, random IVs are read in batches
+
+#define	VALUE_ENCRYPT_IV_BATCH		256
+
+typedef struct valueEncryptor {
+	CipherContext *		ctx;
+	char *				key;
+	bool				keyed;			/* key schedule was set up already */
+	char *				ivs;
+	size_t				ivUsed;
+	char *				buffer;			/* work buffer, it's reused for all values */
+	size_t				bufferSize;
+	size_t				count;
+} valueEncryptor_t;
+
+// encryption and decrytion related functions
 
 void	encryptionInit(void);
 
 bool	digestCheckValue(char *buffer, size_t bufferSize, char * *value, size_t * dataLen, bool * string);
 
-bool	decryptValue(CipherContext * ctx, char * cipherText, size_t cipherTextSize, FILE * out, char * outBuffer, char * key, bool escaped);
-bool	decryptFile(char * input, size_t inputSize, FILE * out, char * outBuffer, char * key, bool hexOutput);
+bool	decryptValueVector(CipherContext * ctx, struct iovec * cipherText, int count, outputSink_t * out, char * outBuffer, char * key, bool escaped);
+bool	decryptValue(CipherContext * ctx, char * cipherText, size_t cipherTextSize, outputSink_t * out, char * outBuffer, char * key, bool escaped);
+void	showDecryptedValue(char * value, size_t valueSize, bool isString);
+bool	writeDecryptedValue(outputSink_t * out, char * value, size_t valueSize, bool escaped);
+bool	decryptValueData(CipherContext * ctx, char * cipherText, size_t cipherTextSize, char * key, char * output, size_t * outputSize, bool * isString);
+bool	decryptValueDataVector(CipherContext * ctx, struct iovec * cipherText, int count, char * key, char * output, size_t * outputSize, bool * isString);
+bool	checkValueKey(CipherContext * ctx, char * cipherText, size_t cipherTextSize);
+bool	encryptValue(CipherContext * ctx, char * value, size_t valueSize, bool isString, char * key, char * iv, outputSink_t * out);
+valueEncryptor_t *	valueEncryptorNew(char * key);
+valueEncryptor_t *	valueEncryptorFree(valueEncryptor_t * encryptor);
+bool	valueEncryptorWrite(valueEncryptor_t * encryptor, char * value, size_t valueSize, bool isString, outputSink_t * out);
+fileDecryptor_t *	fileDecryptorNew(char * key, bool hexOutput);
+fileDecryptor_t *	fileDecryptorFree(fileDecryptor_t * decryptor);
+bool	fileDecryptorUpdate(fileDecryptor_t * decryptor, char * input, size_t size, outputSink_t * out);
+bool	fileDecryptorCheckTail(fileDecryptor_t * decryptor, char * tail);
+bool	fileDecryptorFinish(fileDecryptor_t * decryptor, outputSink_t * out);
+bool	decryptFileData(char * input, size_t inputSize, char * output, char * key, char * *data, size_t * dataSize);
+bool	encryptFileData(char * input, size_t inputSize, char * output, char * key);
 
 bool	keyFromDevice(char * hash, size_t * hashSize, bool forExport);
+bool	keyFromEnvironment(environment_t * env, char * hash, size_t * hashSize, bool forExport);
 bool	keyFromProperties(char * hash, size_t * hashSize, char * serial, char * maca, char * wlanKey, char * tr069Passphrase);
+bool	keyFromArguments(char * key, char * serial, char * maca, char * wlanKey, char * tr069Passphrase, bool altEnv);
+bool	exportKeyFromArguments(char * key, char * password, char * serial, char * maca, bool altEnv);
 
 bool	privateKeyPassword(char * out, size_t * outLen, char * maca);
 
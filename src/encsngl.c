@@ -0,0 +1,164 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+#define ENCSNGL_C
+
+#include "common.h"
+#include "encsngl_usage.c"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+static	char *				__commandNames[] = {
+#include "encsngl_commands.c"
+		NULL
+};
+static	char * *			commandNames = &__commandNames[0];
+static	commandEntry_t 		__encsngl_command = { .names = &commandNames, .ep = &encsngl_entry, .usage = &encsngl_usage, .short_desc = &encsngl_shortdesc, .usesCrypto = true, .finalNewlineOnTTY = true };
+EXPORTED commandEntry_t *	encsngl_command = &__encsngl_command;
+
+// 'encrypt_secret' function - encrypt the specified clear-text value with a hexadecimal key
+
+int		encsngl_entry(int argc, char** argv, int argo, commandEntry_t * entry)
+{
+	bool				hexInput = false;
+	bool				dollarSigns = false;
+	char *				secret = NULL;
+	char *				keyString = NULL;
+
+	if (argc > argo + 1)
+	{
+		int				opt;
+		int				optIndex = 0;
+
+		static struct option options_long[] = {
+			{ "hex-input", no_argument, NULL, 'x' },
+			{ "dollar-signs", no_argument, NULL, 'd' },
+			verbosity_options_long,
+			options_long_end,
+		};
+		char *			options_short = ":" "xd" verbosity_options_short;
+
+		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
+		{
+			switch (opt)
+			{
+				case 'x':
+					hexInput = true;
+					break;
+
+				case 'd':
+					dollarSigns = true;
+					break;
+
+				check_verbosity_options_short();
+				help_option();
+				getopt_invalid_option();
+				invalid_option(opt);
+			}
+		}
+		if (argc > argo + optind)
+			secret = argv[argo + optind];
+		if (argc > argo + optind + 1)
+			keyString = argv[argo + optind + 1];
+		if (argc > argo + optind + 2)
+			warnAboutExtraArguments(argv, argo + optind + 2);
+	}
+
+	if (!secret || !keyString)
+	{
+		errorMessage(errorMissingArguments);
+		__autoUsage();
+		return EXIT_FAILURE;
+	}
+
+	if (isAnyError())
+		return EXIT_FAILURE;
+
+	resetError();
+
+	CipherSizes();
+
+	char				key[*cipher_keyLen];
+	size_t				keySize;
+	size_t				secretSize = strlen(secret);
+	char *				value = secret;
+	size_t				valueSize = secretSize;
+
+	memset(key, 0, *cipher_keyLen);
+
+	if (strlen(keyString) != 32 && strlen(keyString) != 64)
+	{
+		errorMessage(errorWrongKeySize);
+		return EXIT_FAILURE;
+	}
+
+	keySize = hexadecimalToBinary(keyString, strlen(keyString), key, *cipher_keyLen);
+
+	if (isAnyError() || (keySize != 16 && keySize != 32))
+	{
+		errorMessage(errorInvalidKeyValue, keyString);
+		clearMemory(key, *cipher_keyLen, false);
+		return EXIT_FAILURE;
+	}
+
+	verboseMessage(verboseUsingKey, keyString);
+
+	if (hexInput) /* binary data, it's stored without a terminating NUL character */
+	{
+		if (!(value = (char *) malloc((secretSize / 2) + 1)))
+		{
+			errorMessage(errorNoMemory);
+			clearMemory(key, *cipher_keyLen, false);
+			return EXIT_FAILURE;
+		}
+
+		valueSize = hexadecimalToBinary(secret, secretSize, value, (secretSize / 2) + 1);
+
+		if (isAnyError())
+		{
+			errorMessage(errorInvalidArgumentData);
+			value = clearMemory(value, (secretSize / 2) + 1, true);
+			clearMemory(key, *cipher_keyLen, false);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (dollarSigns)
+		outputSinkWrite(outputStdout(), "$$$$", 4);
+
+	if (!isAnyError() && !encryptValue(NULL, value, valueSize, !hexInput, key, NULL, outputStdout()))
+	{
+		errorMessage(errorEncryptionFailed);
+	}
+
+	if (!outputClose())
+		errorMessage(errorWriteFailed);
+
+	if (hexInput)
+		value = clearMemory(value, (secretSize / 2) + 1, true);
+	clearMemory(key, *cipher_keyLen, false);
+
+	return (isAnyError() ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+// display usage help
+
+void 	encsngl_usage(const bool help, UNUSED const bool version)
+{
+	FILE *	out = (help || version ? stdout : stderr);
+
+	showUsageHeader(out, help, version);
+
+	if (version)
+	{
+		fprintf(out, "\n");
+		return;
+	}
+
+	showPurposeHeader(out);
+	fprintf(out,
+		"This program takes a clear-text value and a hexadecimal key and encrypts the value the same way as\n"
+		"FRITZ!OS does it. The Base32 encoded cipher-text will be written to STDOUT.\n"
+	);
+
+	showFormatHeader(out);
+	addSpace();
+	addOption("options");
+	addSpace();
+	endOptions();
+	addSpace();
+	addArgument("clear-text");
+	addSpace();
+	addArgument("key");
+	showFormatEnd(out);
+
+	showOptionsHeader("options");
+	addOptionsEntry("-x, --hex-input", "the clear-text is a hexadecimal string for binary data", 0);
+	addOptionsEntry("-d, --dollar-signs", "write four dollar-signs in front of the cipher-text", 0);
+	addOptionsEntryVerbose();
+	addOptionsEntryQuiet();
+	addOptionsEntryStrict();
+	addOptionsEntryHelp();
+	addOptionsEntryVersion();
+	showOptionsEnd(out);
+
+	fprintf(out,
+		"\nThe %s argument is a hexadecimal string for the encryption key to use and it has to contain 64 or\n"
+		"32 characters; values with 32 characters are padded with zeros to a 256-bit key.\n",
+		showUndl("key")
+	);
+
+	fprintf(out,
+		"\nThe %s is encrypted as string with a terminating NUL character. If the option '--hex-input'\n"
+		"(or '-x') was specified, it's decoded from its hexadecimal representation first and the binary data\n"
+		"is encrypted without a NUL character. Each call uses a new random IV, the cipher-text differs from\n"
+		"call to call for the same value.\n",
+		showUndl("clear-text")
+	);
+
+	showUsageFinalize(out, help, version);
+}
+
+char *	encsngl_shortdesc(void)
+{
+	return "encrypt a value with a specified AES key";
+}
@@ -27,15 +27,17 @@
 #pragma GCC diagnostic ignored "-Wformat-nonliteral"
 #pragma GCC diagnostic ignored "-Wformat-security"
 
-// environment file name
+// environment file name and the parsed content of this file
 
 static	char *			environmentFileName = URLADER_ENV_PATH;
+static	environment_t *	environmentCurrent = NULL;
 
-// get/set environment file name
+// get/set environment file name, the content of a previous file is dropped
 
 EXPORTED	void	setEnvironmentPath(char * path)
 {
 	environmentFileName = strdup(path);
+	environmentCurrent = environmentFree(environmentCurrent);
 }
 
 EXPORTED	char *	getEnvironmentPath(void)
@@ -43,79 +45,201 @@ EXPORTED	char *	getEnvironmentPath(void)
 	return strdup(environmentFileName);
 }
 
-EXPORTED	memoryBuffer_t *	getEnvironmentFile(void)
+// sort entries by name, equal names keep their order from the file
+
+static	int		compareEnvironmentEntries(const void * left, const void * right)
 {
-	FILE *				environment = fopen(environmentFileName, "r");
+	environmentEntry_t *	leftEntry = (environmentEntry_t *) left;
+	environmentEntry_t *	rightEntry = (environmentEntry_t *) right;
+	int					result = strcmp(leftEntry->name, rightEntry->name);
 
-	if (!environment)
-	{
-		errorMessage(errorOpeningEnvironment, environmentFileName);
-		setError(URLADER_ENV_ERR);
-		return NULL;
-	}
+	if (result)
+		return result;
 
-	// 2 KByte are usually enough room for an environment ... if it's
-	// really too small, consolidation takes place later
+	return (leftEntry->name < rightEntry->name ? -1 : (leftEntry->name > rightEntry->name ? 1 : 0));
+}
 
-	memoryBuffer_t *	env = memoryBufferReadFile(environment, 2048);
+// build the index for environment data - each line contains a name and a value, separated by the
+// first tabulator, lines without a value are ignored; the data is owned by the environment afterwards and
+// it's cleared on release, including the terminating NUL character behind it
 
-	fclose(environment);
+EXPORTED	environment_t *	environmentParse(char * data, size_t size)
+{
+	environment_t *		env = (environment_t *) malloc(sizeof(environment_t));
+	char *				line = data;
+	char *				end = data + size;
+	size_t				lines = 0;
 
 	if (!env)
+		returnError(NO_MEMORY, NULL);
+
+	env->data = data;
+	env->size = size;
+	env->entries = NULL;
+	env->count = 0;
+
+	for (char * next = data; next < end && (next = memchr(next, '\n', end - next)) != NULL; next++)
+		lines++;
+
+	if (!(env->entries = (environmentEntry_t *) malloc((lines + 1) * sizeof(environmentEntry_t))))
 	{
-		errorMessage(errorReadingEnvironment, environmentFileName);
-		setError(URLADER_ENV_ERR);
-		return false;
+		free(env);
+		returnError(NO_MEMORY, NULL);
 	}
 
-	if (env->next)
+	*(data + size) = 0; /* the caller has to provide room for the last terminator */
+
+	while (line < end)
 	{
-		memoryBuffer_t	*new = memoryBufferConsolidateData(env);
-		memoryBufferFreeChain(env);
-		env = new;
-	}
+		char *			newline = memchr(line, '\n', end - line);
+		char *			tab;
 
-	size_t				offset = 0;
+		if (!newline)
+			newline = end;
 
-	// replace newlines with end of strings for easier access
+		*newline = 0;
 
-	while (offset < env->used)
-	{
-		if (*(env->data + offset) == '\n')
-			*(env->data + offset) = 0;
-		offset++;
+		if ((tab = memchr(line, '\t', newline - line)) != NULL)
+		{
+			*tab = 0;
+			env->entries[env->count].name = line;
+			env->entries[env->count].value = tab + 1;
+			env->count++;
+		}
+
+		line = newline + 1;
 	}
 
+	qsort(env->entries, env->count, sizeof(environmentEntry_t), &compareEnvironmentEntries);
+
 	return env;
 }
 
-EXPORTED	char *	getEnvironmentValue(memoryBuffer_t * environ, char * name)
-{
-	memoryBuffer_t *	env = (environ ? environ : getEnvironmentFile());
+// read an environment file with as few system calls as possible, the size of the file from procfs is
+// unknown in advance - the buffer has room for a terminating NUL character
 
-	if (!env)
-		return NULL;
+EXPORTED	char *	environmentRead(const char * path, size_t * dataSize)
+{
+	int					fd = open(path, O_RDONLY | O_CLOEXEC);
+	struct stat			st;
+	char *				data = NULL;
+	size_t				size = 2048; /* usually enough room for an environment */
+	size_t				used = 0;
+	ssize_t				count = 0;
+
+	if (fd < 0)
+	{
+		errorMessage(errorOpeningEnvironment, path);
+		returnError(URLADER_ENV_ERR, NULL);
+	}
 
-	char *		current = env->data;
-	char *		value = NULL;
+	if (fstat(fd, &st) == 0 && st.st_size > 0 && (size_t) st.st_size >= size)
+		size = st.st_size + 1;
 
-	while (current < (env->data + env->used))
+	while (true)
 	{
-		if (!strncmp(current, name, strlen(name)))
+		if (!data || used + 1 == size) /* room for the terminator is kept */
 		{
-			if (*(current + strlen(name)) == '\t')
+			char *		grown = (char *) realloc(data, (data ? size * 2 : size));
+
+			if (!grown)
 			{
-				value = strdup(current + strlen(name) + 1);
+				count = -1;
 				break;
 			}
+
+			size = (data ? size * 2 : size);
+			data = grown;
 		}
-		current += strlen(current) + 1;
+
+		if ((count = read(fd, data + used, size - used - 1)) < 0 && errno == EINTR)
+			continue;
+
+		if (count <= 0)
+			break;
+
+		used += count;
+	}
+
+	close(fd);
+
+	if (count < 0)
+	{
+		if (data)
+			free(data);
+		errorMessage(errorReadingEnvironment, path);
+		returnError(URLADER_ENV_ERR, NULL);
 	}
 
-	if (!environ)
-		memoryBufferFreeChain(env);
+	*dataSize = used;
+
+	return data;
+}
+
+// read and parse an environment file
+
+EXPORTED	environment_t *	environmentLoad(const char * path)
+{
+	size_t				size = 0;
+	char *				data = environmentRead(path, &size);
+	environment_t *		env;
+
+	if (!data)
+		return NULL;
+
+	if (!(env = environmentParse(data, size)))
+		clearMemory(data, size + 1, true);
+
+	return env;
+}
+
+// release an environment, its data contains secrets like WLAN keys and it's cleared
+
+EXPORTED	environment_t *	environmentFree(environment_t * env)
+{
+	if (env)
+	{
+		if (env->entries)
+			clearMemory(env->entries, env->count * sizeof(environmentEntry_t), true);
+		if (env->data)
+			clearMemory(env->data, env->size + 1, true);
+		free(env);
+	}
+
+	return NULL;
+}
+
+// look up a value by name, the result points into the environment and must not be freed
+
+EXPORTED	char *	environmentValue(environment_t * env, const char * name)
+{
+	size_t				low = 0;
+	size_t				high = (env ? env->count : 0);
+
+	while (low < high) /* the first entry with this name is found */
+	{
+		size_t			middle = low + (high - low) / 2;
+
+		if (strcmp(env->entries[middle].name, name) < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	if (env && low < env->count && strcmp(env->entries[low].name, name) == 0)
+		return env->entries[low].value;
+
+	return NULL;
+}
+
+// the environment from the current path, it's loaded only once
+
+EXPORTED	environment_t *	getEnvironment(void)
+{
+	if (!environmentCurrent)
+		environmentCurrent = environmentLoad(environmentFileName);
 
-	return value;
+	return environmentCurrent;
 }
 
 #pragma GCC diagnostic pop
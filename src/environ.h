@@ -29,12 +29,30 @@
 
 #define	URLADER_ENV_PATH		DECODER_CONFIG_URLADER_ENVIRONMENT_PATH
 
+// parsed environment, the entries are sorted by name
+
+typedef struct environmentEntry {
+	char *				name;
+	char *				value;
+} environmentEntry_t;
+
+typedef struct environment {
+	char *				data;
+	size_t				size;
+	environmentEntry_t *	entries;
+	size_t				count;
+} environment_t;
+
 // environment file functions
 
 char *				getEnvironmentPath(void);
 void				setEnvironmentPath(char * path);
 
-memoryBuffer_t *	getEnvironmentFile(void);
-char *				getEnvironmentValue(memoryBuffer_t * environ, char * name);
+environment_t *		environmentParse(char * data, size_t size);
+char *				environmentRead(const char * path, size_t * dataSize);
+environment_t *		environmentLoad(const char * path);
+environment_t *		environmentFree(environment_t * env);
+char *				environmentValue(environment_t * env, const char * name);
+environment_t *		getEnvironment(void);
 
 #endif
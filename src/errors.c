@@ -23,10 +23,9 @@
 
 #include "common.h"
 
-// global error state
+// error state - each thread has its own one, a failure within a worker doesn't affect others
 
-static decoder_error_t		__decoder_error__ = DECODER_ERROR_NOERROR;
-UNUSED decoder_error_t *	__decoder_error = &__decoder_error__;
+__thread decoder_error_t	__decoder_error__ = DECODER_ERROR_NOERROR;
 
 // global error descriptions
 
@@ -101,11 +100,32 @@ EXPORTED	char *			errorReadFromTTY = "STDIN is connected to a terminal device, e
 EXPORTED	char *			errorNoReadFromTTY = "STDIN is connected to a terminal device, execution aborted.\n";
 EXPORTED	char *			errorWrongMACAddress = "The specified MAC address '%s' has a wrong format.\n";
 EXPORTED	char *			errorInvalidBufferSize = "The specified buffer size value '%s' is invalid.\n";
+EXPORTED	char *			errorInvalidKeyCacheTimeout = "The specified time '%s' for the key cache is invalid.\n";
 EXPORTED	char *			errorConflictingOptions = "Conflicting options found.\n";
 EXPORTED	char *			errorEmptyInputFile = "There's no input data present.\n";
-EXPORTED	char *			errorNoConsolidate = "Checksum computation needs input buffer consolidation.\n";
 EXPORTED	char *			errorMissingDirectoryName = "Missing directory name after 'output-directory' (or 'o') option or the option wasn't specified.\n";
+EXPORTED	char *			errorMissingInputDirectoryName = "Missing directory name after 'input-directory' (or 'i') option or the option wasn't specified.\n";
 EXPORTED	char *			errorInvalidDirectoryName = "The specified directory name '%s' is invalid (not a directory or does not exist).\n";
+EXPORTED	char *			errorInvalidJobCount = "The specified number of parallel jobs '%s' is invalid.\n";
+EXPORTED	char *			errorOpeningInputFile = "Error opening input file '%s'.\n";
+EXPORTED	char *			errorInvalidDictionaryEntry = "Invalid entry '%s' found in dictionary file.\n";
+EXPORTED	char *			errorMissingDictionary = "The directory '%s' doesn't contain a dictionary and header file.\n";
+EXPORTED	char *			errorNoExportFile = "The file '%s' isn't an export file, its end marker is missing.\n";
+EXPORTED	char *			errorChecksumNotReplaced = "Error replacing the checksum in file '%s'.\n";
+EXPORTED	char *			errorSectionNotFound = "The export file doesn't contain a file named '%s'.\n";
+EXPORTED	char *			errorMissingTargetKey = "Missing target key, specify a password or a serial number and a MAC address for the target device.\n";
+EXPORTED	char *			errorEncryptionFailed = "Encryption failed with the specified target key.\n";
+EXPORTED	char *			errorOpeningOutputFile = "Error opening output file '%s'.\n";
+EXPORTED	char *			errorInvalidTffsImage = "The data on STDIN isn't a TFFS image, no segment was found.\n";
+EXPORTED	char *			errorInvalidOutputFormat = "The specified output format '%s' is invalid, use 'text' or 'ndjson'.\n";
+EXPORTED	char *			errorConfigSyntax = "Syntax error in line %lu of the configuration file.\n";
+EXPORTED	char *			errorInvalidConfigPath = "The specified path '%s' is invalid.\n";
+EXPORTED	char *			errorMissingConfigPath = "Missing path after 'path' (or 'p') option or the option wasn't specified.\n";
+EXPORTED	char *			errorInvalidKeyNames = "The specified list of names '%s' is invalid.\n";
+EXPORTED	char *			errorTooManyKeys = "At most %u keys may be specified.\n";
+EXPORTED	char *			errorMissingPatternOrFiles = "The pattern to search for and at least one file name are needed.\n";
+EXPORTED	char *			errorInvalidRegex = "The specified pattern '%s' isn't a valid regular expression.\n";
+EXPORTED	char *			errorMissingExportFiles = "The names of both export files are needed.\n";
 EXPORTED	char *			errorUnexpectedIOError = "Unexpected I/O error (errno=%d) encountered while calling '%s' on '%s' stream.\n";
 //// end ////
 
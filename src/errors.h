@@ -88,9 +88,9 @@ typedef enum {
 
 extern char *							*__decoder_error_text;
 
-// global error state
+// error state of the calling thread
 
-extern decoder_error_t *				__decoder_error;
+extern __thread decoder_error_t			__decoder_error__;
 
 // error messages
 
@@ -132,11 +132,32 @@ extern	char *							errorReadFromTTY;
 extern	char *							errorNoReadFromTTY;
 extern	char *							errorWrongMACAddress;
 extern	char *							errorInvalidBufferSize;
+extern	char *							errorInvalidKeyCacheTimeout;
 extern	char *							errorConflictingOptions;
 extern	char *							errorEmptyInputFile;
-extern	char *							errorNoConsolidate;
 extern	char *							errorMissingDirectoryName;
+extern	char *							errorMissingInputDirectoryName;
 extern	char *							errorInvalidDirectoryName;
+extern	char *							errorInvalidJobCount;
+extern	char *							errorOpeningInputFile;
+extern	char *							errorInvalidDictionaryEntry;
+extern	char *							errorMissingDictionary;
+extern	char *							errorNoExportFile;
+extern	char *							errorChecksumNotReplaced;
+extern	char *							errorSectionNotFound;
+extern	char *							errorMissingTargetKey;
+extern	char *							errorEncryptionFailed;
+extern	char *							errorOpeningOutputFile;
+extern	char *							errorInvalidTffsImage;
+extern	char *							errorInvalidOutputFormat;
+extern	char *							errorConfigSyntax;
+extern	char *							errorInvalidConfigPath;
+extern	char *							errorMissingConfigPath;
+extern	char *							errorInvalidKeyNames;
+extern	char *							errorTooManyKeys;
+extern	char *							errorMissingPatternOrFiles;
+extern	char *							errorInvalidRegex;
+extern	char *							errorMissingExportFiles;
 extern	char *							errorUnexpectedIOError;
 
 #endif
@@ -147,13 +168,13 @@ char *	getErrorText(decoder_error_t err);
 
 // helper macros
 
-#define setError(err)					*__decoder_error = DECODER_ERROR_##err
+#define setError(err)					__decoder_error__ = DECODER_ERROR_##err
 
 #define resetError()					setError(NOERROR)
 
 #define returnError(err,value)			{ setError(err); return (value); }
 
-#define getError()						(*__decoder_error)
+#define getError()						(__decoder_error__)
 
 #define isAnyError()					(getError() != DECODER_ERROR_NOERROR)
 
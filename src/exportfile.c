@@ -27,33 +27,7 @@
 #pragma GCC diagnostic ignored "-Wformat-nonliteral"
 #pragma GCC diagnostic ignored "-Wformat-security"
 
-// FRITZ!OS export file checksum routines
-
-char *	getNextLine(memoryBuffer_t * input, size_t * offset, size_t * size)
-{
-	char *				current = input->data + *offset;
-	char *				start;
-
-	if (*current == '\xFF') /* skip the specified number of bytes */
-	{
-		uint16_t		skip = *((uint16_t *) (current + 1));
-
-		current += skip;
-		*offset = (current - input->data);
-	}
-
-	start = current;
-
-	while (*current != '\n' && *current != '\xFF' && current < (input->data + input->used))
-	{
-		current++;
-	}
-
-	*size = (current - (input->data + *offset) + (*current == '\n' ? 1 : 0)); /* include newline at end */
-	*offset += *size;
-
-	return start;
-}
+// open an output file in the specified directory
 
 FILE *	openOutputFile(const char * path, char * name, size_t nameSize)
 {
@@ -78,436 +52,1015 @@ FILE *	openOutputFile(const char * path, char * name, size_t nameSize)
 	return file;
 }
 
-EXPORTED	uint32_t	computeExportFileChecksum(memoryBuffer_t * input, FILE * out)
-{
-	char *				current;
-	char *				last = NULL;
-	size_t				offset = 0;
-	size_t				size = 0;
-	size_t				lastSize = 0;
-	enum {
-		NO_OUTPUT,
-		IN_HEADER,
-		IN_TEXTFILE,
-		IN_BINFILE,
-		IN_B64FILE,
-	}					output = NO_OUTPUT;
-	uint32_t			crcValue = 0;
-	char				buffer[9];
+// FRITZ!OS export file parser
+
+// section markers with a file name
+
+static	struct {
+	char *				marker;
+	size_t				markerSize;
+	exportSection_t		section;
+	char				letter;		/* type used in dictionary files */
+}						fileMarkers[] = {
+	{ "CFGFILE:", 8, EXPORT_SECTION_CFGFILE, 'c' },
+	{ "BINFILE:", 8, EXPORT_SECTION_BINFILE, 'b' },
+	{ "CRYPTEDBINFILE:", 15, EXPORT_SECTION_CRYPTEDBINFILE, 'B' },
+	{ "B64FILE:", 8, EXPORT_SECTION_B64FILE, 'n' },
+	{ "CRYPTEDB64FILE:", 15, EXPORT_SECTION_CRYPTEDB64FILE, 'N' },
+	{ NULL, 0, EXPORT_SECTION_NONE, 0 },
+};
+
+// conversions between sections and their markers or dictionary types
+
+static	char	exportSectionLetter(exportSection_t section)
+{
+	int					i;
+
+	for (i = 0; fileMarkers[i].marker && fileMarkers[i].section != section; i++);
+
+	return fileMarkers[i].letter;
+}
+
+static	exportSection_t	exportSectionFromLetter(char letter)
+{
+	int					i;
+
+	for (i = 0; fileMarkers[i].marker && fileMarkers[i].letter != letter; i++);
+
+	return fileMarkers[i].section;
+}
+
+static	char *	exportSectionMarker(exportSection_t section)
+{
+	int					i;
+
+	for (i = 0; fileMarkers[i].marker && fileMarkers[i].section != section; i++);
+
+	return fileMarkers[i].marker;
+}
+
+// make sure, a parser buffer can hold the specified amount of data, existing content is kept
+
+static	bool	reserveBuffer(char * *buffer, size_t * allocated, size_t used, size_t needed)
+{
+	if (needed <= *allocated)
+		return true;
+
+	size_t				newSize = (*allocated ? *allocated : 256);
+	char *				newBuffer;
+
+	while (newSize < needed)
+		newSize *= 2;
+
+	if (!(newBuffer = (char *) malloc(newSize)))
+		returnError(NO_MEMORY, false);
+
+	if (used)
+		memcpy(newBuffer, *buffer, used);
+	*buffer = clearMemory(*buffer, *allocated, true);
+	*buffer = newBuffer;
+	*allocated = newSize;
+
+	return true;
+}
+
+// call the event handler, a handler may stop further processing
+
+static	bool	exportParserEmit(exportParser_t * parser, exportEvent_t * event)
+{
+	if (parser->aborted)
+		return false;
+
+	if (parser->handler && !(*parser->handler)(event, parser->context))
+		parser->aborted = true;
+
+	return !parser->aborted;
+}
+
+// count a line from a text file, double backslashes are counted as single ones
+
+static	void	crcUpdateEscaped(crcCtx_t * crc, char * line, size_t size)
+{
+	char *				start = line;
+	char *				current = line;
+	char *				end = line + size;
+
+	while (current < end)
+	{
+		if (*current == '\\' && (current + 1) < end && *(current + 1) == '\\')
+		{
+			crcUpdate(crc, start, (current + 1) - start);
+			current += 2;
+			start = current;
+		}
+		else
+			current++;
+	}
+
+	if (current > start)
+		crcUpdate(crc, start, current - start);
+}
+
+// emit a held text line - the last line of a text file isn't counted
+
+static	bool	exportParserReleaseLine(exportParser_t * parser, bool last)
+{
+	if (!parser->holding)
+		return true;
+
+	parser->holding = false;
+
+	if (!last)
+		crcUpdateEscaped(parser->crc, parser->held, parser->heldSize);
 
-	crcCtx_t *			ctx = crcInit();
+	exportEvent_t		event = { .type = EXPORT_EVENT_TEXT_LINE, .section = EXPORT_SECTION_CFGFILE, .line = parser->held, .lineSize = parser->heldSize, .position = parser->heldPosition, .last = last };
 
-	while ((current = getNextLine(input, &offset, &size)) && (size > 0))
+	return exportParserEmit(parser, &event);
+}
+
+// classify a line starting with the marker prefix, file markers provide the name of the contained file
+
+static	exportMarker_t	exportMarkerType(char * line, size_t size, exportSection_t * section, char * *name, size_t * nameSize)
+{
+	char *				marker = line + 5;
+	size_t				markerSize;
+	int					i;
+
+	if (size < 5 || strncmp(line, "**** ", 5))
+		return EXPORT_MARKER_NONE;
+
+	markerSize = size - 5 - (*(line + size - 1) == '\n' ? 1 : 0);
+
+	if (markerSize >= 16 && strncmp(marker, "END OF FILE ****", 16) == 0)
+		return EXPORT_MARKER_END_OF_FILE;
+
+	if (markerSize >= 14 && strncmp(marker, "END OF EXPORT ", 14) == 0)
+		return EXPORT_MARKER_END_OF_EXPORT;
+
+	if (markerSize >= 5 && strncmp(marker, "FRITZ", 5) == 0)
+	{
+		*section = EXPORT_SECTION_HEADER;
+		return EXPORT_MARKER_HEADER;
+	}
+
+	for (i = 0; fileMarkers[i].marker; i++)
 	{
-		if (strncmp(current, "**** ", 5) == 0) /* any marker line */
+		if (markerSize >= fileMarkers[i].markerSize && strncmp(marker, fileMarkers[i].marker, fileMarkers[i].markerSize) == 0)
 		{
-			if (strncmp(current + 5, "END OF FILE ****", 16) == 0) /* end of file found */
+			*section = fileMarkers[i].section;
+			*name = marker + fileMarkers[i].markerSize;
+			*nameSize = markerSize - fileMarkers[i].markerSize;
+			return EXPORT_MARKER_FILE;
+		}
+	}
+
+	return EXPORT_MARKER_UNKNOWN;
+}
+
+// process a marker line
+
+static	bool	exportParserMarker(exportParser_t * parser, exportEvent_t * event, exportMarker_t marker)
+{
+	/* a held text line is the last one of its file, if the file ends with this marker */
+
+	if (!exportParserReleaseLine(parser, (marker != EXPORT_MARKER_UNKNOWN)))
+		return false;
+
+	switch (marker)
+	{
+		case EXPORT_MARKER_END_OF_FILE: /* end of file found */
+			event->type = EXPORT_EVENT_SECTION_END;
+			parser->section = EXPORT_SECTION_NONE;
+			break;
+
+		case EXPORT_MARKER_END_OF_EXPORT: /* end of export file found */
 			{
-				output = NO_OUTPUT;
+				char	buffer[9];
+				size_t	digits = event->lineSize - (5 + 14) - (*(event->line + event->lineSize - 1) == '\n' ? 1 : 0);
+
+				event->type = EXPORT_EVENT_END;
+				event->value = event->line + 5 + 14;
+				event->valueSize = (digits > 8 ? 8 : digits);
+				event->checksum = crcFinal(parser->crc);
+				snprintf(buffer, sizeof(buffer), "%08X", event->checksum);
+				event->valid = (event->valueSize == 8 && strncmp(event->value, buffer, 8) == 0);
+				parser->section = EXPORT_SECTION_NONE;
+
+				if (!(parser->crc = crcInit())) /* another export may follow */
+					returnError(NO_MEMORY, false);
 			}
-			else if (strncmp(current + 5, "END OF EXPORT ", 14) == 0) /* end of export file found */
+			break;
+
+		case EXPORT_MARKER_HEADER: /* header start found */
+			event->type = EXPORT_EVENT_SECTION_START;
+			parser->section = event->section;
+			break;
+
+		case EXPORT_MARKER_FILE: /* file found, its name is counted with a NUL character */
+			event->type = EXPORT_EVENT_SECTION_START;
+			parser->section = event->section;
+			crcUpdate(parser->crc, event->name, event->nameSize);
+			crcUpdate(parser->crc, "\0", 1);
+			break;
+
+		default:
+			break;
+	}
+
+	return exportParserEmit(parser, event);
+}
+
+// process a single line, including its newline character (if any)
+
+static	bool	exportParserLine(exportParser_t * parser, char * line, size_t size)
+{
+	exportEvent_t		event = { .type = EXPORT_EVENT_LINE, .section = parser->section, .line = line, .lineSize = size, .position = parser->position };
+
+	exportMarker_t		marker = exportMarkerType(line, size, &event.section, &event.name, &event.nameSize);
+
+	parser->position += size;
+
+	if (marker != EXPORT_MARKER_NONE) /* any marker line */
+		return exportParserMarker(parser, &event, marker);
+
+	switch (parser->section)
+	{
+		case EXPORT_SECTION_HEADER:
 			{
-				memcpy(buffer, current + 5 + 14, 8);
-				buffer[8] = 0;
-				verboseMessage(verboseChecksumFound, buffer);
+				/* count name and value, without equal-sign and with NUL instead of a final newline */
 
-				crcValue = crcFinal(ctx);
-				snprintf(buffer, sizeof(buffer), "%08X", crcValue);
-				buffer[8] = 0;
+				char *	equal = memchr(line, '=', size);
 
-				if (strncmp(current + 5 + 14, buffer, 8) == 0)
-				{
-					verboseMessage(verboseChecksumIsValid);
-				}
-				else
+				if (equal)
 				{
-					verboseMessage(verboseNewChecksum, buffer);
-					if (out)
+					event.type = EXPORT_EVENT_HEADER_FIELD;
+					event.name = line;
+					event.nameSize = equal - line;
+					event.value = equal + 1;
+					event.valueSize = size - (event.nameSize + 1);
+					crcUpdate(parser->crc, event.name, event.nameSize);
+
+					if (event.valueSize > 0 && *(event.value + event.valueSize - 1) == '\n')
 					{
-						if ((fwrite(current, 5 + 14, 1, out) != 1) ||
-							(fwrite(buffer, 8, 1, out) != 1) ||
-							(fwrite(current + 5 + 14 + 8, size - (5 + 14 + 8), 1, out) != 1))
-						{
-							setError(WRITE_FAILED);
-							break;
-						}
-						else
-						{
-							size = 0; /* all output was written already */
-						}
+						event.valueSize--;
+						crcUpdate(parser->crc, event.value, event.valueSize);
+						crcUpdate(parser->crc, "\0", 1);
 					}
 				}
-
-				output = NO_OUTPUT;
 			}
-			else if (strncmp(current + 5, "FRITZ", 5) == 0) /* header start found */
+			break;
+
+		case EXPORT_SECTION_CFGFILE:
 			{
-				output = IN_HEADER;
+				/* the last line isn't counted ... that's why the line will be held until the next one was read */
+
+				if (!exportParserReleaseLine(parser, false))
+					return false;
+
+				if (!reserveBuffer(&parser->held, &parser->heldAllocated, 0, size))
+					return false;
+
+				memcpy(parser->held, line, size);
+				parser->heldSize = size;
+				parser->heldPosition = event.position;
+				parser->holding = true;
 			}
-			else if (strncmp(current + 5, "CFGFILE:", 8) == 0) /* text file found */
+			return true;
+
+		case EXPORT_SECTION_BINFILE:
+		case EXPORT_SECTION_CRYPTEDBINFILE:
 			{
-				char *	value = current + 5 + 8;
-				size_t	valueSize = size - (5 + 8) - (*(current + size - 1) == '\n' ? 1 : 0);
-
-				output = IN_TEXTFILE;
-				last = NULL;
-				lastSize = 0;
-				crcUpdate(ctx, value, valueSize);
-				crcUpdate(ctx, "\0", 1);
+				/* count each decoded line (convert it to binary first) */
+
+				if (!reserveBuffer(&parser->decoded, &parser->decodedAllocated, 0, (size + 1) / 2))
+					return false;
+
+				event.type = EXPORT_EVENT_BINARY_LINE;
+				event.value = parser->decoded;
+				event.valueSize = hexadecimalToBinary(line, size, parser->decoded, (size + 1) / 2);
+				crcUpdate(parser->crc, event.value, event.valueSize);
 			}
-			else if (strncmp(current + 5, "BINFILE:", 8) == 0 || strncmp(current + 5, "CRYPTEDBINFILE:", 15) == 0) /* binary file found */
+			break;
+
+		case EXPORT_SECTION_B64FILE:
+		case EXPORT_SECTION_CRYPTEDB64FILE:
 			{
-				char *	value = current + 5 + (strncmp(current + 5, "BIN", 3) == 0 ? 8 : 15);
-				size_t	valueSize = size - (5 + (strncmp(current + 5, "BIN", 3) == 0 ? 8 : 15)) - (*(current + size - 1) == '\n' ? 1 : 0);
+				/* count each decoded line (convert it to binary first) */
 
-				output = IN_BINFILE;
-				crcUpdate(ctx, value, valueSize);
-				crcUpdate(ctx, "\0", 1);
+				if (!reserveBuffer(&parser->decoded, &parser->decodedAllocated, 0, (size / 4 + 1) * 3))
+					return false;
+
+				event.type = EXPORT_EVENT_BINARY_LINE;
+				event.value = parser->decoded;
+				event.valueSize = base64ToBinary(line, size, parser->decoded, (size / 4 + 1) * 3, false, true);
+				crcUpdate(parser->crc, event.value, event.valueSize);
 			}
-			else if (strncmp(current + 5, "B64FILE:", 8) == 0 || strncmp(current + 5, "CRYPTEDB64FILE:", 15) == 0) /* Base64 encoded file found */
-			{
-				char *	value = current + 5 + (strncmp(current + 5, "B64", 3) == 0 ? 8 : 15);
-				size_t	valueSize = size - (5 + (strncmp(current + 5, "B64", 3) == 0 ? 8 : 15)) - (*(current + size - 1) == '\n' ? 1 : 0);
+			break;
+
+		default:
+			break;
+	}
+
+	return exportParserEmit(parser, &event);
+}
+
+// create a new parser, the handler is called for each line
+
+EXPORTED	exportParser_t *	exportParserNew(exportEventHandler_t handler, void * context)
+{
+	exportParser_t *	parser = (exportParser_t *) malloc(sizeof(exportParser_t));
+
+	if (!parser)
+		returnError(NO_MEMORY, NULL);
+
+	memset(parser, 0, sizeof(exportParser_t));
+	parser->handler = handler;
+	parser->context = context;
+
+	if (!(parser->crc = crcInit()))
+	{
+		free(parser);
+		returnError(NO_MEMORY, NULL);
+	}
+
+	return parser;
+}
+
+// release a parser and clear its buffers
+
+EXPORTED	exportParser_t *	exportParserFree(exportParser_t * parser)
+{
+	if (!parser)
+		return NULL;
+
+	if (parser->crc)
+		crcFinal(parser->crc);
+
+	parser->partial = clearMemory(parser->partial, parser->partialAllocated, true);
+	parser->held = clearMemory(parser->held, parser->heldAllocated, true);
+	parser->decoded = clearMemory(parser->decoded, parser->decodedAllocated, true);
+	free(parser);
+
+	return NULL;
+}
+
+// feed the next chunk of data, complete lines are processed in place and only an incomplete
+// line at the end of a chunk is copied
+
+EXPORTED	bool	exportParserFeed(exportParser_t * parser, char * data, size_t size)
+{
+	while (size > 0 && !parser->aborted && !isAnyError())
+	{
+		char *			newline = memchr(data, '\n', size);
+		size_t			lineSize = (newline ? (size_t) (newline - data) + 1 : size);
+
+		if (parser->partialSize > 0 || !newline)
+		{
+			if (!reserveBuffer(&parser->partial, &parser->partialAllocated, parser->partialSize, parser->partialSize + lineSize))
+				return false;
 
-				output = IN_B64FILE;
-				crcUpdate(ctx, value, valueSize);
-				crcUpdate(ctx, "\0", 1);
+			memcpy(parser->partial + parser->partialSize, data, lineSize);
+			parser->partialSize += lineSize;
+
+			if (newline)
+			{
+				exportParserLine(parser, parser->partial, parser->partialSize);
+				parser->partialSize = 0;
 			}
 		}
 		else
-		{
-			switch (output)
-			{
-				case IN_HEADER:
-					{
-						/* count name and value, without equal-sign and with NUL instead of a final newline */
-
-						char *	value = current;
-						size_t	valueSize = 0;
-
-						while ((*(value + valueSize) != '=') && ((value + valueSize) < (current + size)))
-						{
-							valueSize++;
-						}
-
-						if (*(value + valueSize) == '=')
-						{
-							crcUpdate(ctx, value, valueSize); /* name */
-							value += valueSize + 1;
-							valueSize = 0;
-
-							while ((*(value + valueSize) != '\n') && ((value + valueSize) < (current + size)))
-							{
-								valueSize++;
-							}
-
-							if (*(value + valueSize) == '\n')
-							{
-								crcUpdate(ctx, value, valueSize); /* value */
-								crcUpdate(ctx, "\0", 1);
-							}
-						}
-					}
-					break;
+			exportParserLine(parser, data, lineSize);
 
-				case IN_TEXTFILE:
-					{
-						/* do not count the last line ... that's why counting will be delayed to the next call */
-						/* double backslashes are counted as single ones */
-
-						char *	value = last;
-						size_t	valueSize = lastSize;
-
-						if (value)
-						{
-							while (valueSize > 0)
-							{
-								while (valueSize > 0 && strncmp(value, "\\\\", 2))
-								{
-									value++;
-									valueSize--;
-								}
-
-								if (valueSize >= 2 && *value == '\\' && *(value + 1) == '\\') /* two consecutive backslashes */
-								{
-									crcUpdate(ctx, last, lastSize - valueSize);
-									last = value + 1;
-									lastSize = valueSize - 1;
-									value += 2;
-									valueSize -= 2;
-								}
-							}
-
-							if (lastSize > 0)
-							{
-								crcUpdate(ctx, last, lastSize);
-							}
-						}
-
-						last = current;
-						lastSize = size;
-					}
-					break;
+		data += lineSize;
+		size -= lineSize;
+	}
 
-				case IN_BINFILE:
-					{
-						/* count each decoded line (convert it to binary first) */
+	return (!parser->aborted && !isAnyError());
+}
 
-						char *	binary = malloc((size + 1) / 2);
-						size_t	binSize = (size + 1) / 2;
+// process an incomplete last line and release a held one
 
-						if (binary)
-						{
-							binSize = hexadecimalToBinary(current, size, binary, binSize);
-							crcUpdate(ctx, binary, binSize);
-							free(binary);
-						}
-					}
-					break;
+EXPORTED	bool	exportParserFinish(exportParser_t * parser)
+{
+	if (parser->partialSize > 0 && !parser->aborted && !isAnyError())
+	{
+		exportParserLine(parser, parser->partial, parser->partialSize);
+		parser->partialSize = 0;
+	}
 
-				case IN_B64FILE:
-					{
-						/* count each decoded line (convert it to binary first) */
+	if (!parser->aborted && !isAnyError())
+		exportParserReleaseLine(parser, true);
 
-						size_t	binSize = (size / 4 + 1) * 3;
-						char *	binary = malloc(binSize);
+	return (!parser->aborted && !isAnyError());
+}
 
-						if (binary)
-						{
-							binSize = base64ToBinary(current, size, binary, binSize, false, true);
-							crcUpdate(ctx, binary, binSize);
-							free(binary);
-						}
-					}
-					break;
+// feed all data from a stream into a parser
 
-				default:
-					break;
-			}
-		}
+EXPORTED	bool	exportParserReadFile(exportParser_t * parser, FILE * input)
+{
+	char *				buffer = (char *) malloc(EXPORT_READ_SIZE);
+	size_t				read;
+
+	if (!buffer)
+		returnError(NO_MEMORY, false);
+
+	while ((read = fread(buffer, 1, EXPORT_READ_SIZE, input)) > 0)
+	{
+		if (!exportParserFeed(parser, buffer, read))
+			break;
+	}
+
+	if (ferror(input))
+		setError(IO_ERROR);
+
+	clearMemory(buffer, EXPORT_READ_SIZE, true);
+
+	return (!isAnyError() ? exportParserFinish(parser) : false);
+}
+
+// FRITZ!OS export file checksum routines
+
+typedef struct {
+	outputSink_t *		out;
+	uint32_t			checksum;
+	size_t				trailer;	/* position of the checksum digits to replace */
+	char				digits[9];
+	bool				found;
+} checksumContext_t;
+
+static	bool	checksumEvent(exportEvent_t * event, void * context)
+{
+	checksumContext_t *	ctx = (checksumContext_t *) context;
+
+	if (event->type == EXPORT_EVENT_END)
+	{
+		char			buffer[9];
 
-		if (out && size)
+		memcpy(buffer, event->value, event->valueSize);
+		buffer[event->valueSize] = 0;
+		verboseMessage(verboseChecksumFound, buffer);
+
+		ctx->checksum = event->checksum;
+		ctx->found = true;
+		snprintf(ctx->digits, sizeof(ctx->digits), "%08X", ctx->checksum);
+
+		if (event->valid)
+		{
+			verboseMessage(verboseChecksumIsValid);
+		}
+		else
 		{
-			if (fwrite(current, size, 1, out) != 1)
+			verboseMessage(verboseNewChecksum, ctx->digits);
+			ctx->trailer = event->position + 5 + 14;
+
+			if (ctx->out && event->lineSize >= (5 + 14 + 8)) /* write the line with the new checksum */
 			{
-				setError(WRITE_FAILED);
-				break;
+				return (outputSinkWrite(ctx->out, event->line, 5 + 14) &&
+						outputSinkWrite(ctx->out, ctx->digits, 8) &&
+						outputSinkWrite(ctx->out, event->line + 5 + 14 + 8, event->lineSize - (5 + 14 + 8)));
 			}
 		}
 	}
 
-	return crcValue;
+	if (ctx->out)
+		return outputSinkWrite(ctx->out, event->line, event->lineSize);
+
+	return true;
 }
 
-EXPORTED	void	decomposeExportFile(memoryBuffer_t * input, const char * path, bool readyForComposition)
-{
-	char *				current;
-	size_t				offset = 0;
-	size_t				size = 0;
-	enum {
-		NO_OUTPUT,
-		IN_HEADER,
-		IN_TEXTFILE,
-		IN_BINFILE,
-		IN_CRYPTEDBINFILE,
-		IN_B64FILE,
-		IN_CRYPTEDB64FILE,
-	}					output = NO_OUTPUT;
-	FILE *				out = NULL;
-	char *				last = NULL;
-	size_t				lastSize = 0;
-	FILE *				dictionary = NULL;
+EXPORTED	uint32_t	computeExportFileChecksum(FILE * input, outputSink_t * out)
+{
+	checksumContext_t	ctx = { .out = out };
+	exportParser_t *	parser = exportParserNew(&checksumEvent, &ctx);
 
-	if (readyForComposition)
+	if (!parser)
+		return 0;
+
+	exportParserReadFile(parser, input);
+	parser = exportParserFree(parser);
+
+	return ctx.checksum;
+}
+
+EXPORTED	uint32_t	computeExportViewChecksum(memoryView_t * input, outputSink_t * out)
+{
+	checksumContext_t	ctx = { .out = NULL };
+	exportParser_t *	parser = exportParserNew(&checksumEvent, &ctx);
+	size_t				i;
+
+	if (!parser)
+		return 0;
+
+	for (i = 0; i < input->count; i++)
 	{
-		dictionary = openOutputFile(path, "export_dictionary", strlen("export_dictionary"));
+		if (!exportParserFeed(parser, (char *) input->spans[i].iov_base, input->spans[i].iov_len))
+			break;
 	}
-	
-	while ((current = getNextLine(input, &offset, &size)) && (size > 0))
+
+	if (i == input->count)
+		exportParserFinish(parser);
+
+	parser = exportParserFree(parser);
+
+	if (out && !isAnyError())
 	{
-		if (strncmp(current, "**** ", 5) == 0) /* any marker line */
+		size_t			dataSize = memoryViewDataSize(input);
+
+		if (ctx.trailer && ctx.trailer + 8 <= dataSize) /* unchanged data with the new checksum in place of the old one */
 		{
-			if (strncmp(current + 5, "END OF FILE ****", 16) == 0) /* end of file found */
-			{
-				fclose(out);
-				output = NO_OUTPUT;
-			}
-			else if (strncmp(current + 5, "END OF EXPORT ", 14) == 0) /* end of export file found */
+			if (outputSinkWriteView(out, input, 0, ctx.trailer) && outputSinkWrite(out, ctx.digits, 8))
+				outputSinkWriteView(out, input, ctx.trailer + 8, dataSize - (ctx.trailer + 8));
+		}
+		else
+			outputSinkWriteView(out, input, 0, dataSize);
+	}
+
+	return ctx.checksum;
+}
+
+// replace the checksum of an export file in place - the file is read once and only the digits are
+// written with a single call, if they differ from the computed value
+
+EXPORTED	bool	repairExportFileChecksum(const char * fileName, bool * changed)
+{
+	checksumContext_t	ctx = { .out = NULL };
+	exportParser_t *	parser;
+	FILE *				input;
+	int					fd;
+
+	*changed = false;
+
+	if ((fd = open(fileName, O_RDWR | O_CLOEXEC)) < 0)
+		returnError(IO_ERROR, false);
+
+	if (!(input = fdopen(fd, "r")))
+	{
+		close(fd);
+		returnError(IO_ERROR, false);
+	}
+
+	if ((parser = exportParserNew(&checksumEvent, &ctx)))
+	{
+		exportParserReadFile(parser, input);
+		parser = exportParserFree(parser);
+	}
+
+	if (!isAnyError())
+	{
+		if (!ctx.found)
+			setError(INVALID_FILE);
+		else if (ctx.trailer)
+		{
+			if (pwrite(fd, ctx.digits, 8, ctx.trailer) != 8 || fsync(fd) != 0)
+				setError(IO_ERROR);
+			else
+				*changed = true;
+		}
+	}
+
+	fclose(input);
+
+	return !isAnyError();
+}
+
+// FRITZ!OS export file decomposition
+
+typedef struct {
+	const char *		path;
+	bool				readyForComposition;
+	FILE *				dictionary;
+	FILE *				out;
+} decomposeContext_t;
+
+static	bool	decomposeWrite(decomposeContext_t * ctx, char * data, size_t size)
+{
+	if (size > 0 && fwrite(data, size, 1, ctx->out) != 1)
+	{
+		fclose(ctx->out);
+		ctx->out = NULL;
+		returnError(WRITE_FAILED, false);
+	}
+
+	return true;
+}
+
+static	bool	decomposeEvent(exportEvent_t * event, void * context)
+{
+	decomposeContext_t *	ctx = (decomposeContext_t *) context;
+
+	switch (event->type)
+	{
+		case EXPORT_EVENT_SECTION_START:
+			if (ctx->out)
 			{
-				output = NO_OUTPUT;
+				fclose(ctx->out);
+				ctx->out = NULL;
 			}
-			else if (strncmp(current + 5, "FRITZ", 5) == 0) /* header start found */
+
+			if (event->section == EXPORT_SECTION_HEADER)
 			{
-				output = IN_HEADER;
-				if (readyForComposition)
+				if (ctx->readyForComposition)
 				{
-					out = openOutputFile(path, "export_header", strlen("export_header"));
-					if (!out)
-						return;
-					if (fwrite(current, size, 1, out) != 1)
-					{
-						fclose(out);
-						setError(WRITE_FAILED);
-						return;
-					}
+					if (!(ctx->out = openOutputFile(ctx->path, "export_header", strlen("export_header"))))
+						return false;
+					return decomposeWrite(ctx, event->line, event->lineSize);
 				}
 			}
-			else if (strncmp(current + 5, "CFGFILE:", 8) == 0) /* text file found */
+			else
 			{
-				char *	value = current + 5 + 8;
-				size_t	valueSize = size - (5 + 8) - (*(current + size - 1) == '\n' ? 1 : 0);
-
-				output = IN_TEXTFILE;
-				last = NULL;
-				lastSize = 0;
-				out = openOutputFile(path, value, valueSize);
-				if (!out)
-					return;
-				if (dictionary)
-				{
-					char	buffer[PATH_MAX + 1];
+				if (!(ctx->out = openOutputFile(ctx->path, event->name, event->nameSize)))
+					return false;
 
-					strncpy(buffer, value, valueSize);
-					buffer[valueSize] = 0;
-					fprintf(dictionary, "%c %s\n", 'c', buffer);
-				}
-			}
-			else if (strncmp(current + 5, "BINFILE:", 8) == 0 || strncmp(current + 5, "CRYPTEDBINFILE:", 15) == 0) /* binary file found */
-			{
-				char *	value = current + 5 + (strncmp(current + 5, "BIN", 3) == 0 ? 8 : 15);
-				size_t	valueSize = size - (5 + (strncmp(current + 5, "BIN", 3) == 0 ? 8 : 15)) - (*(current + size - 1) == '\n' ? 1 : 0);
-
-				output = (strncmp(current + 5, "BIN", 3) == 0 ? IN_BINFILE : IN_CRYPTEDBINFILE);
-				out = openOutputFile(path, value, valueSize);
-				if (!out)
-					return;
-				if (dictionary)
+				if (ctx->dictionary)
 				{
 					char	buffer[PATH_MAX + 1];
 
-					strncpy(buffer, value, valueSize);
-					buffer[valueSize] = 0;
-					fprintf(dictionary, "%c %s\n", (strncmp(current + 5, "BIN", 3) == 0 ? 'b' : 'B'), buffer);
+					strncpy(buffer, event->name, event->nameSize);
+					buffer[event->nameSize] = 0;
+					fprintf(ctx->dictionary, "%c %s\n", exportSectionLetter(event->section), buffer);
 				}
 			}
-			else if (strncmp(current + 5, "B64FILE:", 8) == 0 || strncmp(current + 5, "CRYPTEDB64FILE:", 15) == 0) /* Base64 encoded file found */
+			break;
+
+		case EXPORT_EVENT_HEADER_FIELD:
+		case EXPORT_EVENT_LINE:
+			if (event->section == EXPORT_SECTION_HEADER && ctx->out && event->lineSize != 1 && *event->line != '\n')
+				return decomposeWrite(ctx, event->line, event->lineSize);
+			break;
+
+		case EXPORT_EVENT_TEXT_LINE:
+			if (!event->last && ctx->out)
+				return decomposeWrite(ctx, event->line, event->lineSize);
+			break;
+
+		case EXPORT_EVENT_BINARY_LINE:
+			if (ctx->out)
+				return decomposeWrite(ctx, event->value, event->valueSize);
+			break;
+
+		case EXPORT_EVENT_SECTION_END:
+			if (ctx->out)
 			{
-				char *	value = current + 5 + (strncmp(current + 5, "B64", 3) == 0 ? 8 : 15);
-				size_t	valueSize = size - (5 + (strncmp(current + 5, "B64", 3) == 0 ? 8 : 15)) - (*(current + size - 1) == '\n' ? 1 : 0);
-
-				output = (strncmp(current + 5, "B64", 3) == 0 ? IN_B64FILE : IN_CRYPTEDB64FILE);
-				out = openOutputFile(path, value, valueSize);
-				if (!out)
-					return;
-				if (dictionary)
-				{
-					char	buffer[PATH_MAX + 1];
-
-					strncpy(buffer, value, valueSize);
-					buffer[valueSize] = 0;
-					fprintf(dictionary, "%c %s\n", (strncmp(current + 5, "B64", 3) == 0 ? 'n' : 'N'), buffer);
-				}
+				fclose(ctx->out);
+				ctx->out = NULL;
 			}
-		}
-		else
-		{
-			switch (output)
-			{
-				case IN_HEADER:
-					{
-						if (!out)
-							break;
-
-						if (size != 1 && *current != '\n')
-						{
-							if (fwrite(current, size, 1, out) != 1)
-							{
-								fclose(out);
-								setError(WRITE_FAILED);
-								return;
-							}
-						}
-					}
-					break;
+			break;
 
-				case IN_TEXTFILE:
-					{
-						/* write the previous line to file */
-						
-						char *	value = last;
-						size_t	valueSize = lastSize;
-
-						if (value)
-						{
-							if (fwrite(value, valueSize, 1, out) != 1)
-							{
-								fclose(out);
-								setError(WRITE_FAILED);
-								return;
-							}
-						}
-
-						last = current;
-						lastSize = size;
-					}
-					break;
+		default:
+			break;
+	}
 
-				case IN_BINFILE:
-				case IN_CRYPTEDBINFILE:
-					{
-						if (size == 1 && *current == '\n')
-							break;
-
-						/* write binary data line */
-
-						char *	binary = malloc((size + 1) / 2);
-						size_t	binSize = (size + 1) / 2;
-
-						if (binary)
-						{
-							binSize = hexadecimalToBinary(current, size, binary, binSize);
-							if (binSize > 0 && fwrite(binary, binSize, 1, out) != 1)
-							{
-								fclose(out);
-								setError(WRITE_FAILED);
-								free(binary);
-								return;
-							}
-							free(binary);
-						}
-					}
-					break;
+	return true;
+}
+
+EXPORTED	void	decomposeExportFile(FILE * input, const char * path, bool readyForComposition)
+{
+	decomposeContext_t	ctx = { .path = path, .readyForComposition = readyForComposition };
+	exportParser_t *	parser;
+
+	if (readyForComposition)
+	{
+		ctx.dictionary = openOutputFile(path, "export_dictionary", strlen("export_dictionary"));
+	}
+
+	if ((parser = exportParserNew(&decomposeEvent, &ctx)))
+	{
+		exportParserReadFile(parser, input);
+		parser = exportParserFree(parser);
+	}
+
+	if (ctx.out)
+	{
+		fclose(ctx.out);
+	}
+
+	if (ctx.dictionary)
+	{
+		fclose(ctx.dictionary);
+	}
+
+	return;
+}
+
+// build an index of all sections from export data in memory
+
+EXPORTED	exportIndexEntry_t *	exportIndexSections(char * data, size_t size, size_t * count)
+{
+	exportIndexEntry_t *	entries = NULL;
+	exportIndexEntry_t *	current = NULL;
+	size_t				allocated = 0;
+	char *				line = data;
+	char *				end = data + size;
+
+	*count = 0;
+
+	while (line < end)
+	{
+		char *			newline = memchr(line, '\n', end - line);
+		size_t			lineSize = (newline ? (size_t) (newline - line) + 1 : (size_t) (end - line));
+		exportSection_t	section = EXPORT_SECTION_NONE;
+		char *			name = NULL;
+		size_t			nameSize = 0;
+		exportMarker_t	marker = exportMarkerType(line, lineSize, &section, &name, &nameSize);
+
+		if (marker != EXPORT_MARKER_NONE && marker != EXPORT_MARKER_UNKNOWN)
+		{
+			if (current) /* any known marker ends the current section */
+			{
+				current->size = line - current->data;
+				current = NULL;
+			}
+
+			if (marker == EXPORT_MARKER_HEADER || marker == EXPORT_MARKER_FILE)
+			{
+				if (*count == allocated)
+				{
+					exportIndexEntry_t *	grown = (exportIndexEntry_t *) realloc(entries, (allocated ? allocated * 2 : 32) * sizeof(exportIndexEntry_t));
 
-				case IN_B64FILE:
-				case IN_CRYPTEDB64FILE:
+					if (!grown)
 					{
-						if (size == 1 && *current == '\n')
-							break;
-
-						/* write base64 data line */
-
-						size_t	binSize = (size / 4 + 1) * 3;
-						char *	binary = malloc(binSize);
-
-						if (binary)
-						{
-							binSize = base64ToBinary(current, size, binary, binSize, false, true);
-							if (binSize > 0 && fwrite(binary, binSize, 1, out) != 1)
-							{
-								fclose(out);
-								setError(WRITE_FAILED);
-								free(binary);
-								return;
-							}
-							free(binary);
-						}
+						free(entries);
+						*count = 0;
+						returnError(NO_MEMORY, NULL);
 					}
-					break;
 
-				default:
-					break;
+					entries = grown;
+					allocated = (allocated ? allocated * 2 : 32);
+				}
+
+				current = &entries[(*count)++];
+				current->section = section;
+				current->line = line;
+				current->lineSize = lineSize;
+				current->name = name;
+				current->nameSize = nameSize;
+				current->data = line + lineSize;
+				current->size = 0;
+			}
+		}
+
+		line += lineSize;
+	}
+
+	if (current)
+		current->size = end - current->data;
+
+	return entries;
+}
+
+// write data to a file descriptor, partial writes are continued
+
+static	bool	writeAll(int fd, char * data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t			written = write(fd, data, size);
+
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+
+		data += written;
+		size -= written;
+	}
+
+	return true;
+}
+
+// write a single section to its file - text files are written directly from the input data, binary
+// files are decoded into a buffer, which is reused for all sections handled by the same worker
+
+static	bool	decomposeSection(exportIndexEntry_t * entry, const char * path, int dirFd, char * *buffer, size_t * bufferSize)
+{
+	char				fileName[PATH_MAX + 1];
+	char *				line = entry->data;
+	char *				end = entry->data + entry->size;
+	char *				run = NULL;			/* unchanged text lines to write */
+	size_t				used = 0;
+	bool				success = true;
+	int					fd;
+
+	if (entry->nameSize >= sizeof(fileName))
+		return false;
+
+	memcpy(fileName, entry->name, entry->nameSize);
+	fileName[entry->nameSize] = 0;
+
+	if ((fd = openat(dirFd, fileName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)) < 0)
+		return false;
+
+	if (isVerbose())
+	{
+		char			pathName[PATH_MAX + 1];
+
+		if (snprintf(pathName, sizeof(pathName), "%s/%s", path, fileName) < (int) sizeof(pathName))
+		{
+			verboseMessage(verboseOpenedOutputFile, pathName);
+		}
+	}
+
+	while (success && line < end)
+	{
+		char *			newline = memchr(line, '\n', end - line);
+		size_t			lineSize = (newline ? (size_t) (newline - line) + 1 : (size_t) (end - line));
+		bool			marker = (lineSize >= 5 && strncmp(line, "**** ", 5) == 0);
+
+		if (entry->section == EXPORT_SECTION_CFGFILE)
+		{
+			/* the last line isn't part of the file, unknown markers are skipped */
+
+			if ((marker || line + lineSize == end) && run)
+			{
+				success = writeAll(fd, run, line - run);
+				run = NULL;
+			}
+			else if (!marker && !run)
+				run = line;
+		}
+		else if (!marker)
+		{
+			size_t		needed = (entry->section == EXPORT_SECTION_BINFILE || entry->section == EXPORT_SECTION_CRYPTEDBINFILE ? (lineSize + 1) / 2 : (lineSize / 4 + 1) * 3);
+
+			if (used + needed > *bufferSize)
+			{
+				if (used > 0)
+				{
+					success = writeAll(fd, *buffer, used);
+					used = 0;
+				}
+
+				if (success && needed > *bufferSize)
+					success = reserveBuffer(buffer, bufferSize, 0, needed);
+			}
+
+			if (success)
+			{
+				if (entry->section == EXPORT_SECTION_BINFILE || entry->section == EXPORT_SECTION_CRYPTEDBINFILE)
+					used += hexadecimalToBinary(line, lineSize, *buffer + used, needed);
+				else
+					used += base64ToBinary(line, lineSize, *buffer + used, needed, false, true);
+			}
+		}
+
+		line += lineSize;
+	}
+
+	if (success && used > 0)
+		success = writeAll(fd, *buffer, used);
+
+	if (close(fd) != 0)
+		success = false;
+
+	return success;
+}
+
+// worker thread for parallel decomposition, sections are taken from a shared list until it's exhausted
+
+typedef struct {
+	exportIndexEntry_t * *	queue;
+	size_t				count;
+	size_t *			next;
+	const char *		path;
+	int					dirFd;
+	bool				failed;
+	pthread_t			thread;
+} decomposeWorker_t;
+
+static	void *	decomposeWorker(void * context)
+{
+	decomposeWorker_t *	worker = (decomposeWorker_t *) context;
+	char *				buffer = NULL;
+	size_t				bufferSize = 0;
+	size_t				next;
+
+	if (!reserveBuffer(&buffer, &bufferSize, 0, EXPORT_WORKER_BUFFER_SIZE))
+	{
+		worker->failed = true;
+		return NULL;
+	}
+
+	while ((next = __atomic_fetch_add(worker->next, 1, __ATOMIC_RELAXED)) < worker->count)
+	{
+		if (!decomposeSection(worker->queue[next], worker->path, worker->dirFd, &buffer, &bufferSize))
+			worker->failed = true;
+	}
+
+	buffer = clearMemory(buffer, bufferSize, true);
+
+	return NULL;
+}
+
+// larger sections are processed first, this keeps the workers busy until the end
+
+static	int		compareSectionSize(const void * left, const void * right)
+{
+	size_t				leftSize = (*((exportIndexEntry_t * *) left))->size;
+	size_t				rightSize = (*((exportIndexEntry_t * *) right))->size;
+
+	return (leftSize < rightSize ? 1 : (leftSize > rightSize ? -1 : 0));
+}
+
+// split export data in memory with the specified number of parallel jobs - the header and the dictionary
+// are written first, all files are written by the workers
+
+EXPORTED	void	decomposeExportData(char * data, size_t size, const char * path, bool readyForComposition, unsigned int jobs)
+{
+	size_t				count = 0;
+	size_t				files = 0;
+	size_t				next = 0;
+	size_t				i;
+	int					dirFd;
+	exportIndexEntry_t *	entries = exportIndexSections(data, size, &count);
+	exportIndexEntry_t * *	queue = NULL;
+	FILE *				dictionary = NULL;
+	FILE *				header = NULL;
+	decomposeWorker_t	workers[EXPORT_MAX_JOBS];
+	unsigned int		started = 0;
+
+	if (!entries)
+		return;
+
+	if ((dirFd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+	{
+		free(entries);
+		setError(IO_ERROR);
+		return;
+	}
+
+	if (!(queue = (exportIndexEntry_t * *) malloc(count * sizeof(exportIndexEntry_t *))))
+	{
+		close(dirFd);
+		free(entries);
+		setError(NO_MEMORY);
+		return;
+	}
+
+	if (readyForComposition)
+	{
+		dictionary = openOutputFile(path, "export_dictionary", strlen("export_dictionary"));
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		exportIndexEntry_t *	entry = &entries[i];
+
+		if (entry->section == EXPORT_SECTION_HEADER)
+		{
+			char *		line = entry->data;
+			char *		end = entry->data + entry->size;
+
+			if (!readyForComposition)
+				continue;
+
+			if (header)
+				fclose(header);
+
+			if (!(header = openOutputFile(path, "export_header", strlen("export_header"))))
+				break;
+
+			fwrite(entry->line, entry->lineSize, 1, header);
+
+			while (line < end)
+			{
+				char *	newline = memchr(line, '\n', end - line);
+				size_t	lineSize = (newline ? (size_t) (newline - line) + 1 : (size_t) (end - line));
+
+				if (lineSize != 1 && *line != '\n')
+					fwrite(line, lineSize, 1, header);
+
+				line += lineSize;
+			}
+
+			if (ferror(header))
+			{
+				setError(WRITE_FAILED);
+				break;
 			}
 		}
+		else
+		{
+			if (dictionary)
+			{
+				char	buffer[PATH_MAX + 1];
+
+				if (entry->nameSize < sizeof(buffer))
+				{
+					strncpy(buffer, entry->name, entry->nameSize);
+					buffer[entry->nameSize] = 0;
+					fprintf(dictionary, "%c %s\n", exportSectionLetter(entry->section), buffer);
+				}
+			}
+
+			queue[files++] = entry;
+		}
+	}
+
+	if (header)
+	{
+		fclose(header);
 	}
 
 	if (dictionary)
@@ -515,7 +1068,615 @@ EXPORTED	void	decomposeExportFile(memoryBuffer_t * input, const char * path, boo
 		fclose(dictionary);
 	}
 
+	if (!isAnyError())
+	{
+		qsort(queue, files, sizeof(exportIndexEntry_t *), &compareSectionSize);
+
+		if (jobs > files)
+			jobs = files;
+
+		if (jobs > EXPORT_MAX_JOBS)
+			jobs = EXPORT_MAX_JOBS;
+
+		verboseMessage(verboseSplitJobs, files, jobs);
+
+		for (started = 0; started < jobs; started++)
+		{
+			workers[started].queue = queue;
+			workers[started].count = files;
+			workers[started].next = &next;
+			workers[started].path = path;
+			workers[started].dirFd = dirFd;
+			workers[started].failed = false;
+
+			if (started > 0 && pthread_create(&workers[started].thread, NULL, &decomposeWorker, &workers[started]) != 0)
+				break;
+		}
+
+		if (started > 0) /* the calling thread is the first worker */
+			decomposeWorker(&workers[0]);
+
+		for (i = 0; i < started; i++)
+		{
+			if (i > 0)
+				pthread_join(workers[i].thread, NULL);
+
+			if (workers[i].failed)
+				setError(WRITE_FAILED);
+		}
+	}
+
+	close(dirFd);
+	free(queue);
+	free(entries);
+
 	return;
 }
 
+// FRITZ!OS export file composition
+
+// read as much data as possible into a buffer, short reads are only returned at end of file
+
+static	ssize_t	readAll(int fd, char * buffer, size_t size)
+{
+	size_t				used = 0;
+
+	while (used < size)
+	{
+		ssize_t			bytes = read(fd, buffer + used, size - used);
+
+		if (bytes < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+
+		if (bytes == 0)
+			break;
+
+		used += bytes;
+	}
+
+	return used;
+}
+
+// copy a text file or the header to the output - complete lines are processed from the buffer, an
+// incomplete line at its end is moved to the start and completed with the next read
+
+static	bool	composeTextFile(int fd, char * *buffer, size_t * bufferSize, crcCtx_t * crc, outputSink_t * out, bool header)
+{
+	size_t				used = 0;
+	ssize_t				read;
+
+	while ((read = readAll(fd, *buffer + used, *bufferSize - used)) > 0 || used > 0)
+	{
+		char *			end;
+		char *			line = *buffer;
+
+		if (read < 0)
+			returnError(IO_ERROR, false);
+
+		used += read;
+
+		if (read == 0) /* missing newline at end of file */
+		{
+			if (used == *bufferSize && !reserveBuffer(buffer, bufferSize, used, used + 1))
+				return false;
+
+			*(*buffer + used++) = '\n';
+			if (!header) /* this line will not be counted - it's the last one of the file */
+				return outputSinkWrite(out, *buffer, used);
+		}
+
+		for (end = *buffer + used; end > *buffer && *(end - 1) != '\n'; end--);
+
+		if (end == *buffer) /* line is longer than the buffer */
+		{
+			if (!reserveBuffer(buffer, bufferSize, used, *bufferSize * 2))
+				return false;
+			continue;
+		}
+
+		if (!outputSinkWrite(out, *buffer, end - *buffer))
+			return false;
+
+		while (line < end)
+		{
+			char *		newline = memchr(line, '\n', end - line);
+			size_t		lineSize = (newline - line) + 1;
+
+			if (header)
+			{
+				exportSection_t	section;
+				char *			name;
+				size_t			nameSize;
+				char *			equal = memchr(line, '=', lineSize);
+
+				if (exportMarkerType(line, lineSize, &section, &name, &nameSize) == EXPORT_MARKER_NONE && equal)
+				{
+					crcUpdate(crc, line, equal - line);
+					crcUpdate(crc, equal + 1, lineSize - ((equal - line) + 2));
+					crcUpdate(crc, "\0", 1);
+				}
+			}
+			else
+				crcUpdateEscaped(crc, line, lineSize);
+
+			line += lineSize;
+		}
+
+		used -= (end - *buffer);
+		memmove(*buffer, end, used);
+
+		if (read == 0)
+			break;
+	}
+
+	if (read < 0)
+		returnError(IO_ERROR, false);
+
+	/* an empty line follows, it's the last one of a text file and isn't counted */
+
+	return outputSinkWrite(out, "\n", 1);
+}
+
+// encode binary data as hexadecimal or Base64 lines, the line sizes are equal to those used by FRITZ!OS
+
+static	bool	exportEncodeBinary(char * data, size_t dataSize, outputSink_t * out, bool base64)
+{
+	size_t				lineBytes = (base64 ? EXPORT_BASE64_LINE_SIZE : EXPORT_HEX_LINE_SIZE);
+
+	while (dataSize > 0)
+	{
+		char			line[(EXPORT_HEX_LINE_SIZE * 2) + (EXPORT_BASE64_LINE_SIZE * 4 / 3) + 8];
+		size_t			size = (dataSize > lineBytes ? lineBytes : dataSize);
+		size_t			lineSize;
+
+		if (base64)
+			lineSize = binaryToBase64(data, size, line, sizeof(line) - 1, true);
+		else
+			lineSize = binaryToHexadecimal(data, size, line, sizeof(line) - 1);
+
+		line[lineSize++] = '\n';
+
+		if (!outputSinkWrite(out, line, lineSize))
+			return false;
+
+		data += size;
+		dataSize -= size;
+	}
+
+	return true;
+}
+
+// encode a binary file read from a descriptor
+
+static	bool	composeBinaryFile(int fd, char * buffer, size_t bufferSize, crcCtx_t * crc, outputSink_t * out, bool base64)
+{
+	size_t				chunk = bufferSize - (bufferSize % (EXPORT_BASE64_LINE_SIZE * EXPORT_HEX_LINE_SIZE));
+	ssize_t				read;
+
+	while ((read = readAll(fd, buffer, chunk)) > 0)
+	{
+		crcUpdate(crc, buffer, read);
+
+		if (!exportEncodeBinary(buffer, read, out, base64))
+			return false;
+	}
+
+	if (read < 0)
+		returnError(IO_ERROR, false);
+
+	return true;
+}
+
+// build an export file from a directory created with the '--dictionary' option of 'split_export' - the
+// data is written to the output in a single pass and the checksum is computed on the fly
+
+EXPORTED	uint32_t	composeExportFile(const char * path, outputSink_t * out)
+{
+	int					dirFd;
+	int					fd;
+	FILE *				dictionary;
+	char *				entry = NULL;
+	size_t				entrySize = 0;
+	ssize_t				entryLength;
+	char *				buffer = NULL;
+	size_t				bufferSize = 0;
+	crcCtx_t *			crc = NULL;
+	uint32_t			crcValue = 0;
+	char				trailer[40];
+
+	if ((dirFd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+		returnError(IO_ERROR, 0);
+
+	if ((fd = openat(dirFd, "export_dictionary", O_RDONLY | O_CLOEXEC)) < 0 || !(dictionary = fdopen(fd, "r")))
+	{
+		errorMessage(errorMissingDictionary, path);
+		if (fd >= 0)
+			close(fd);
+		close(dirFd);
+		returnError(IO_ERROR, 0);
+	}
+
+	if (!reserveBuffer(&buffer, &bufferSize, 0, EXPORT_READ_SIZE) || !(crc = crcInit()))
+	{
+		buffer = clearMemory(buffer, bufferSize, true);
+		fclose(dictionary);
+		close(dirFd);
+		returnError(NO_MEMORY, 0);
+	}
+
+	if ((fd = openat(dirFd, "export_header", O_RDONLY | O_CLOEXEC)) >= 0)
+	{
+		verboseMessage(verboseOpenedInputFile, "export_header");
+		composeTextFile(fd, &buffer, &bufferSize, crc, out, true);
+		close(fd);
+	}
+	else
+	{
+		errorMessage(errorMissingDictionary, path);
+		setError(IO_ERROR);
+	}
+
+	while (!isAnyError() && (entryLength = getline(&entry, &entrySize, dictionary)) > 0)
+	{
+		exportSection_t	section;
+		char *			name = entry + 2;
+		size_t			nameSize;
+
+		while (entryLength > 0 && (*(entry + entryLength - 1) == '\n' || *(entry + entryLength - 1) == '\r'))
+			*(entry + --entryLength) = 0;
+
+		if (entryLength == 0) /* empty lines are ignored */
+			continue;
+
+		nameSize = entryLength - 2;
+		if (entryLength < 3 || *(entry + 1) != ' ' || (section = exportSectionFromLetter(*entry)) == EXPORT_SECTION_NONE)
+		{
+			errorMessage(errorInvalidDictionaryEntry, entry);
+			setError(INVALID_FILE);
+			break;
+		}
+
+		if ((fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC)) < 0)
+		{
+			errorMessage(errorOpeningInputFile, name);
+			setError(IO_ERROR);
+			break;
+		}
+
+		verboseMessage(verboseOpenedInputFile, name);
+
+		/* the file name is counted with a NUL character */
+
+		crcUpdate(crc, name, nameSize);
+		crcUpdate(crc, "\0", 1);
+
+		if (outputSinkWrite(out, "**** ", 5) && outputSinkWrite(out, exportSectionMarker(section), strlen(exportSectionMarker(section))) &&
+			outputSinkWrite(out, name, nameSize) && outputSinkWrite(out, "\n", 1))
+		{
+			if (section == EXPORT_SECTION_CFGFILE)
+				composeTextFile(fd, &buffer, &bufferSize, crc, out, false);
+			else
+				composeBinaryFile(fd, buffer, bufferSize, crc, out, (section == EXPORT_SECTION_B64FILE || section == EXPORT_SECTION_CRYPTEDB64FILE));
+
+			if (!isAnyError())
+				outputSinkWrite(out, "**** END OF FILE ****\n\n", 23);
+		}
+
+		close(fd);
+	}
+
+	crcValue = crcFinal(crc);
+
+	if (!isAnyError())
+	{
+		snprintf(trailer, sizeof(trailer), "**** END OF EXPORT %08X ****\n", crcValue);
+		outputSinkWrite(out, trailer, strlen(trailer));
+	}
+
+	if (entry)
+		free(entry);
+	buffer = clearMemory(buffer, bufferSize, true);
+	fclose(dictionary);
+	close(dirFd);
+
+	return crcValue;
+}
+
+// FRITZ!OS export file patching
+
+// compute the checksum of each indexed section on its own - the value of the whole file is the
+// combination of these values and a single section may be replaced without counting the others again
+
+EXPORTED	bool	exportIndexChecksums(exportIndexEntry_t * entries, size_t count)
+{
+	size_t				i;
+
+	for (i = 0; i < count; i++)
+	{
+		exportIndexEntry_t *	entry = &entries[i];
+		exportParser_t *	parser = exportParserNew(NULL, NULL);
+
+		if (!parser)
+			return false;
+
+		if (exportParserFeed(parser, entry->line, (entry->data + entry->size) - entry->line))
+			exportParserFinish(parser);
+
+		entry->counted = parser->crc->size;
+		entry->checksum = crcFinal(parser->crc);
+		parser->crc = NULL;
+		parser = exportParserFree(parser);
+
+		if (isAnyError())
+			return false;
+	}
+
+	return true;
+}
+
+// locate the end marker of an export file, it's searched backwards from the end of data
+
+static	char *	exportFindTrailer(char * data, size_t size)
+{
+	char *				line = data + size;
+
+	while (line > data)
+	{
+		char *			end = line - 1; /* skip newline of the previous line */
+
+		for (line = end; line > data && *(line - 1) != '\n'; line--);
+
+		if ((end - line) >= (5 + 14 + 8) && strncmp(line, "**** END OF EXPORT ", 5 + 14) == 0)
+			return line;
+	}
+
+	return NULL;
+}
+
+// replace the content of the named section with the content of a file - unchanged data is written
+// from the input buffer (it may be passed through by the kernel) and the new checksum is computed
+// from the values of all other sections and the value of the new content
+
+EXPORTED	bool	patchExportSection(char * data, size_t size, const char * name, int fd, outputSink_t * out)
+{
+	char *				trailer = exportFindTrailer(data, size);
+	exportIndexEntry_t *	entries = NULL;
+	exportIndexEntry_t *	target = NULL;
+	size_t				count = 0;
+	size_t				i;
+	char *				buffer = NULL;
+	size_t				bufferSize = 0;
+	crcCtx_t *			crc = NULL;
+	uint32_t			oldValue = 0;
+	uint32_t			newValue = 0;
+	char				digits[9];
+	bool				success = false;
+
+	if (!trailer)
+		returnError(INVALID_FILE, false);
+
+	if (!(entries = exportIndexSections(data, trailer - data, &count)))
+	{
+		if (!isAnyError())
+			setError(INVALID_FILE);
+		return false;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (entries[i].section != EXPORT_SECTION_HEADER && entries[i].nameSize == strlen(name) && strncmp(entries[i].name, name, entries[i].nameSize) == 0)
+		{
+			target = &entries[i];
+			break;
+		}
+	}
+
+	if (!target)
+	{
+		errorMessage(errorSectionNotFound, name);
+		free(entries);
+		returnError(OPTION_VALUE_INVALID, false);
+	}
+
+	if (!exportIndexChecksums(entries, count))
+	{
+		free(entries);
+		return false;
+	}
+
+	if (!reserveBuffer(&buffer, &bufferSize, 0, EXPORT_READ_SIZE) || !(crc = crcInit()))
+	{
+		buffer = clearMemory(buffer, bufferSize, true);
+		free(entries);
+		returnError(NO_MEMORY, false);
+	}
+
+	/* unchanged data up to the marker line of the section, followed by the new content */
+
+	crcUpdate(crc, target->name, target->nameSize);
+	crcUpdate(crc, "\0", 1);
+
+	if (outputSinkWriteSpan(out, data, target->data - data))
+	{
+		if (target->section == EXPORT_SECTION_CFGFILE)
+			composeTextFile(fd, &buffer, &bufferSize, crc, out, false);
+		else
+			composeBinaryFile(fd, buffer, bufferSize, crc, out, (target->section == EXPORT_SECTION_B64FILE || target->section == EXPORT_SECTION_CRYPTEDB64FILE));
+	}
+
+	if (!isAnyError())
+	{
+		size_t			counted = crc->size;
+
+		for (i = 0; i < count; i++)
+		{
+			oldValue = crcCombine(oldValue, entries[i].checksum, entries[i].counted);
+			if (&entries[i] == target)
+				newValue = crcCombine(newValue, crcFinal(crc), counted);
+			else
+				newValue = crcCombine(newValue, entries[i].checksum, entries[i].counted);
+		}
+		crc = NULL;
+
+		snprintf(digits, sizeof(digits), "%08X", oldValue);
+		if (strncmp(trailer + 5 + 14, digits, 8))
+		{
+			warningMessage(verboseChecksumWasInvalid);
+		}
+
+		snprintf(digits, sizeof(digits), "%08X", newValue);
+		verboseMessage(verboseNewChecksum, digits);
+
+		/* unchanged data after the section with the new checksum */
+
+		success = (outputSinkWriteSpan(out, target->data + target->size, (trailer + 5 + 14) - (target->data + target->size)) &&
+				   outputSinkWrite(out, digits, 8) &&
+				   outputSinkWriteSpan(out, trailer + 5 + 14 + 8, (data + size) - (trailer + 5 + 14 + 8)));
+	}
+
+	if (crc)
+		crcFinal(crc);
+	buffer = clearMemory(buffer, bufferSize, true);
+	free(entries);
+
+	return success;
+}
+
+// FRITZ!OS export file decryption
+
+// decode the lines of a binary section into a buffer, each line is decoded on its own
+
+static	size_t	exportDecodeContent(char * content, size_t contentSize, char * binary, size_t binarySize, bool base64)
+{
+	char *				text = content;
+	char *				end = content + contentSize;
+	size_t				used = 0;
+
+	while (text < end && !isAnyError())
+	{
+		char *			newline = memchr(text, '\n', end - text);
+		size_t			textSize = (newline ? (size_t) (newline - text) + 1 : (size_t) (end - text));
+
+		if (base64)
+			used += base64ToBinary(text, textSize, binary + used, binarySize - used, false, true);
+		else
+			used += hexadecimalToBinary(text, textSize, binary + used, binarySize - used);
+
+		text += textSize;
+	}
+
+	return used;
+}
+
+// decrypt the content of a CRYPTEDBINFILE or CRYPTEDB64FILE section and write it as BINFILE or B64FILE
+// section with the same encoding - the marker line is written too, the end marker is left to the caller
+
+EXPORTED	bool	exportDecryptSection(char * line, size_t lineSize, char * content, size_t contentSize, char * key, outputSink_t * out)
+{
+	exportSection_t		section = EXPORT_SECTION_NONE;
+	char *				name = NULL;
+	size_t				nameSize = 0;
+
+	if (exportMarkerType(line, lineSize, &section, &name, &nameSize) != EXPORT_MARKER_FILE ||
+		(section != EXPORT_SECTION_CRYPTEDBINFILE && section != EXPORT_SECTION_CRYPTEDB64FILE))
+		returnError(INVALID_FILE, false);
+
+	bool				base64 = (section == EXPORT_SECTION_CRYPTEDB64FILE);
+	size_t				allocated = contentSize + 8; /* the largest possible size of a decoded line is added */
+	size_t				binarySize = 0;
+	char *				binary = (char *) malloc(allocated);
+	char *				decrypted = (char *) malloc(allocated);
+	char *				data = NULL;
+	size_t				dataSize = 0;
+	char *				marker = exportSectionMarker(base64 ? EXPORT_SECTION_B64FILE : EXPORT_SECTION_BINFILE);
+	bool				success = false;
+
+	if (!binary || !decrypted)
+	{
+		if (binary)
+			free(binary);
+		if (decrypted)
+			free(decrypted);
+		returnError(NO_MEMORY, false);
+	}
+
+	/* invalid encodings are handled like wrong keys, the section is kept unchanged by the caller */
+
+	binarySize = exportDecodeContent(content, contentSize, binary, allocated, base64);
+
+	if (isAnyError() || !decryptFileData(binary, binarySize, decrypted, key, &data, &dataSize))
+	{
+		resetError();
+		setError(DECRYPT_ERR);
+	}
+	else
+	{
+		verboseMessage(verboseFileDecrypted, (int) nameSize, name, dataSize);
+
+		success = (outputSinkWrite(out, "**** ", 5) && outputSinkWrite(out, marker, strlen(marker)) &&
+				   outputSinkWrite(out, name, nameSize) && outputSinkWrite(out, "\n", 1) &&
+				   exportEncodeBinary(data, dataSize, out, base64));
+	}
+
+	binary = clearMemory(binary, allocated, true);
+	decrypted = clearMemory(decrypted, allocated, true);
+
+	return success;
+}
+
+// decrypt the content of a CRYPTEDBINFILE or CRYPTEDB64FILE section and encrypt it again with another
+// key - the decrypted blocks are used unchanged, the section is written with its marker line
+
+EXPORTED	bool	exportRekeySection(char * line, size_t lineSize, char * content, size_t contentSize, char * sourceKey, char * targetKey, outputSink_t * out)
+{
+	exportSection_t		section = EXPORT_SECTION_NONE;
+	char *				name = NULL;
+	size_t				nameSize = 0;
+
+	if (exportMarkerType(line, lineSize, &section, &name, &nameSize) != EXPORT_MARKER_FILE ||
+		(section != EXPORT_SECTION_CRYPTEDBINFILE && section != EXPORT_SECTION_CRYPTEDB64FILE))
+		returnError(INVALID_FILE, false);
+
+	bool				base64 = (section == EXPORT_SECTION_CRYPTEDB64FILE);
+	size_t				allocated = contentSize + 8; /* the largest possible size of a decoded line is added */
+	size_t				binarySize = 0;
+	char *				binary = (char *) malloc(allocated);
+	char *				decrypted = (char *) malloc(allocated);
+	char *				data = NULL;
+	size_t				dataSize = 0;
+	bool				success = false;
+
+	if (!binary || !decrypted)
+	{
+		if (binary)
+			free(binary);
+		if (decrypted)
+			free(decrypted);
+		returnError(NO_MEMORY, false);
+	}
+
+	binarySize = exportDecodeContent(content, contentSize, binary, allocated, base64);
+
+	if (isAnyError() || !decryptFileData(binary, binarySize, decrypted, sourceKey, &data, &dataSize))
+	{
+		resetError();
+		setError(DECRYPT_ERR);
+	}
+	else if (encryptFileData(decrypted, binarySize, binary, targetKey))
+	{
+		verboseMessage(verboseFileDecrypted, (int) nameSize, name, dataSize);
+
+		success = (outputSinkWrite(out, line, lineSize) && exportEncodeBinary(binary, binarySize, out, base64));
+	}
+
+	binary = clearMemory(binary, allocated, true);
+	decrypted = clearMemory(decrypted, allocated, true);
+
+	return success;
+}
+
 #pragma GCC diagnostic pop
@@ -25,9 +25,123 @@
 
 #include "common.h"
 
-// FRITZ!OS export file checksum routines
+// FRITZ!OS export file sections
 
-uint32_t	computeExportFileChecksum(memoryBuffer_t * input, FILE * out);
-void		decomposeExportFile(memoryBuffer_t * input, const char * path, bool readyForComposition);
+typedef enum {
+	EXPORT_SECTION_NONE,
+	EXPORT_SECTION_HEADER,
+	EXPORT_SECTION_CFGFILE,
+	EXPORT_SECTION_BINFILE,
+	EXPORT_SECTION_CRYPTEDBINFILE,
+	EXPORT_SECTION_B64FILE,
+	EXPORT_SECTION_CRYPTEDB64FILE,
+} exportSection_t;
+
+// marker lines
+
+typedef enum {
+	EXPORT_MARKER_NONE,				/* no marker line */
+	EXPORT_MARKER_UNKNOWN,
+	EXPORT_MARKER_HEADER,
+	EXPORT_MARKER_FILE,
+	EXPORT_MARKER_END_OF_FILE,
+	EXPORT_MARKER_END_OF_EXPORT,
+} exportMarker_t;
+
+// events from the export file parser, each input line results in exactly one event
+
+typedef enum {
+	EXPORT_EVENT_LINE,				/* empty lines, unknown markers and data outside of sections */
+	EXPORT_EVENT_HEADER_FIELD,		/* name and value of a header entry */
+	EXPORT_EVENT_SECTION_START,		/* header start or file with its name */
+	EXPORT_EVENT_TEXT_LINE,			/* line of a CFGFILE section, delayed by one line */
+	EXPORT_EVENT_BINARY_LINE,		/* line of a BINFILE or B64FILE section, decoded data is provided as value */
+	EXPORT_EVENT_SECTION_END,		/* end of file marker */
+	EXPORT_EVENT_END,				/* end of export marker with the checksum */
+} exportEventType_t;
+
+typedef struct exportEvent {
+	exportEventType_t		type;
+	exportSection_t			section;
+	char *					line;		/* raw line including its newline character */
+	size_t					lineSize;
+	size_t					position;	/* offset of the line in input data */
+	char *					name;
+	size_t					nameSize;
+	char *					value;
+	size_t					valueSize;
+	bool					last;		/* last line of a CFGFILE section, it's not part of the file */
+	uint32_t				checksum;	/* computed checksum at end of export */
+	bool					valid;		/* stored checksum is equal to the computed one */
+} exportEvent_t;
+
+typedef bool	(*exportEventHandler_t)(exportEvent_t * event, void * context);
+
+// incremental parser for export files, it's fed with chunks of arbitrary size
+
+typedef struct exportParser {
+	exportEventHandler_t	handler;
+	void *					context;
+	exportSection_t			section;
+	crcCtx_t *				crc;
+	size_t					position;
+	bool					aborted;
+	char *					partial;	/* incomplete line from the previous chunk */
+	size_t					partialSize;
+	size_t					partialAllocated;
+	char *					held;		/* delayed text line */
+	size_t					heldSize;
+	size_t					heldAllocated;
+	size_t					heldPosition;
+	bool					holding;
+	char *					decoded;	/* reusable buffer for decoded binary data */
+	size_t					decodedAllocated;
+} exportParser_t;
+
+#define	EXPORT_READ_SIZE			(64 * 1024)
+
+// index entry for a section of an export file, the data is located between the marker lines
+
+typedef struct exportIndexEntry {
+	exportSection_t			section;
+	char *					line;		/* marker line */
+	size_t					lineSize;
+	char *					name;
+	size_t					nameSize;
+	char *					data;
+	size_t					size;
+	uint32_t				checksum;	/* value of this section on its own */
+	size_t					counted;	/* number of bytes counted for the checksum */
+} exportIndexEntry_t;
+
+// parallel decomposition of export files
+
+#define	EXPORT_MAX_JOBS				64
+#define	EXPORT_WORKER_BUFFER_SIZE	(256 * 1024)
+
+// number of bytes per line for binary files
+
+#define	EXPORT_HEX_LINE_SIZE		40
+#define	EXPORT_BASE64_LINE_SIZE		48
+
+// FRITZ!OS export file routines
+
+exportParser_t *	exportParserNew(exportEventHandler_t handler, void * context);
+exportParser_t *	exportParserFree(exportParser_t * parser);
+bool				exportParserFeed(exportParser_t * parser, char * data, size_t size);
+bool				exportParserFinish(exportParser_t * parser);
+bool				exportParserReadFile(exportParser_t * parser, FILE * input);
+
+uint32_t			computeExportFileChecksum(FILE * input, outputSink_t * out);
+uint32_t			computeExportViewChecksum(memoryView_t * input, outputSink_t * out);
+bool				repairExportFileChecksum(const char * fileName, bool * changed);
+exportIndexEntry_t *	exportIndexSections(char * data, size_t size, size_t * count);
+void				decomposeExportFile(FILE * input, const char * path, bool readyForComposition);
+void				decomposeExportData(char * data, size_t size, const char * path, bool readyForComposition, unsigned int jobs);
+uint32_t			composeExportFile(const char * path, outputSink_t * out);
+bool				exportIndexChecksums(exportIndexEntry_t * entries, size_t count);
+bool				exportDecryptSection(char * line, size_t lineSize, char * content, size_t contentSize, char * key, outputSink_t * out);
+bool				exportRekeySection(char * line, size_t lineSize, char * content, size_t contentSize, char * sourceKey, char * targetKey, outputSink_t * out);
+bool				patchExportSection(char * data, size_t size, const char * name, int fd, outputSink_t * out);
 
 #endif
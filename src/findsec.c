@@ -0,0 +1,630 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#define FINDSEC_C
+
+#include "common.h"
+#include "findsec_usage.c"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+static	char *				__commandNames[] = {
+#include "findsec_commands.c"
+		NULL
+};
+static	char * *			commandNames = &__commandNames[0];
+static	commandEntry_t 		__findsec_command = { .names = &commandNames, .ep = &findsec_entry, .usage = &findsec_usage, .short_desc = &findsec_shortdesc, .usesCrypto = true };
+EXPORTED commandEntry_t *	findsec_command = &__findsec_command;
+
+// search state shared by all workers - files are taken from the list until it's exhausted or a match was
+// found with '--first'
+
+typedef struct {
+	char * *			files;
+	size_t				count;
+	size_t				next;
+	char *				keys;			/* key material for each key, one after the other */
+	size_t				keyCount;
+	char *				exportKeys;		/* keys for the password entry of export files */
+	size_t				exportKeyCount;
+	char *				pattern;
+	size_t				patternSize;
+	regex_t *			regex;			/* NULL for a literal pattern */
+	bool				ignoreCase;
+	bool				first;
+	bool				stop;
+	size_t				decrypted;
+} findSearch_t;
+
+// result of a single file, it's written in the order of the files after all workers have finished
+
+typedef struct {
+	bool				matched;
+	bool				failed;
+	bool				noExportKey;
+	size_t				offset;
+	char				name[MEMORY_VALUE_NAME_SIZE];
+} findResult_t;
+
+typedef struct {
+	findSearch_t *		search;
+	findResult_t *		results;
+	CipherContext *		ctx;
+	CipherContext *		checks[FIND_MAX_KEYS];
+	char *				value;
+	size_t				valueBufferSize;
+	size_t				decrypted;
+	bool				failed;
+	pthread_t			thread;
+} findWorker_t;
+
+// compare a decrypted value with the pattern - a literal pattern may be found anywhere within the value
+
+static	bool	findValueMatches(findSearch_t * search, char * value, size_t valueSize)
+{
+	if (search->regex)
+		return (regexec(search->regex, value, 0, NULL, 0) == 0);
+
+	if (search->patternSize > valueSize)
+		return false;
+
+	if (!search->ignoreCase)
+		return (memmem(value, valueSize, search->pattern, search->patternSize) != NULL);
+
+	for (size_t i = 0; i + search->patternSize <= valueSize; i++)
+	{
+		size_t			j;
+
+		for (j = 0; j < search->patternSize && tolower((unsigned char) value[i + j]) == tolower((unsigned char) search->pattern[j]); j++);
+
+		if (j == search->patternSize)
+			return true;
+	}
+
+	return false;
+}
+
+// check, if the data is an export file - its header line is followed by the password entry
+
+static	bool	findIsExport(char * data, size_t size)
+{
+	char *				end;
+
+	if (size < 5 || strncmp(data, "**** ", 5) || !(end = memchr(data, '\n', size)))
+		return false;
+
+	return ((size_t) (data + size - end) >= strlen(EXPORT_PASSWORD_NAME) && !memcmp(end, EXPORT_PASSWORD_NAME, strlen(EXPORT_PASSWORD_NAME)));
+}
+
+// get the key for the values of an export file - it's stored encrypted in the password entry, each key for
+// export files is tried to decrypt it; the position behind the entry is returned in 'position'
+
+static	bool	findExportKey(findWorker_t * worker, memoryIndex_t * index, char * data, char * fileKey, size_t * position)
+{
+	findSearch_t *		search = worker->search;
+	size_t				found = (char *) memchr(data, '\n', index->size) - data + strlen(EXPORT_PASSWORD_NAME);
+	size_t				valueSize = memoryIndexValueSize(index, found);
+
+	if (valueSize != 104)
+		return false;
+
+	for (size_t k = 0; k < search->exportKeyCount; k++)
+	{
+		size_t			keySize = *cipher_keyLen;
+		bool			isString = false;
+
+		if (decryptValueData(worker->ctx, data + found, valueSize, search->exportKeys + (k * *cipher_keyLen), fileKey, &keySize, &isString))
+		{
+			memset(fileKey + *cipher_ivLen, 0, *cipher_keyLen - *cipher_ivLen);
+			*position = found + valueSize;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// decrypt the values from a single file until the first match - if more than one key is used, a key is
+// checked with the first cipher block before the value is decrypted completely; each clear-text is wiped
+// after its comparison - the values of an export file are decrypted with its own key only
+
+static	void	findInFile(findWorker_t * worker, char * fileName, findResult_t * result)
+{
+	findSearch_t *		search = worker->search;
+	FILE *				file = fopen(fileName, "r");
+	memoryBuffer_t *	inputFile = NULL;
+	memoryIndex_t *		index = NULL;
+	char *				data = NULL;
+	size_t				mappedSize = 0;
+	char *				mapped = NULL;
+	size_t				position = 0;
+	char				fileKey[*cipher_keyLen];
+	char *				keys = search->keys;
+	size_t				keyCount = search->keyCount;
+
+	if (!file)
+	{
+		result->failed = true;
+		return;
+	}
+
+	if ((mapped = memoryMapFile(file, &mappedSize)) != NULL)
+	{
+		data = mapped;
+		index = memoryIndexFromData(mapped, mappedSize);
+	}
+	else if ((inputFile = memoryBufferReadFile(file, -1)) != NULL)
+	{
+		memoryBuffer_t *	consolidated = memoryBufferConsolidateData(inputFile);
+
+		inputFile = memoryBufferFreeChain(inputFile);
+		if ((inputFile = consolidated) != NULL)
+		{
+			data = inputFile->data;
+			index = memoryIndexFromData(inputFile->data, inputFile->used);
+		}
+	}
+
+	result->failed = (!data && ferror(file) != 0);
+	fclose(file);
+
+	if (!data) /* empty or unreadable file */
+		return;
+
+	if (index && findIsExport(data, index->size))
+	{
+		if (!findExportKey(worker, index, data, fileKey, &position))
+		{
+			result->noExportKey = true;
+			index = memoryIndexFree(index);
+		}
+
+		keys = fileKey;
+		keyCount = 1;
+	}
+
+	while (index && position < index->size && !__atomic_load_n(&search->stop, __ATOMIC_RELAXED))
+	{
+		size_t			found = memoryIndexFindString(index, position, "$$$$", 4);
+		size_t			valueSize;
+		char *			cipherText;
+
+		if (found == index->size)
+			break;
+
+		valueSize = memoryIndexValueSize(index, found + 4);
+		position = found + 4 + valueSize;
+		cipherText = data + found + 4;
+
+		if (!valueSize)
+			continue;
+
+		for (size_t k = 0; k < keyCount; k++)
+		{
+			size_t		dataSize = valueSize;
+			bool		isString = false;
+			bool		matched;
+
+			if (keyCount > 1 && !checkValueKey(worker->checks[k], cipherText, valueSize))
+				continue;
+
+			if (worker->valueBufferSize < valueSize + 1) /* the clear-text is never larger than its Base32 encoding */
+			{
+				worker->value = clearMemory(worker->value, worker->valueBufferSize, true);
+				worker->valueBufferSize = 0;
+
+				if (!(worker->value = (char *) malloc(valueSize + 1)))
+				{
+					worker->failed = true;
+					break;
+				}
+
+				worker->valueBufferSize = valueSize + 1;
+			}
+
+			if (!decryptValueData(worker->ctx, cipherText, valueSize, keys + (k * *cipher_keyLen), worker->value, &dataSize, &isString))
+				continue;
+
+			worker->decrypted++;
+			*(worker->value + dataSize) = 0;
+			matched = findValueMatches(search, worker->value, dataSize);
+			memset(worker->value, 0, worker->valueBufferSize);
+
+			if (matched)
+			{
+				result->matched = true;
+				result->offset = found;
+				memoryIndexValueName(index, found, result->name, sizeof(result->name));
+
+				if (search->first)
+					__atomic_store_n(&search->stop, true, __ATOMIC_RELAXED);
+			}
+
+			break;
+		}
+
+		if (result->matched || worker->failed)
+			break;
+	}
+
+	if (!index && !result->noExportKey)
+		worker->failed = true;
+
+	clearMemory(fileKey, sizeof(fileKey), false);
+	index = memoryIndexFree(index);
+	inputFile = memoryBufferFreeChain(inputFile);
+	mapped = memoryUnmapFile(mapped, mappedSize);
+}
+
+// worker thread, the calling thread is the first worker
+
+static	void *	findWorker(void * context)
+{
+	findWorker_t *		worker = (findWorker_t *) context;
+	findSearch_t *		search = worker->search;
+	size_t				next;
+
+	while (!worker->failed && !__atomic_load_n(&search->stop, __ATOMIC_RELAXED) &&
+		   (next = __atomic_fetch_add(&search->next, 1, __ATOMIC_RELAXED)) < search->count)
+		findInFile(worker, search->files[next], &worker->results[next]);
+
+	worker->value = clearMemory(worker->value, worker->valueBufferSize, true);
+	worker->valueBufferSize = 0;
+
+	return NULL;
+}
+
+// set up the cipher contexts of a worker - one for full decryption and one for the key check of each key,
+// if more than one key was specified (a single key is checked by the decryption itself)
+
+static	bool	findWorkerInit(findWorker_t * worker, findSearch_t * search, findResult_t * results)
+{
+	memset(worker, 0, sizeof(findWorker_t));
+	worker->search = search;
+	worker->results = results;
+
+	if (!(worker->ctx = CipherInit(NULL, CipherTypeValue, NULL, NULL, false)))
+		return false;
+
+	for (size_t k = 0; search->keyCount > 1 && k < search->keyCount; k++)
+	{
+		if (!(worker->checks[k] = CipherInit(NULL, CipherTypeFile, search->keys + (k * *cipher_keyLen), NULL, false)))
+			return false;
+	}
+
+	return true;
+}
+
+static	void	findWorkerCleanup(findWorker_t * worker)
+{
+	worker->ctx = (worker->ctx ? CipherCleanup(worker->ctx) : NULL);
+
+	for (size_t k = 0; k < FIND_MAX_KEYS; k++)
+		worker->checks[k] = (worker->checks[k] ? CipherCleanup(worker->checks[k]) : NULL);
+}
+
+// search all files with the specified number of parallel jobs and write the results in the order of the
+// files - with '--first' only the first match is written
+
+static	bool	findSecrets(findSearch_t * search, unsigned int jobs, outputFormat_t format, outputSink_t * out)
+{
+	findResult_t *		results = (findResult_t *) calloc(search->count, sizeof(findResult_t));
+	findWorker_t *		workers = (findWorker_t *) calloc(EXPORT_MAX_JOBS, sizeof(findWorker_t));
+	unsigned int		started = 0;
+	bool				failed = false;
+	bool				matched = false;
+
+	if (!results || !workers)
+	{
+		free(results);
+		free(workers);
+		returnError(NO_MEMORY, false);
+	}
+
+	if (jobs > search->count)
+		jobs = search->count;
+
+	for (started = 0; started < jobs; started++)
+	{
+		if (!findWorkerInit(&workers[started], search, results))
+		{
+			findWorkerCleanup(&workers[started]);
+			break;
+		}
+
+		if (started > 0 && pthread_create(&workers[started].thread, NULL, &findWorker, &workers[started]) != 0)
+		{
+			findWorkerCleanup(&workers[started]);
+			break;
+		}
+	}
+
+	if (started > 0)
+		findWorker(&workers[0]);
+
+	for (unsigned int i = 0; i < started; i++)
+	{
+		if (i > 0)
+			pthread_join(workers[i].thread, NULL);
+
+		failed = (failed || workers[i].failed);
+		search->decrypted += workers[i].decrypted;
+		findWorkerCleanup(&workers[i]);
+	}
+
+	resetError(); /* failed decryptions from the workers */
+
+	verboseMessage(verboseFilesSearched, (unsigned long) search->count, started, (unsigned long) search->decrypted);
+
+	for (size_t i = 0; i < search->count && !isAnyError(); i++)
+	{
+		findResult_t *	result = &results[i];
+		char			record[64];
+
+		if (result->failed)
+		{
+			warningMessage(errorOpeningInputFile, search->files[i]);
+			continue;
+		}
+
+		if (result->noExportKey)
+		{
+			warningMessage(verboseExportKeyNotFound, search->files[i]);
+			continue;
+		}
+
+		if (!result->matched || (search->first && matched))
+			continue;
+
+		matched = true;
+
+		if (format == OUTPUT_FORMAT_NDJSON)
+		{
+			if (!outputSinkWrite(out, "{\"file\":", 8) || !outputSinkWriteJson(out, search->files[i], strlen(search->files[i])) ||
+				!outputSinkWrite(out, record, snprintf(record, sizeof(record), ",\"offset\":%lu,\"key\":", (unsigned long) result->offset)) ||
+				!(*result->name ? outputSinkWriteJson(out, result->name, strlen(result->name)) : outputSinkWrite(out, "null", 4)) ||
+				!outputSinkWrite(out, "}\n", 2))
+				setError(WRITE_FAILED);
+		}
+		else
+		{
+			if (!outputSinkWrite(out, search->files[i], strlen(search->files[i])) ||
+				!outputSinkWrite(out, record, snprintf(record, sizeof(record), "\t%lu\t", (unsigned long) result->offset)) ||
+				!outputSinkWrite(out, (*result->name ? result->name : "-"), (*result->name ? strlen(result->name) : 1)) ||
+				!outputSinkWrite(out, "\n", 1))
+				setError(WRITE_FAILED);
+		}
+	}
+
+	if (!isAnyError() && (failed || started == 0))
+		setError(NO_MEMORY);
+
+	free(workers);
+	free(results);
+
+	return matched;
+}
+
+// 'find_secret' function - search encrypted values in many files for a clear-text and show the files,
+// which contain it
+
+int		findsec_entry(int argc, char** argv, int argo, commandEntry_t * entry)
+{
+	bool				altEnv = false;
+	bool				isRegex = false;
+	bool				ignoreCase = false;
+	bool				first = false;
+	unsigned int		jobs = 0;
+	char *				hexKeys[FIND_MAX_KEYS];
+	size_t				hexKeyCount = 0;
+	char *				password = NULL;
+	outputFormat_t		format = OUTPUT_FORMAT_TEXT;
+	int					arguments = 0;
+
+	if (argc > argo + 1)
+	{
+		int				opt;
+		int				optIndex = 0;
+
+		static struct option options_long[] = {
+			{ "regex", no_argument, NULL, 'e' },
+			{ "ignore-case", no_argument, NULL, 'i' },
+			{ "key", required_argument, NULL, 'k' },
+			{ "password", required_argument, NULL, 'p' },
+			{ "first", no_argument, NULL, '1' },
+			{ "jobs", required_argument, NULL, 'j' },
+			format_options_long,
+			altenv_options_long,
+			keycache_options_long,
+			verbosity_options_long,
+			options_long_end,
+		};
+		char *			options_short = ":" "eik:p:1j:" format_options_short altenv_options_short keycache_options_short verbosity_options_short;
+
+		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
+		{
+			switch (opt)
+			{
+				case 'e':
+					isRegex = true;
+					break;
+
+				case 'i':
+					ignoreCase = true;
+					break;
+
+				case 'k':
+					if (hexKeyCount == FIND_MAX_KEYS)
+					{
+						errorMessage(errorTooManyKeys, FIND_MAX_KEYS);
+						setError(OPTION_VALUE_INVALID);
+						return EXIT_FAILURE;
+					}
+					hexKeys[hexKeyCount++] = optarg;
+					break;
+
+				case 'p':
+					password = optarg;
+					break;
+
+				case '1':
+					first = true;
+					break;
+
+				case 'j':
+					{
+						char *	endString = NULL;
+
+						jobs = strtoul(optarg, &endString, 10);
+						if (!*optarg || *endString || jobs < 1 || jobs > EXPORT_MAX_JOBS)
+						{
+							errorMessage(errorInvalidJobCount, optarg);
+							setError(OPTION_VALUE_INVALID);
+							return EXIT_FAILURE;
+						}
+					}
+					break;
+
+				check_format_options_short();
+				check_altenv_options_short();
+				check_keycache_options_short();
+				check_verbosity_options_short();
+				help_option();
+				getopt_argument_missing();
+				getopt_invalid_option();
+				invalid_option(opt);
+			}
+		}
+		arguments = optind + argo;
+	}
+
+	if (isAnyError())
+		return EXIT_FAILURE;
+
+	if (arguments == 0 || arguments + 1 >= argc) /* the pattern and at least one file are needed */
+	{
+		errorMessage(errorMissingPatternOrFiles);
+		__autoUsage();
+		return EXIT_FAILURE;
+	}
+
+	resetError();
+
+	CipherSizes();
+
+	findSearch_t		search;
+	regex_t				regex;
+	char				keys[(hexKeyCount ? hexKeyCount : 1) * *cipher_keyLen];
+	char				exportKeys[(hexKeyCount + 1) * *cipher_keyLen];
+	bool				matched = false;
+
+	memset(&search, 0, sizeof(findSearch_t));
+	search.files = &argv[arguments + 1];
+	search.count = argc - (arguments + 1);
+	search.pattern = argv[arguments];
+	search.patternSize = strlen(argv[arguments]);
+	search.ignoreCase = ignoreCase;
+	search.first = first;
+	search.keys = keys;
+	search.exportKeys = exportKeys;
+
+	if (hexKeyCount == 0) /* the key of this device or from the alternative environment */
+	{
+		if (!keyFromArguments(keys, NULL, NULL, NULL, NULL, altEnv))
+			return EXIT_FAILURE;
+		search.keyCount = 1;
+	}
+	else
+	{
+		if (altEnv)
+		{
+			warningMessage(verboseAltEnvIgnored);
+			failOnStrict();
+		}
+
+		for (size_t k = 0; k < hexKeyCount; k++)
+		{
+			if (!keyFromArguments(keys + (k * *cipher_keyLen), hexKeys[k], NULL, NULL, NULL, false))
+			{
+				clearMemory(keys, sizeof(keys), false);
+				return EXIT_FAILURE;
+			}
+		}
+		search.keyCount = hexKeyCount;
+	}
+
+	/* the password entry of an export file may be decrypted with a hexadecimal key, with the key from
+	   the export password or with the export key of the device */
+
+	memcpy(exportKeys, keys, hexKeyCount * *cipher_keyLen);
+	search.exportKeyCount = hexKeyCount;
+
+	if (password || hexKeyCount == 0)
+	{
+		if (!exportKeyFromArguments(exportKeys + (hexKeyCount * *cipher_keyLen), password, NULL, NULL, altEnv))
+		{
+			clearMemory(keys, sizeof(keys), false);
+			clearMemory(exportKeys, sizeof(exportKeys), false);
+			return EXIT_FAILURE;
+		}
+		search.exportKeyCount++;
+	}
+
+	if (isRegex)
+	{
+		if (regcomp(&regex, search.pattern, REG_EXTENDED | REG_NOSUB | (ignoreCase ? REG_ICASE : 0)))
+		{
+			errorMessage(errorInvalidRegex, search.pattern);
+			setError(OPTION_VALUE_INVALID);
+			clearMemory(keys, sizeof(keys), false);
+			clearMemory(exportKeys, sizeof(exportKeys), false);
+			return EXIT_FAILURE;
+		}
+		search.regex = &regex;
+	}
+
+	if (jobs == 0) /* one job per processor */
+	{
+		long			cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+		jobs = (cpus > 0 ? (cpus > EXPORT_MAX_JOBS ? EXPORT_MAX_JOBS : (unsigned int) cpus) : 1);
+	}
+
+	matched = findSecrets(&search, jobs, format, outputStdout());
+
+	if (isError(NO_MEMORY))
+		errorMessage(errorNoMemory);
+
+	if (search.regex)
+		regfree(search.regex);
+	clearMemory(keys, sizeof(keys), false);
+	clearMemory(exportKeys, sizeof(exportKeys), false);
+
+	if (!outputClose())
+		errorMessage(errorWriteFailed);
+
+	return (isAnyError() || !matched ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+#pragma GCC diagnostic pop
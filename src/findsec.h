@@ -0,0 +1,43 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+#ifndef FINDSEC_H
+
+#define FINDSEC_H
+
+#include "common.h"
+
+// the number of keys, which may be specified
+
+#define	FIND_MAX_KEYS				16
+
+// function prototypes
+
+void		findsec_usage(const bool help, const bool version);
+int			findsec_entry(int argc, char** argv, int argo, commandEntry_t * entry);
+
+#ifndef FINDSEC_C
+
+extern commandEntry_t * 	findsec_command;
+
+#endif
+
+#endif
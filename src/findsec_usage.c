@@ -0,0 +1,116 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+
+// display usage help
+
+void 	findsec_usage(const bool help, UNUSED const bool version)
+{
+	FILE *	out = (help || version ? stdout : stderr);
+
+	showUsageHeader(out, help, version);
+
+	if (version)
+	{
+		fprintf(out, "\n");
+		return;
+	}
+
+	showPurposeHeader(out);
+	fprintf(out,
+		"This program decrypts the encrypted values in the specified files and writes the name of each file,\n"
+		"where a value contains the %s, to STDOUT. The decrypted values are never written anywhere.\n",
+		showUndl("pattern")
+	);
+
+	showFormatHeader(out);
+	addSpace();
+	addOption("options");
+	addSpace();
+	endOptions();
+	addSpace();
+	addArgument("pattern");
+	addSpace();
+	addArgument("file");
+	addSpace();
+	startOption();
+	addArgument("file");
+	addSpace();
+	startOption();
+	addNormalString("...");
+	endOption();
+	endOption();
+	showFormatEnd(out);
+
+	showOptionsHeader("options");
+	addOptionsEntry("-e, --regex", "the " __undl("pattern") " is an extended regular expression instead of a literal string", 0);
+	addOptionsEntry("-i, --ignore-case", "ignore the case of letters, while comparing values with the " __undl("pattern"), 0);
+	addOptionsEntry("-k, --key " __undl("key"), "try this hexadecimal " __undl("key") " to decrypt values, this option may be specified up to 16 times", 8);
+	addOptionsEntry("-p, --password " __undl("password"), "decrypt export files with the key from this export " __undl("password"), 8);
+	addOptionsEntry("-1, --first", "stop the search at the first file with a match", 0);
+	addOptionsEntry("-j, --jobs " __undl("count"), "search files with " __undl("count") " parallel jobs (the default is one job per processor)", 8);
+	addOptionsEntry("-f, --format " __undl("format"), "write the records as 'text' (the default) or as 'ndjson'", 8);
+	addOptionsEntry("-a, --alt-env " __undl("filename"), "use an alternative source for the 'urlader environment'", 8);
+	addOptionsEntry("-K, --key-cache " __undl("seconds"), "keep the device key in the kernel keyring for " __undl("seconds"), 8);
+	addOptionsEntryVerbose();
+	addOptionsEntryQuiet();
+	addOptionsEntryStrict();
+	addOptionsEntryHelp();
+	addOptionsEntryVersion();
+	showOptionsEnd(out);
+
+	fprintf(out,
+		"\nThe search within a file stops at its first value, which contains the %s (or matches the\n"
+		"regular expression). If more than one key was specified, each key is checked with the first cipher\n"
+		"block of a value, before the value is decrypted completely. If no %s was specified, the key of the\n"
+		"device (or the key from the file specified with '--alt-env') is used.\n",
+		showUndl("pattern"), showUndl("key")
+	);
+
+	fprintf(out,
+		"\nThe values of an export file are encrypted with a key of their own, which is stored in its password\n"
+		"entry. This entry is decrypted with the key from the export %s, with one of the hexadecimal\n"
+		"keys or - if neither was specified - with the export key of the device. An export file, whose\n"
+		"password entry can't be decrypted, is skipped with a warning.\n",
+		showUndl("password")
+	);
+
+	fprintf(out,
+		"\nThe files are shared between the parallel jobs. A line with the name of the file, the offset of\n"
+		"the cipher-text within the file and the name of the setting (or a dash, if it's unknown) is written\n"
+		"for each file with a match - separated by tabs and in the order of the files on the command line.\n"
+		"The 'ndjson' format writes a JSON object with the keys 'file', 'offset' and 'key' instead. With\n"
+		"'--first' the search is stopped for all files after the first match and only one file is shown.\n"
+	);
+
+	fprintf(out,
+		"\nThe exit code is zero, if a match was found, and one otherwise. A file, which can't be read, is\n"
+		"skipped with a warning.\n"
+	);
+
+	showUsageFinalize(out, help, version);
+}
+
+char *	findsec_shortdesc(void)
+{
+	return "search encrypted values in many files for a clear-text";
+}
@@ -93,19 +93,16 @@ int		hexenc_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 		size_t			toWrite = outputSize;
 		char *			out = output;
 
-		out = wrapOutput(stdout, &charsOnLine, &toWrite, out);
+		out = wrapOutput(outputStdout(), &charsOnLine, &toWrite, out);
 		if (isAnyError())
 			break;
 		
-		if ((toWrite > 0) && fwrite(out, toWrite, 1, stdout) != 1)
-		{
-			setError(WRITE_FAILED);
+		if (!outputSinkWrite(outputStdout(), out, toWrite))
 			break;
-		}
 		charsOnLine += toWrite;
 	}
 	if (!isAnyError())
-		wrapOutput(stdout, &charsOnLine, NULL, NULL);
+		wrapOutput(outputStdout(), &charsOnLine, NULL, NULL);
 	
 	if (isAnyError()) 
 	{
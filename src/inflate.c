@@ -0,0 +1,427 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#define INFLATE_C
+
+#include "common.h"
+
+// decoder state - bits are taken from the input starting with the least significant one
+
+typedef struct {
+	unsigned char *		input;
+	size_t				inputSize;
+	size_t				position;
+	uint32_t			bitBuffer;
+	int					bitCount;
+	char *				output;
+	size_t				outputSize;
+	size_t				used;
+	bool				failed;
+} inflateState_t;
+
+// canonical Huffman code - number of symbols for each code length and the symbols ordered by code
+
+typedef struct {
+	short				count[INFLATE_MAX_BITS + 1];
+	short				symbol[INFLATE_FIX_LCODES];
+} inflateHuffman_t;
+
+static	const short		lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static	const short		lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static	const short		distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static	const short		distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static	const short		codeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// get the specified number of bits (up to 16), missing input data marks the state as failed
+
+static	int		inflateBits(inflateState_t * state, int need)
+{
+	uint32_t			value = state->bitBuffer;
+
+	while (state->bitCount < need)
+	{
+		if (state->position >= state->inputSize)
+		{
+			state->failed = true;
+			return 0;
+		}
+
+		value |= (uint32_t) state->input[state->position++] << state->bitCount;
+		state->bitCount += 8;
+	}
+
+	state->bitBuffer = value >> need;
+	state->bitCount -= need;
+
+	return (int) (value & ((1U << need) - 1));
+}
+
+// make room for more output data, the buffer is doubled each time
+
+static	bool	inflateReserve(inflateState_t * state, size_t size)
+{
+	size_t				needed = state->used + size;
+	size_t				newSize = (state->outputSize ? state->outputSize : 4096);
+	char *				grown;
+
+	if (needed <= state->outputSize)
+		return true;
+
+	if (needed > INFLATE_MAX_SIZE)
+		return false;
+
+	while (newSize < needed)
+		newSize *= 2;
+
+	if (newSize > INFLATE_MAX_SIZE)
+		newSize = INFLATE_MAX_SIZE;
+
+	if (!(grown = (char *) malloc(newSize)))
+		return false;
+
+	if (state->output) /* the old buffer may contain secrets already */
+	{
+		memcpy(grown, state->output, state->used);
+		clearMemory(state->output, state->outputSize, true);
+	}
+
+	state->output = grown;
+	state->outputSize = newSize;
+
+	return true;
+}
+
+// copy a stored block, it starts at the next byte boundary
+
+static	bool	inflateStored(inflateState_t * state)
+{
+	size_t				length;
+
+	state->bitBuffer = 0;
+	state->bitCount = 0;
+
+	if (state->position + 4 > state->inputSize)
+		return false;
+
+	length = state->input[state->position] | (state->input[state->position + 1] << 8);
+
+	if (length != (size_t) (~(state->input[state->position + 2] | (state->input[state->position + 3] << 8)) & 0xFFFF))
+		return false;
+
+	state->position += 4;
+
+	if (state->position + length > state->inputSize || !inflateReserve(state, length))
+		return false;
+
+	memcpy(state->output + state->used, state->input + state->position, length);
+	state->used += length;
+	state->position += length;
+
+	return true;
+}
+
+// decode a symbol bit by bit - the codes of each length are consecutive numbers
+
+static	int		inflateDecode(inflateState_t * state, inflateHuffman_t * huffman)
+{
+	int					code = 0;
+	int					first = 0;
+	int					index = 0;
+
+	for (int length = 1; length <= INFLATE_MAX_BITS; length++)
+	{
+		int				count = huffman->count[length];
+
+		code |= inflateBits(state, 1);
+
+		if (state->failed)
+			return -1;
+
+		if (code - count < first)
+			return huffman->symbol[index + (code - first)];
+
+		index += count;
+		first = (first + count) << 1;
+		code <<= 1;
+	}
+
+	return -1;
+}
+
+// build a Huffman code from code lengths, the result is negative for an over-subscribed set of lengths
+// and positive for an incomplete one
+
+static	int		inflateConstruct(inflateHuffman_t * huffman, const short * lengths, int count)
+{
+	short				offsets[INFLATE_MAX_BITS + 1];
+	int					left = 1;
+
+	memset(huffman->count, 0, sizeof(huffman->count));
+
+	for (int symbol = 0; symbol < count; symbol++)
+		huffman->count[lengths[symbol]]++;
+
+	if (huffman->count[0] == count) /* no codes at all */
+		return 0;
+
+	for (int length = 1; length <= INFLATE_MAX_BITS; length++)
+	{
+		left = (left << 1) - huffman->count[length];
+		if (left < 0)
+			return left;
+	}
+
+	offsets[1] = 0;
+	for (int length = 1; length < INFLATE_MAX_BITS; length++)
+		offsets[length + 1] = offsets[length] + huffman->count[length];
+
+	for (int symbol = 0; symbol < count; symbol++)
+	{
+		if (lengths[symbol])
+			huffman->symbol[offsets[lengths[symbol]]++] = symbol;
+	}
+
+	return left;
+}
+
+// decode literals and length/distance pairs until the end of the block
+
+static	bool	inflateCodes(inflateState_t * state, inflateHuffman_t * lengthCode, inflateHuffman_t * distanceCode)
+{
+	int					symbol;
+
+	do
+	{
+		if ((symbol = inflateDecode(state, lengthCode)) < 0)
+			return false;
+
+		if (symbol < 256)
+		{
+			if (!inflateReserve(state, 1))
+				return false;
+
+			state->output[state->used++] = (char) symbol;
+		}
+		else if (symbol > 256)
+		{
+			size_t		length;
+			size_t		distance;
+
+			if ((symbol -= 257) >= 29)
+				return false;
+
+			length = lengthBase[symbol] + inflateBits(state, lengthExtra[symbol]);
+
+			if ((symbol = inflateDecode(state, distanceCode)) < 0 || symbol >= 30)
+				return false;
+
+			distance = distanceBase[symbol] + inflateBits(state, distanceExtra[symbol]);
+
+			if (state->failed || distance > state->used || !inflateReserve(state, length))
+				return false;
+
+			for (size_t i = 0; i < length; i++) /* source and destination may overlap */
+			{
+				state->output[state->used] = state->output[state->used - distance];
+				state->used++;
+			}
+		}
+	} while (symbol != 256);
+
+	return true;
+}
+
+// block with the fixed codes from the specification
+
+static	bool	inflateFixed(inflateState_t * state)
+{
+	inflateHuffman_t	lengthCode;
+	inflateHuffman_t	distanceCode;
+	short				lengths[INFLATE_FIX_LCODES];
+	int					symbol;
+
+	for (symbol = 0; symbol < 144; symbol++)
+		lengths[symbol] = 8;
+	for (; symbol < 256; symbol++)
+		lengths[symbol] = 9;
+	for (; symbol < 280; symbol++)
+		lengths[symbol] = 7;
+	for (; symbol < INFLATE_FIX_LCODES; symbol++)
+		lengths[symbol] = 8;
+
+	inflateConstruct(&lengthCode, lengths, INFLATE_FIX_LCODES);
+
+	for (symbol = 0; symbol < INFLATE_MAX_DCODES; symbol++)
+		lengths[symbol] = 5;
+
+	inflateConstruct(&distanceCode, lengths, INFLATE_MAX_DCODES);
+
+	return inflateCodes(state, &lengthCode, &distanceCode);
+}
+
+// block with codes, which are described at its start
+
+static	bool	inflateDynamic(inflateState_t * state)
+{
+	inflateHuffman_t	lengthCode;
+	inflateHuffman_t	distanceCode;
+	short				lengths[INFLATE_MAX_LCODES + INFLATE_MAX_DCODES];
+	int					lengthCount = inflateBits(state, 5) + 257;
+	int					distanceCount = inflateBits(state, 5) + 1;
+	int					codeCount = inflateBits(state, 4) + 4;
+	int					index;
+	int					result;
+
+	if (state->failed || lengthCount > INFLATE_MAX_LCODES || distanceCount > INFLATE_MAX_DCODES)
+		return false;
+
+	for (index = 0; index < 19; index++)
+		lengths[codeLengthOrder[index]] = (index < codeCount ? inflateBits(state, 3) : 0);
+
+	if (state->failed || inflateConstruct(&lengthCode, lengths, 19) != 0)
+		return false;
+
+	for (index = 0; index < lengthCount + distanceCount; )
+	{
+		int				symbol = inflateDecode(state, &lengthCode);
+		short			length = 0;
+		int				repeat;
+
+		if (symbol < 0)
+			return false;
+
+		if (symbol < 16)
+		{
+			lengths[index++] = symbol;
+			continue;
+		}
+
+		if (symbol == 16)
+		{
+			if (index == 0)
+				return false;
+			length = lengths[index - 1];
+			repeat = 3 + inflateBits(state, 2);
+		}
+		else if (symbol == 17)
+			repeat = 3 + inflateBits(state, 3);
+		else
+			repeat = 11 + inflateBits(state, 7);
+
+		if (state->failed || index + repeat > lengthCount + distanceCount)
+			return false;
+
+		while (repeat--)
+			lengths[index++] = length;
+	}
+
+	if (lengths[256] == 0) /* no end of block code */
+		return false;
+
+	result = inflateConstruct(&lengthCode, lengths, lengthCount);
+	if (result < 0 || (result > 0 && lengthCount - lengthCode.count[0] != 1))
+		return false;
+
+	result = inflateConstruct(&distanceCode, lengths + lengthCount, distanceCount);
+	if (result < 0 || (result > 0 && distanceCount - distanceCode.count[0] != 1))
+		return false;
+
+	return inflateCodes(state, &lengthCode, &distanceCode);
+}
+
+// check the header of a zlib stream - 'deflate' method, window size and the check bits
+
+EXPORTED	bool	inflateIsZlib(char * data, size_t size)
+{
+	unsigned char *		header = (unsigned char *) data;
+
+	return (size >= 6 && (header[0] & 0x0F) == 8 && (header[0] >> 4) <= 7 &&
+			((header[0] << 8) | header[1]) % 31 == 0 && !(header[1] & 0x20));
+}
+
+// decompress a zlib stream, the returned buffer has to be cleared and freed by the caller - the
+// Adler-32 checksum at the end is verified
+
+EXPORTED	char *	inflateZlib(char * data, size_t size, size_t sizeHint, size_t * outputSize)
+{
+	inflateState_t		state;
+	bool				last = false;
+	uint32_t			a = 1;
+	uint32_t			b = 0;
+	uint32_t			expected;
+
+	if (!inflateIsZlib(data, size))
+		returnError(INVALID_FILE, NULL);
+
+	memset(&state, 0, sizeof(state));
+	state.input = (unsigned char *) data;
+	state.inputSize = size;
+	state.position = 2;
+
+	if (sizeHint && !inflateReserve(&state, sizeHint))
+		returnError(NO_MEMORY, NULL);
+
+	while (!last && !state.failed)
+	{
+		int				type;
+		bool			success = false;
+
+		last = (inflateBits(&state, 1) == 1);
+		type = inflateBits(&state, 2);
+
+		if (state.failed)
+			break;
+
+		if (type == 0)
+			success = inflateStored(&state);
+		else if (type == 1)
+			success = inflateFixed(&state);
+		else if (type == 2)
+			success = inflateDynamic(&state);
+
+		if (!success)
+			state.failed = true;
+	}
+
+	if (!state.failed && state.position + 4 <= state.inputSize)
+	{
+		for (size_t i = 0; i < state.used; i++)
+		{
+			a = (a + (unsigned char) state.output[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+
+		expected = ((uint32_t) state.input[state.position] << 24) | ((uint32_t) state.input[state.position + 1] << 16) |
+				   ((uint32_t) state.input[state.position + 2] << 8) | (uint32_t) state.input[state.position + 3];
+
+		if (expected == ((b << 16) | a))
+		{
+			*outputSize = state.used;
+			return (state.output ? state.output : (char *) calloc(1, 1));
+		}
+	}
+
+	if (state.output)
+		clearMemory(state.output, state.outputSize, true);
+
+	returnError(INVALID_FILE, NULL);
+}
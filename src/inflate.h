@@ -0,0 +1,43 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#ifndef INFLATE_H
+
+#define INFLATE_H
+
+#include "common.h"
+
+// decompression of zlib streams (RFC 1950) with 'deflate' data (RFC 1951) - only the decoder is needed
+// for compressed TFFS nodes, a dependency on zlib isn't worth it
+
+#define	INFLATE_MAX_BITS			15
+#define	INFLATE_MAX_LCODES			286
+#define	INFLATE_MAX_DCODES			30
+#define	INFLATE_FIX_LCODES			288
+#define	INFLATE_MAX_SIZE			(64 * 1024 * 1024)	/* limit for the size of decompressed data */
+
+// function prototypes
+
+bool				inflateIsZlib(char * data, size_t size);
+char *				inflateZlib(char * data, size_t size, size_t sizeHint, size_t * outputSize);
+
+#endif
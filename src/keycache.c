@@ -0,0 +1,113 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#define KEYCACHE_C
+
+#include "common.h"
+
+// cache of device keys, the time in seconds is set from the '--key-cache' option - keys are never
+// cached without this option
+
+static	unsigned int	keyCacheTimeout = 0;
+
+EXPORTED	void	setKeyCacheTimeout(unsigned int timeout)
+{
+	keyCacheTimeout = timeout;
+}
+
+EXPORTED	unsigned int	getKeyCacheTimeout(void)
+{
+	return keyCacheTimeout;
+}
+
+// build the name of a key from the digest of an environment, keys for exports and for other data are
+// different
+
+EXPORTED	bool	keyCacheName(char * name, size_t nameSize, char * data, size_t dataSize, bool forExport)
+{
+	char				hash[MAX_DIGEST_SIZE];
+	char				hex[(MAX_DIGEST_SIZE * 2) + 1];
+	size_t				hashLen = sizeof(hash);
+	size_t				hexLen;
+	int					length;
+
+	if ((hashLen = Digest(data, dataSize, hash, hashLen)) == 0)
+		returnError(OSSL_DIGEST_ERR, false);
+
+	hexLen = binaryToHexadecimal(hash, hashLen, hex, sizeof(hex));
+	hex[hexLen] = 0;
+	clearMemory(hash, sizeof(hash), false);
+
+	length = snprintf(name, nameSize, "%s:%s:%s", KEY_CACHE_PREFIX, (forExport ? "export" : "device"), hex);
+
+	return (length > 0 && (size_t) length < nameSize);
+}
+
+// search a key in the keyrings of the process, it's only accepted with the expected size
+
+EXPORTED	bool	keyCacheLookup(char * name, char * key, size_t keySize)
+{
+	char				payload[MAX_DIGEST_SIZE];
+	long				id = syscall(SYS_request_key, KEY_CACHE_TYPE, name, NULL, 0);
+	long				size;
+
+	if (id < 0 || keySize > sizeof(payload))
+		return false;
+
+	size = syscall(SYS_keyctl, KEYCTL_READ, id, payload, sizeof(payload));
+
+	if (size < 0 || (size_t) size != keySize)
+	{
+		clearMemory(payload, sizeof(payload), false);
+		return false;
+	}
+
+	memcpy(key, payload, keySize);
+	clearMemory(payload, sizeof(payload), false);
+
+	return true;
+}
+
+// add a key to the session keyring, it's accessible only for a possessor and it expires after the
+// specified time - an existing key with the same name is updated; without an own session (e.g. for
+// jobs started by 'cron' on a FRITZ!OS device), the session keyring would exist only as long as the
+// process, the key is added to the keyring of the user then
+
+EXPORTED	bool	keyCacheStore(char * name, char * key, size_t keySize)
+{
+	long				session = syscall(SYS_keyctl, KEYCTL_GET_KEYRING_ID, KEY_SPEC_SESSION_KEYRING, 0);
+	long				userSession = syscall(SYS_keyctl, KEYCTL_GET_KEYRING_ID, KEY_SPEC_USER_SESSION_KEYRING, 0);
+	long				keyring = (session >= 0 && session != userSession ? KEY_SPEC_SESSION_KEYRING : KEY_SPEC_USER_KEYRING);
+	long				id = syscall(SYS_add_key, KEY_CACHE_TYPE, name, key, keySize, keyring);
+
+	if (id < 0)
+		return false;
+
+	if (syscall(SYS_keyctl, KEYCTL_SETPERM, id, KEY_CACHE_PERMISSIONS) < 0 ||
+		syscall(SYS_keyctl, KEYCTL_SET_TIMEOUT, id, keyCacheTimeout) < 0)
+	{
+		syscall(SYS_keyctl, KEYCTL_REVOKE, id);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,45 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#ifndef KEYCACHE_H
+
+#define KEYCACHE_H
+
+#include "common.h"
+
+// device keys in the session (or user) keyring of the kernel - the name of a key contains the checksum of the
+// environment, where it was computed from, and the key expires after the specified time
+
+#define	KEY_CACHE_TYPE				"user"
+#define	KEY_CACHE_PREFIX			"decoder"
+#define	KEY_CACHE_MAX_TIMEOUT		(7 * 24 * 60 * 60)
+#define	KEY_CACHE_PERMISSIONS		0x2F000000	/* view, read, write, search and setattr for the possessor */
+
+// function prototypes
+
+void				setKeyCacheTimeout(unsigned int timeout);
+unsigned int		getKeyCacheTimeout(void);
+bool				keyCacheName(char * name, size_t nameSize, char * data, size_t dataSize, bool forExport);
+bool				keyCacheLookup(char * name, char * key, size_t keySize);
+bool				keyCacheStore(char * name, char * key, size_t keySize);
+
+#endif
@@ -23,6 +23,10 @@
 
 #include "common.h"
 
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
 // memory buffer oriented functions
 
 static	size_t		memoryBufferSize = DEFAULT_MEMORY_BUFFER_SIZE;
@@ -32,20 +36,98 @@ EXPORTED	void	memoryBufferSetSize(size_t newSize)
 	memoryBufferSize = newSize;
 }
 
-// create a new buffer
+// values may be selected by the name of their setting, the names are taken from a comma-separated list
+
+static	char *		valueFilterNames = NULL;
+static	char * *	valueFilterList = NULL;
+static	size_t		valueFilterCount = 0;
+static	bool		valueFilterExclude = false;
+
+EXPORTED	bool	memoryValueFilterSet(char * names, bool exclude)
+{
+	char *			copy;
+	char * *		list;
+	size_t			count = 1;
+
+	if (!names || !*names)
+		returnError(OPTION_VALUE_INVALID, false);
+
+	for (char * comma = names; (comma = strchr(comma, ',')) != NULL; comma++)
+		count++;
+
+	if (!(copy = strdup(names)) || !(list = (char * *) malloc(count * sizeof(char *))))
+	{
+		if (copy)
+			free(copy);
+		returnError(NO_MEMORY, false);
+	}
+
+	if (valueFilterNames)
+		free(valueFilterNames);
+	if (valueFilterList)
+		free(valueFilterList);
+
+	valueFilterNames = copy;
+	valueFilterList = list;
+	valueFilterCount = 0;
+	valueFilterExclude = exclude;
+
+	for (char * name = strtok(copy, ","); name; name = strtok(NULL, ","))
+		valueFilterList[valueFilterCount++] = name;
+
+	return (valueFilterCount > 0);
+}
+
+// check, if the value starting at the specified position has to be decrypted - its name is searched only,
+// if a filter was set
+
+static	bool	memoryValueSelected(memoryIndex_t * index, size_t position)
+{
+	char			name[MEMORY_VALUE_NAME_SIZE];
+	size_t			nameSize;
+
+	if (!valueFilterCount)
+		return true;
+
+	nameSize = memoryIndexValueName(index, position, name, sizeof(name));
+
+	for (size_t i = 0; nameSize && i < valueFilterCount; i++)
+	{
+		if (!strcmp(name, valueFilterList[i]))
+			return !valueFilterExclude;
+	}
+
+	return valueFilterExclude;
+}
+
+// create a new buffer - large buffers are mapped from the kernel, their pages are zeroed already
 
 EXPORTED	memoryBuffer_t *	memoryBufferNew(size_t size)
 {
-	memoryBuffer_t	*new = (memoryBuffer_t *) malloc(size);
-	if (new)
+	memoryBuffer_t	*new;
+
+	if (size >= MEMORY_MAP_THRESHOLD)
+	{
+		new = (memoryBuffer_t *) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (new == MAP_FAILED)
+			return NULL;
+		new->mapped = true;
+	}
+	else
 	{
+		new = (memoryBuffer_t *) malloc(size);
+		if (!new)
+			return NULL;
 		memset(new, 0, size);
-		new->size = size;
 	}
+
+	new->size = size;
+
 	return new;
 }
 
-// free all buffers in a chain
+// free all buffers in a chain - mapped buffers are returned to the kernel, which clears their pages
+// before they're used again, smaller buffers are cleared here
 
 EXPORTED	memoryBuffer_t *	memoryBufferFreeChain(memoryBuffer_t *start)
 {
@@ -55,9 +137,14 @@ EXPORTED	memoryBuffer_t *	memoryBufferFreeChain(memoryBuffer_t *start)
 	{
 		memoryBuffer_t	*next = current->next;
 
-		/* alternative: clearMemory(current, current->size, true); */
-		memset(current, 0, current->size);
-		free(current);
+		if (current->mapped)
+			munmap(current, current->size);
+		else
+		{
+			/* data behind the used part was never written */
+			memset(current, 0, sizeof(memoryBuffer_t) + current->used);
+			free(current);
+		}
 
 		current = next;
 	}
@@ -124,6 +211,41 @@ EXPORTED	memoryBuffer_t *	memoryBufferReadFile(FILE * file, size_t chunkSize)
 	return top;
 }
 
+// map a regular file into memory, if it's read from its start - NULL is returned, if the file can't
+// be mapped and it has to be read into buffers instead
+
+EXPORTED	char *	memoryMapFile(FILE * file, size_t * size)
+{
+	struct stat		fileStat;
+	int				fd = fileno(file);
+	char *			data;
+
+	if (fd < 0 || fstat(fd, &fileStat) || !S_ISREG(fileStat.st_mode) || fileStat.st_size <= 0)
+		return NULL;
+
+	if (ftell(file) != 0 || lseek(fd, 0, SEEK_CUR) != 0) /* data was consumed already */
+		return NULL;
+
+	data = mmap(NULL, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED)
+		return NULL;
+
+	madvise(data, (size_t) fileStat.st_size, MADV_SEQUENTIAL);
+	*size = (size_t) fileStat.st_size;
+
+	return data;
+}
+
+// release a file mapping - there's nothing to wipe, the pages belong to the page cache
+
+EXPORTED	char *	memoryUnmapFile(char * data, size_t size)
+{
+	if (data)
+		munmap(data, size);
+
+	return NULL;
+}
+
 // compute the size of data stored in a memory buffer chain
 
 EXPORTED 	size_t	memoryBufferDataSize(memoryBuffer_t * top)
@@ -151,6 +273,9 @@ EXPORTED	memoryBuffer_t *	memoryBufferConsolidateData(memoryBuffer_t * start)
 
 	if (!new) return NULL;
 
+	if (new->mapped && size >= MEMORY_HUGEPAGE_THRESHOLD) /* fewer TLB misses while scanning the data */
+		madvise(new, new->size, MADV_HUGEPAGE);
+
 	char *			out = new->data;
 
 	while (current)
@@ -165,281 +290,1531 @@ EXPORTED	memoryBuffer_t *	memoryBufferConsolidateData(memoryBuffer_t * start)
 	return new;
 }
 
-// find a string in the buffer chain, handles crossing buffer borders
+// allocate an index for the specified number of segments
+
+static	memoryIndex_t *	memoryIndexAlloc(size_t count)
+{
+	memoryIndex_t	*index = (memoryIndex_t *) malloc(sizeof(memoryIndex_t));
+
+	if (!index)
+		returnError(NO_MEMORY, NULL);
+
+	memset(index, 0, sizeof(memoryIndex_t));
+
+	index->segments = (struct iovec *) malloc((count ? count : 1) * sizeof(struct iovec));
+	index->offsets = (size_t *) malloc(((count ? count : 1) + 1) * sizeof(size_t));
+
+	if (!index->segments || !index->offsets)
+	{
+		setError(NO_MEMORY);
+		return memoryIndexFree(index);
+	}
+
+	index->offsets[0] = 0;
+
+	return index;
+}
+
+// build an index for a buffer chain - an array of all segments with their cumulative start offsets,
+// any position within the chain may be resolved with a binary search then
 
-EXPORTED	char *	memoryBufferFindString(memoryBuffer_t * *buffer, size_t *offset, char *find, size_t findSize, bool *split)
+EXPORTED	memoryIndex_t *	memoryIndexNew(memoryBuffer_t * chain)
 {
-	memoryBuffer_t	*current = *buffer;
+	memoryIndex_t	*index;
+	memoryBuffer_t	*current = chain;
+	size_t			count = 0;
+
+	while (current)
+	{
+		count++;
+		current = current->next;
+	}
+
+	if (!(index = memoryIndexAlloc(count)))
+		return NULL;
 
+	current = chain;
 	while (current)
 	{
-		char *		chk = current->data + *offset;
-		size_t		remaining = current->used - *offset;
+		index->segments[index->count].iov_base = current->data;
+		index->segments[index->count].iov_len = current->used;
+		index->offsets[index->count] = index->size;
+		index->size += current->used;
+		index->count++;
+		current = current->next;
+	}
+	index->offsets[index->count] = index->size; /* sentinel for the end of data */
 
-		while (remaining > 0)
-		{
-			if (remaining < findSize)
-			{
-				if (strncmp(chk, find, remaining) == 0)
-				{
-					if (current->next)
-					{
-						if (strncmp(current->next->data, find + remaining, findSize - remaining) == 0) /* match across buffers */
-						{
-							*buffer = current;
-							*offset = (chk - current->data);
-							*split = true;
-							return chk;
-						}
-					}
-					else /* partial match at end of data */
-						return NULL;
-				}
-				chk++;
-				remaining--;
-				if (remaining == 0) /* next buffer, if any */
-				{
-					if (current->next)
-					{
-						current = current->next;
-						remaining = current->used;
-						chk = current->data;
-					}
-					else /* no match */
-						return NULL;
-				}
-			}
-			else
-			{
-				if (strncmp(chk, find, findSize) == 0)
-				{
-					*buffer = current;
-					*offset = (chk - current->data);
-					*split = false;
-					return chk;
-				}
-				chk++;
-				remaining--;
-			}
-		}
+	return index;
+}
+
+// build an index for a single memory region, e.g. a file mapped into memory
+
+EXPORTED	memoryIndex_t *	memoryIndexFromData(char * data, size_t size)
+{
+	memoryIndex_t	*index = memoryIndexAlloc(1);
+
+	if (index)
+	{
+		index->segments[0].iov_base = data;
+		index->segments[0].iov_len = size;
+		index->count = 1;
+		index->size = size;
+		index->offsets[1] = size;
 	}
+
+	return index;
+}
+
+// release an index, the indexed buffers remain unchanged
+
+EXPORTED	memoryIndex_t *	memoryIndexFree(memoryIndex_t * index)
+{
+	if (!index)
+		return NULL;
+
+	free(index->segments);
+	free(index->offsets);
+	free(index);
+
 	return NULL;
 }
 
-// advance a pointer value, following the buffer chain, if a buffer is exhausted
+// get the segment number and the offset within this segment for a position - a position at the end of
+// data returns the segment count
 
-EXPORTED	char *	memoryBufferAdvancePointer(memoryBuffer_t * *buffer, size_t *lastOffset, size_t offset)
+EXPORTED	size_t	memoryIndexLocate(memoryIndex_t * index, size_t position, size_t * offset)
 {
-	memoryBuffer_t	*current = *buffer;
-	size_t			advance = offset;
+	size_t			low = 0;
+	size_t			high = index->count;
 
-	while (current)
+	if (position >= index->size)
 	{
-		if ((current->used - *lastOffset) < advance) /* next buffer */
-		{
-			if (current->next)
-			{
-				advance -= (current->used - *lastOffset);
-				current = current->next;
-				*buffer = current;
-				*lastOffset = 0;
-				continue;
-			}
-		}
+		if (offset)
+			*offset = 0;
+		return index->count;
+	}
 
-		*lastOffset += advance;
+	while (high - low > 1)
+	{
+		size_t		middle = low + (high - low) / 2;
 
-		return (current->data + *lastOffset);
+		if (index->offsets[middle] <= position)
+			low = middle;
+		else
+			high = middle;
 	}
 
-	return NULL;
+	while (low < index->count && index->segments[low].iov_len == 0) /* skip empty segments */
+		low++;
+
+	if (offset)
+		*offset = position - index->offsets[low];
+
+	return low;
 }
 
-// find the first non-Base32 character from the specified pointer
+// compare data at the specified position with a string, the data may cross segment borders
 
-EXPORTED	char *	memoryBufferSearchValueEnd(memoryBuffer_t * *buffer, size_t *offset, size_t * size, bool *split)
+static	bool	memoryIndexMatch(memoryIndex_t * index, size_t segment, size_t offset, char * find, size_t findSize)
 {
-	memoryBuffer_t	*current = *buffer;
-	size_t			currentOffset = *offset;
-	size_t			count = 0;
-	char *			position = current->data + currentOffset;
+	while (findSize > 0 && segment < index->count)
+	{
+		struct iovec	*current = index->segments + segment;
+		size_t			size = current->iov_len - offset;
 
-	*split = false;
-	while (current)
+		if (size > findSize)
+			size = findSize;
+
+		if (memcmp((char *) current->iov_base + offset, find, size))
+			return false;
+
+		find += size;
+		findSize -= size;
+		segment++;
+		offset = 0;
+	}
+
+	return (findSize == 0);
+}
+
+// find a string starting at the specified position, handles crossing segment borders - returns the position
+// of the first match or the size of indexed data, if there's no match
+
+EXPORTED	size_t	memoryIndexFindString(memoryIndex_t * index, size_t position, char * find, size_t findSize)
+{
+	size_t			offset;
+	size_t			segment = memoryIndexLocate(index, position, &offset);
+
+	if (!findSize)
+		return position;
+
+	for (; segment < index->count; segment++, offset = 0)
 	{
-		if (current->used <= currentOffset) /* next buffer */
+		struct iovec	*current = index->segments + segment;
+		char *			start = (char *) current->iov_base + offset;
+		char *			end = (char *) current->iov_base + current->iov_len;
+
+		while (start < end && (start = memchr(start, *find, end - start)) != NULL)
 		{
-			if (current->next)
-			{
-				current = current->next;
-				currentOffset = 0;
-				position = current->data;
-				*split = true;
-			}
+			size_t		remaining = end - start;
+
+			if ((remaining >= findSize && memcmp(start, find, findSize) == 0) ||
+				(remaining < findSize && memoryIndexMatch(index, segment, start - (char *) current->iov_base, find, findSize))) /* match across segments */
+				return index->offsets[segment] + (start - (char *) current->iov_base);
+			start++;
 		}
+	}
+
+	return index->size;
+}
+
+// get the size of a Base32 value starting at the specified position, the end of data terminates a value too
+
+EXPORTED	size_t	memoryIndexValueSize(memoryIndex_t * index, size_t position)
+{
+	size_t			offset;
+	size_t			segment = memoryIndexLocate(index, position, &offset);
+	size_t			count = 0;
+
+	for (; segment < index->count; segment++, offset = 0)
+	{
+		struct iovec	*current = index->segments + segment;
 
-		if ((*position >= 'A' && *position <= 'Z') || (*position >= '1' && *position <= '6'))
+		while (offset < current->iov_len)
 		{
+			char		c = *((char *) current->iov_base + offset);
+
+			if (!((c >= 'A' && c <= 'Z') || (c >= '1' && c <= '6'))) /* character outside of our Base32 set found */
+				return count;
+
 			count++;
-			position++;
-			currentOffset++;
+			offset++;
 		}
-		else /* character outside of our Base32 set found */
-		{
-			*buffer = current;
-			*offset = currentOffset;
-			*size = count;
+	}
+
+	return count;
+}
+
+// count the newline characters in a range of indexed data
+
+EXPORTED	size_t	memoryIndexCountLines(memoryIndex_t * index, size_t position, size_t end)
+{
+	size_t			offset;
+	size_t			segment = memoryIndexLocate(index, position, &offset);
+	size_t			size = (end > position ? end - position : 0);
+	size_t			count = 0;
+
+	for (; size > 0 && segment < index->count; segment++, offset = 0)
+	{
+		struct iovec	*current = index->segments + segment;
+		char *			start = (char *) current->iov_base + offset;
+		char *			last;
+		size_t			available = current->iov_len - offset;
 
-			return position;
+		if (available > size)
+			available = size;
+
+		last = start + available;
+		size -= available;
+
+		while (start < last && (start = memchr(start, '\n', last - start)) != NULL)
+		{
+			count++;
+			start++;
 		}
 	}
 
-	return NULL;	
+	return count;
 }
 
-// scan memory buffer and replace occurrences of encrypted data while writing data to output;
-// if no output file is used (NULL), input data has to be contained in a single buffer and cipher-text
-// values are replaced with the corresponding clear-text in this buffer ... gaps are marked with 0xFF
-// and a 16 bit integer containing the offset from 0xFF to the next valid character
+// get the name of the setting, which is assigned the value starting at the specified position - the
+// data in front of it is searched backwards for a name, an equal sign and an optional quotation mark
+// (white space is allowed between them); the name is copied to the buffer with a terminating NUL
+// character and its size is returned, a value without a name results in an empty string
 
-EXPORTED	bool	memoryBufferProcessFile(memoryBuffer_t * *buffer, size_t offset, char * key, FILE * out, UNUSED char * filesKey)
+EXPORTED	size_t	memoryIndexValueName(memoryIndex_t * index, size_t position, char * name, size_t nameSize)
 {
-	CipherContext 		*ctx = CipherInit(NULL, CipherTypeValue, NULL, NULL, false);
-	memoryBuffer_t 		*current = *buffer;
-	size_t				currentOffset = offset;
-	
-	while (current)
+	char			data[MEMORY_VALUE_NAME_LOOKBACK];
+	size_t			size = (position < sizeof(data) ? position : sizeof(data));
+	size_t			start = position - size;
+	char *			end;
+	char *			current;
+
+	if (nameSize)
+		*name = 0;
+
+	for (size_t offset = 0; offset < size; ) /* the range may cross segment borders */
 	{
-		memoryBuffer_t	*found = current;
-		size_t			foundOffset = currentOffset;
-		bool			split = false;
-		char *			cipherTextStart;
-		char *			outputStart = NULL;
+		struct iovec	single;
 
-		if ((cipherTextStart = memoryBufferFindString(&found, &foundOffset, "$$$$", 4, &split)) != NULL) /* encrypted data exists */
-		{
-			if (!out)
-				outputStart = cipherTextStart;
+		if (!memoryIndexGetVector(index, start + offset, size - offset, &single, 1))
+			return 0;
 
-			while (current && (current != found)) /* output data crosses at least one buffer boundary */
-			{
-				if (out && fwrite(current->data + currentOffset, current->used - currentOffset, 1, out) != 1)
-				{
-					setError(WRITE_FAILED);
-					current = NULL;
-					break;
-				}
+		memcpy(data + offset, single.iov_base, single.iov_len);
+		offset += single.iov_len;
+	}
 
-				current = current->next;
-				currentOffset = 0;
-			}
-			if (current && foundOffset > 0)
-			{
-				if (out && fwrite(current->data + currentOffset, foundOffset - currentOffset, 1, out) != 1)
-				{
-					setError(WRITE_FAILED);
-					current = NULL;
-					break;
-				}
+	current = data + size;
 
-				currentOffset = foundOffset;
-			}
-			cipherTextStart = memoryBufferAdvancePointer(&current, &currentOffset, 4);
-			found = current;
-			foundOffset = currentOffset;
+	if (current > data && *(current - 1) == '"')
+		current--;
 
-			size_t		valueSize;
-			char *		cipherTextEnd = memoryBufferSearchValueEnd(&found, &foundOffset, &valueSize, &split);
-			if (cipherTextEnd)
-			{
-				char *	copy;
-				char *	cipherText = (char *) malloc(valueSize + 1);
+	while (current > data && (*(current - 1) == ' ' || *(current - 1) == '\t'))
+		current--;
 
-				memset(cipherText, 0, valueSize + 1);
-				copy = cipherText;
-				while (current && (current != found))
-				{
-					memcpy(copy, current->data + currentOffset, current->used - currentOffset);
-					copy += (current->used - currentOffset);
-					current = current->next;
-					currentOffset = 0;
-				}
+	if (current == data || *(current - 1) != '=')
+		return 0;
 
-				memcpy(copy, current->data + currentOffset, foundOffset - currentOffset);
-				*(cipherText + valueSize) = 0;
+	current--;
 
-				if (!decryptValue(ctx, cipherText, valueSize, out, (out ? NULL : outputStart), key, true)) /* unable to decrypt, write data as is */
-				{
-					if (out)
-					{
-						if (fwrite("$$$$", 4, 1, out) != 1 ||
-							fwrite(current->data + currentOffset, foundOffset - currentOffset, 1, out) != 1)
-						{
-							setError(WRITE_FAILED);
-							current = NULL;
-						}
-						else
-						{
-							current = found;
-							currentOffset = foundOffset;
-						}
-					}
-				}
-				else
-				{
-					if (!out)	/* set number of bytes to skip to get the next valid position */
-					{
-						while (*outputStart != '\xFF')
-						{
-							outputStart++;
-						}
-						*((uint16_t *) ((char *) outputStart + 1)) = (uint16_t) ((found->data + foundOffset) - outputStart);
-					}
-					current = found;
-					currentOffset = foundOffset;
-				}
+	while (current > data && (*(current - 1) == ' ' || *(current - 1) == '\t'))
+		current--;
 
-				free(cipherText);
-			}
-		}
-		else /* no more encrypted data, write remaining buffers */
+	end = current;
+
+	while (current > data && (isalnum((unsigned char) *(current - 1)) || *(current - 1) == '_' || *(current - 1) == '-'))
+		current--;
+
+	if (current == end || (size_t) (end - current) >= nameSize)
+		return 0;
+
+	memcpy(name, current, end - current);
+	*(name + (end - current)) = 0;
+
+	return (end - current);
+}
+
+// describe a range of indexed data as a vector of memory spans without copying it - the number of needed
+// elements is returned, only the specified count of elements is set, if more are needed
+
+EXPORTED	int		memoryIndexGetVector(memoryIndex_t * index, size_t position, size_t size, struct iovec * vector, int count)
+{
+	size_t			offset;
+	size_t			segment = memoryIndexLocate(index, position, &offset);
+	int				used = 0;
+
+	for (; size > 0 && segment < index->count; segment++, offset = 0)
+	{
+		struct iovec	*current = index->segments + segment;
+		size_t			available = current->iov_len - offset;
+
+		if (!available)
+			continue;
+
+		if (available > size)
+			available = size;
+
+		if (used < count)
 		{
-			if (out)
-			{
-				while (current)
-				{
-					if (fwrite(current->data + currentOffset, current->used - currentOffset, 1, out) != 1)
-					{
-						setError(WRITE_FAILED);
-						current = NULL;
-						break;
-					}
-
-					current = current->next;
-					currentOffset = 0;
-				}
-			}
-			else
-				break;
+			vector[used].iov_base = (char *) current->iov_base + offset;
+			vector[used].iov_len = available;
 		}
+
+		used++;
+		size -= available;
 	}
 
-	ctx = CipherCleanup(ctx);
+	return used;
+}
 
-	return !isAnyError();
+// write a range of indexed data to an output sink, the data isn't copied
+
+EXPORTED	bool	memoryIndexWrite(memoryIndex_t * index, size_t position, size_t size, outputSink_t * out)
+{
+	size_t			offset;
+	size_t			segment = memoryIndexLocate(index, position, &offset);
+
+	for (; size > 0 && segment < index->count; segment++, offset = 0)
+	{
+		struct iovec	*current = index->segments + segment;
+		size_t			available = current->iov_len - offset;
+
+		if (available > size)
+			available = size;
+
+		if (!outputSinkWriteSpan(out, (char *) current->iov_base + offset, available))
+			return false;
 
+		size -= available;
+	}
+
+	return true;
 }
 
-// free memory after clearing its content
+// get a contiguous copy of a range of indexed data, if it crosses a segment border - the returned
+// pointer has to be released with clearMemory(), if it's not equal to the returned range
 
-void *	clearMemory(void * buffer, size_t size, bool freeBuffer)
+static	char *	memoryIndexGetRange(memoryIndex_t * index, size_t position, size_t size, bool * copied)
 {
-	if (buffer)
+	struct iovec	single;
+	int				count = memoryIndexGetVector(index, position, size, &single, 1);
+	char *			copy;
+
+	*copied = false;
+
+	if (count <= 1)
+		return (count ? (char *) single.iov_base : "");
+
+	if (!(copy = (char *) malloc(size)))
+		returnError(NO_MEMORY, NULL);
+
+	for (size_t offset = 0; offset < size; )
 	{
-		memset(buffer, 0, size);
+		count = memoryIndexGetVector(index, position + offset, size - offset, &single, 1);
+		memcpy(copy + offset, single.iov_base, single.iov_len);
+		offset += single.iov_len;
+	}
 
-		if (freeBuffer) free(buffer);
+	*copied = true;
+
+	return copy;
+}
+
+// a vector of memory spans for values, which are located one by one - most of them don't cross any
+// segment border or only a single one
+
+typedef struct memorySpans {
+	struct iovec		pair[2];
+	struct iovec *		vector;
+	int					size;			/* number of available elements */
+	int					count;			/* number of used elements */
+} memorySpans_t;
+
+static	void	memorySpansInit(memorySpans_t * spans)
+{
+	spans->vector = spans->pair;
+	spans->size = sizeof(spans->pair) / sizeof(struct iovec);
+	spans->count = 0;
+}
+
+static	void	memorySpansFree(memorySpans_t * spans)
+{
+	if (spans->vector != spans->pair)
+		free(spans->vector);
+
+	memorySpansInit(spans);
+}
+
+// describe a range of indexed data with the spans, the vector is enlarged, if it's too small
+
+static	bool	memoryIndexGetSpans(memoryIndex_t * index, size_t position, size_t size, memorySpans_t * spans)
+{
+	int				count = memoryIndexGetVector(index, position, size, spans->vector, spans->size);
+
+	if (count > spans->size) /* value crosses more segments than expected, e.g. with a really small block size */
+	{
+		struct iovec	*larger = (struct iovec *) malloc(count * sizeof(struct iovec));
+
+		if (!larger)
+			returnError(NO_MEMORY, false);
+
+		memorySpansFree(spans);
+		spans->vector = larger;
+		spans->size = count;
+		memoryIndexGetVector(index, position, size, spans->vector, spans->size);
 	}
 
-	return NULL;
+	spans->count = count;
+
+	return true;
+}
+
+// decrypt an encrypted file section starting at the specified position, the position of the next marker
+// line is returned - a file, which can't be decrypted, is written unchanged (or it's an error in strict mode)
+
+static	size_t	memoryIndexDecryptFile(memoryIndex_t * index, size_t position, char * key, outputSink_t * out)
+{
+	size_t			content = memoryIndexFindString(index, position, "\n", 1);
+	size_t			end;
+	char *			line;
+	char *			data = NULL;
+	bool			lineCopied = false;
+	bool			dataCopied = false;
+
+	content = (content < index->size ? content + 1 : index->size);
+	end = memoryIndexFindString(index, content, "\n**** ", 6);
+	end = (end < index->size ? end + 1 : index->size);
+
+	if ((line = memoryIndexGetRange(index, position, content - position, &lineCopied)) != NULL &&
+		(data = memoryIndexGetRange(index, content, end - content, &dataCopied)) != NULL &&
+		!exportDecryptSection(line, content - position, data, end - content, key, out) && isError(DECRYPT_ERR))
+	{
+		char *		name = memchr(line, ':', content - position);
+		size_t		nameSize = (name ? (line + (content - position)) - ++name : 0);
+
+		if (nameSize > 0 && *(name + nameSize - 1) == '\n')
+			nameSize--;
+
+		warningMessage(verboseFileNotDecrypted, (int) nameSize, (name ? name : ""));
+		resetError();
+		if (!isStrict())
+			memoryIndexWrite(index, position, end - position, out);
+		else
+			setError(WARNING_ISSUED);
+	}
+
+	if (lineCopied)
+		clearMemory(line, content - position, true);
+	if (dataCopied)
+		clearMemory(data, end - content, true);
+
+	return end;
 }
+
+// decrypted values are remembered while a file is processed, a repeated cipher-text (e.g. the same
+// password in more than one section or in more than one backup) is replaced without another decryption
+
+typedef struct valueMemoEntry {
+	uint32_t			hash;
+	bool				isString;
+	size_t				textSize;
+	size_t				valueSize;
+	size_t				escapedSize;
+	size_t				size;			/* allocated size of the entry */
+	char *				text;			/* Base32 cipher-text */
+	char *				value;			/* clear-text, terminated by a NUL character */
+	char *				escaped;		/* output form, it's the clear-text, if nothing has to be escaped */
+} valueMemoEntry_t;
+
+typedef struct valueMemo {
+	valueMemoEntry_t * *	slots;
+	size_t				capacity;		/* number of slots, a power of two */
+	size_t				count;
+	size_t				used;			/* memory used by entries and slots */
+	size_t				values;
+	size_t				duplicates;
+	size_t				failed;			/* values, which couldn't be decrypted */
+} valueMemo_t;
+
+// FNV-1a hash of the cipher-text, it's computed over all spans without joining them
+
+static	uint32_t	valueMemoHash(struct iovec * text, int count)
+{
+	uint32_t			hash = 2166136261U;
+
+	for (int i = 0; i < count; i++)
+	{
+		for (size_t j = 0; j < text[i].iov_len; j++)
+			hash = (hash ^ *((unsigned char *) text[i].iov_base + j)) * 16777619U;
+	}
+
+	return hash;
+}
+
+// compare a remembered cipher-text with the spans of another one
+
+static	bool	valueMemoEqual(valueMemoEntry_t * entry, struct iovec * text, int count, size_t size)
+{
+	size_t				offset = 0;
+
+	if (entry->textSize != size)
+		return false;
+
+	for (int i = 0; i < count; i++)
+	{
+		if (memcmp(entry->text + offset, text[i].iov_base, text[i].iov_len))
+			return false;
+
+		offset += text[i].iov_len;
+	}
+
+	return true;
+}
+
+// find an entry or the free slot for it - a missing table has no free slot
+
+static	valueMemoEntry_t *	valueMemoFind(valueMemo_t * memo, struct iovec * text, int count, size_t size, uint32_t hash, size_t * slot)
+{
+	*slot = memo->capacity;
+
+	if (!memo->slots)
+		return NULL;
+
+	for (size_t i = hash & (memo->capacity - 1); ; i = (i + 1) & (memo->capacity - 1))
+	{
+		valueMemoEntry_t *	entry = memo->slots[i];
+
+		if (!entry)
+		{
+			*slot = i;
+			return NULL;
+		}
+
+		if (entry->hash == hash && valueMemoEqual(entry, text, count, size))
+			return entry;
+	}
+}
+
+// double the number of slots, the table is kept at most half full
+
+static	bool	valueMemoGrow(valueMemo_t * memo)
+{
+	size_t				capacity = (memo->capacity ? memo->capacity * 2 : 256);
+	valueMemoEntry_t * *	slots;
+
+	if (memo->used + (capacity * sizeof(valueMemoEntry_t *)) > MEMORY_VALUE_MEMO_SIZE ||
+		!(slots = (valueMemoEntry_t * *) calloc(capacity, sizeof(valueMemoEntry_t *))))
+		return false;
+
+	for (size_t i = 0; i < memo->capacity; i++)
+	{
+		valueMemoEntry_t *	entry = memo->slots[i];
+		size_t			j;
+
+		if (!entry)
+			continue;
+
+		for (j = entry->hash & (capacity - 1); slots[j]; j = (j + 1) & (capacity - 1));
+		slots[j] = entry;
+	}
+
+	if (memo->slots)
+	{
+		free(memo->slots);
+		memo->used -= memo->capacity * sizeof(valueMemoEntry_t *);
+	}
+
+	memo->slots = slots;
+	memo->capacity = capacity;
+	memo->used += capacity * sizeof(valueMemoEntry_t *);
+
+	return true;
+}
+
+// remember a decrypted value, nothing is stored (and no error is set), if the memory limit was reached -
+// the spans of the cipher-text are joined in the entry
+
+static	valueMemoEntry_t *	valueMemoAdd(valueMemo_t * memo, struct iovec * text, int count, size_t textSize, uint32_t hash, char * value, size_t valueSize, bool isString)
+{
+	valueMemoEntry_t *	entry;
+	size_t				escapes = 0;
+	size_t				offset = 0;
+	size_t				size;
+	size_t				slot;
+
+	for (size_t i = 0; i < valueSize; i++)
+	{
+		if (*(value + i) == '\\' || *(value + i) == '"')
+			escapes++;
+	}
+
+	size = sizeof(valueMemoEntry_t) + textSize + valueSize + 1 + (escapes ? valueSize + escapes : 0);
+
+	if (memo->used + size > MEMORY_VALUE_MEMO_SIZE)
+		return NULL;
+
+	if ((memo->count + 1) * 2 > memo->capacity && !valueMemoGrow(memo))
+		return NULL;
+
+	valueMemoFind(memo, text, count, textSize, hash, &slot);
+
+	if (slot == memo->capacity || !(entry = (valueMemoEntry_t *) malloc(size)))
+		return NULL;
+
+	entry->hash = hash;
+	entry->isString = isString;
+	entry->size = size;
+	entry->textSize = textSize;
+	entry->text = (char *) (entry + 1);
+
+	for (int i = 0; i < count; i++)
+	{
+		memcpy(entry->text + offset, text[i].iov_base, text[i].iov_len);
+		offset += text[i].iov_len;
+	}
+
+	entry->valueSize = valueSize;
+	entry->value = entry->text + textSize;
+	memcpy(entry->value, value, valueSize);
+	*(entry->value + valueSize) = 0;
+	entry->escapedSize = valueSize + escapes;
+	entry->escaped = entry->value;
+
+	if (escapes) /* same escapes as with writeDecryptedValue() */
+	{
+		char *			escaped = entry->value + valueSize + 1;
+
+		entry->escaped = escaped;
+
+		for (size_t i = 0; i < valueSize; i++)
+		{
+			if (*(value + i) == '\\' || *(value + i) == '"')
+				*escaped++ = '\\';
+			*escaped++ = *(value + i);
+		}
+	}
+
+	memo->slots[slot] = entry;
+	memo->count++;
+	memo->used += size;
+
+	return entry;
+}
+
+// remove all remembered values, their memory is cleared
+
+static	void	valueMemoFree(valueMemo_t * memo)
+{
+	for (size_t i = 0; i < memo->capacity; i++)
+	{
+		if (memo->slots[i])
+			clearMemory(memo->slots[i], memo->slots[i]->size, true);
+	}
+
+	if (memo->slots)
+		free(memo->slots);
+
+	memset(memo, 0, sizeof(valueMemo_t));
+}
+
+// show a found cipher-text in verbose mode, it isn't terminated in the input data
+
+static	void	memoryShowCipherVector(struct iovec * text, int count)
+{
+	size_t				size = 0;
+	char *				copy;
+
+	if (!isVerbose())
+		return;
+
+	for (int i = 0; i < count; i++)
+		size += text[i].iov_len;
+
+	if (!(copy = (char *) malloc(size + 1)))
+		return;
+
+	size = 0;
+	for (int i = 0; i < count; i++)
+	{
+		memcpy(copy + size, text[i].iov_base, text[i].iov_len);
+		size += text[i].iov_len;
+	}
+	*(copy + size) = 0;
+	verboseMessage(verboseFoundCipherText, copy);
+	free(copy);
+}
+
+// show a found cipher-text from a single buffer
+
+EXPORTED	void	memoryShowCipherText(char * text, size_t size)
+{
+	struct iovec		single = { .iov_base = text, .iov_len = size };
+
+	memoryShowCipherVector(&single, 1);
+}
+
+// get the clear-text of a value from the values seen before, from a cache or by decryption - the result
+// is a memo entry or (if the memo is full) the value buffer, a failed decryption is counted, but it isn't
+// an error; the cipher-text is used from the input buffers, it's only copied into the memo
+
+static	bool	memoryIndexClearText(memoryIndex_t * index, size_t found, size_t valueSize, char * key, valueCache_t * cache, valueMemo_t * memo, memorySpans_t * spans, CipherContext * ctx, char * *value, size_t * valueBufferSize, valueMemoEntry_t * *entry, size_t * dataSize, bool * isString)
+{
+	bool				cached = false;
+	bool				success = false;
+	uint32_t			hash;
+	size_t				slot;
+
+	*entry = NULL;
+
+	if (!memoryIndexGetSpans(index, found + 4, valueSize, spans))
+		return false;
+
+	hash = valueMemoHash(spans->vector, spans->count);
+	memo->values++;
+	memoryShowCipherVector(spans->vector, spans->count);
+
+	if ((*entry = valueMemoFind(memo, spans->vector, spans->count, valueSize, hash, &slot)) != NULL) /* repeated value */
+	{
+		memo->duplicates++;
+		showDecryptedValue((*entry)->value, (*entry)->valueSize, (*entry)->isString);
+		return true;
+	}
+
+	if (*valueBufferSize < valueSize + 1) /* the clear-text is never larger than its Base32 encoding */
+	{
+		*value = clearMemory(*value, *valueBufferSize, true);
+		*valueBufferSize = 0;
+
+		if (!(*value = (char *) malloc(valueSize + 1)))
+			returnError(NO_MEMORY, false);
+
+		*valueBufferSize = valueSize + 1;
+	}
+
+	*dataSize = valueSize;
+
+	if ((cache && (cached = valueCacheLookup(cache, spans->vector, spans->count, valueSize, *value, dataSize, isString))) ||
+		decryptValueDataVector(ctx, spans->vector, spans->count, key, *value, dataSize, isString))
+	{
+		*(*value + *dataSize) = 0;
+
+		if (cache && !cached)
+			valueCacheStore(cache, spans->vector, spans->count, *value, *dataSize, *isString);
+
+		showDecryptedValue(*value, *dataSize, *isString);
+		*entry = valueMemoAdd(memo, spans->vector, spans->count, valueSize, hash, *value, *dataSize, *isString);
+		success = true;
+	}
+	else
+	{
+		resetError();
+		warningMessageNoApplet(verboseDecryptFailed);
+		memo->failed++;
+	}
+
+	return success;
+}
+
+// decrypt a value or take it from the values seen before (or from a cache) - the clear-text of a new
+// value is remembered and a value, which can't be decrypted, is written unchanged
+
+static	bool	memoryIndexDecryptValue(memoryIndex_t * index, size_t found, size_t valueSize, char * key, valueCache_t * cache, valueMemo_t * memo, memorySpans_t * spans, CipherContext * ctx, char * *value, size_t * valueBufferSize, outputSink_t * out)
+{
+	valueMemoEntry_t *	entry = NULL;
+	size_t				dataSize = 0;
+	bool				isString = false;
+	bool				success;
+
+	if (memoryIndexClearText(index, found, valueSize, key, cache, memo, spans, ctx, value, valueBufferSize, &entry, &dataSize, &isString))
+	{
+		if (entry)
+			success = outputSinkWrite(out, entry->escaped, entry->escapedSize);
+		else
+			success = writeDecryptedValue(out, *value, dataSize, true);
+	}
+	else if (isAnyError())
+		return false;
+	else /* unable to decrypt, write data as is */
+		success = memoryIndexWrite(index, found, valueSize + 4, out);
+
+	if (*value)
+		memset(*value, 0, *valueBufferSize);
+
+	return success;
+}
+
+// scan indexed data and replace occurrences of encrypted data while writing data to output; unchanged
+// data is written from the input buffers, so they have to be kept until the sink was flushed - encrypted
+// files are decrypted too, if a key for them was specified; if any value couldn't be decrypted, DECRYPT_ERR
+// is set after all data was written
+
+EXPORTED	bool	memoryBufferProcessFile(memoryIndex_t * index, size_t position, char * key, outputSink_t * out, char * filesKey, valueCache_t * cache)
+{
+	CipherContext 		*ctx = CipherInit(NULL, CipherTypeValue, NULL, NULL, false);
+	size_t				file = (filesKey ? 0 : index->size); /* position of the next encrypted file */
+	char *				value = NULL;
+	size_t				valueBufferSize = 0;
+	valueMemo_t			memo;
+	memorySpans_t		spans;
+	size_t				skipped = 0;
+
+	memset(&memo, 0, sizeof(valueMemo_t));
+	memorySpansInit(&spans);
+
+	while (position < index->size)
+	{
+		size_t			found = memoryIndexFindString(index, position, "$$$$", 4);
+
+		if (filesKey && (file < position || file == 0)) /* search the next encrypted file, it has to start on a new line */
+		{
+			file = memoryIndexFindString(index, (position ? position - 1 : 0), "\n**** CRYPTED", 13);
+			file = (file < index->size ? file + 1 : index->size);
+		}
+
+		if (file < found)
+		{
+			if (!memoryIndexWrite(index, position, file - position, out)) /* data in front of the file */
+				break;
+
+			position = memoryIndexDecryptFile(index, file, filesKey, out);
+
+			if (isAnyError())
+				break;
+
+			continue;
+		}
+
+		if (!memoryIndexWrite(index, position, found - position, out)) /* data in front of cipher-text */
+			break;
+
+		if (found == index->size) /* no more encrypted data */
+			break;
+
+		size_t			valueSize = memoryIndexValueSize(index, found + 4);
+
+		if (!memoryValueSelected(index, found)) /* cipher-text is written unchanged */
+		{
+			skipped++;
+
+			if (!memoryIndexWrite(index, found, valueSize + 4, out))
+				break;
+		}
+		else if (!memoryIndexDecryptValue(index, found, valueSize, key, cache, &memo, &spans, ctx, &value, &valueBufferSize, out))
+			break;
+
+		position = found + 4 + valueSize;
+	}
+
+	if (skipped)
+	{
+		verboseMessage(verboseValuesNotSelected, skipped);
+	}
+
+	if (memo.values)
+	{
+		verboseMessage(verboseRepeatedValues, memo.duplicates, memo.values, (memo.duplicates * 100) / memo.values);
+	}
+
+	if (memo.failed && !isAnyError()) /* the data was written, but not all values were decrypted */
+		setError(DECRYPT_ERR);
+
+	valueMemoFree(&memo);
+	memorySpansFree(&spans);
+	value = clearMemory(value, valueBufferSize, true);
+	ctx = CipherCleanup(ctx);
+
+	return !isAnyError();
+}
+
+// write a JSON object for a single decrypted value, the name of the file and the section path are added,
+// if they're known - binary data is written as hexadecimal string
+
+static	bool	memoryWriteValueRecord(char * fileName, size_t fileNameSize, configIndex_t * config, configNode_t * node, char * name, size_t nameSize, size_t offset, char * value, size_t valueSize, bool isString, outputSink_t * out)
+{
+	char				number[24];
+	bool				success = outputSinkWrite(out, "{\"file\":", 8);
+
+	if (success)
+		success = (fileName ? outputSinkWriteJson(out, fileName, fileNameSize) : outputSinkWrite(out, "null", 4));
+
+	if (success)
+		success = outputSinkWrite(out, ",\"section\":", 11);
+
+	if (success)
+	{
+		if (node && node->parent != CONFIG_NO_PARENT)
+			success = (outputSinkWrite(out, "\"", 1) && configWritePath(config, node->parent, out) && outputSinkWrite(out, "\"", 1));
+		else
+			success = outputSinkWrite(out, "null", 4);
+	}
+
+	if (success)
+		success = outputSinkWrite(out, ",\"key\":", 7);
+
+	if (success)
+		success = (nameSize ? outputSinkWriteJson(out, name, nameSize) : outputSinkWrite(out, "null", 4));
+
+	if (success)
+		success = outputSinkWrite(out, number, snprintf(number, sizeof(number), ",\"offset\":%lu", (unsigned long) offset));
+
+	if (success && isString)
+		success = (outputSinkWrite(out, ",\"isString\":true,\"value\":", 25) && outputSinkWriteJson(out, value, valueSize));
+	else if (success)
+	{
+		char *			hex = (char *) malloc(valueSize * 2 + 1);
+
+		if (!hex)
+			returnError(NO_MEMORY, false);
+
+		success = (outputSinkWrite(out, ",\"isString\":false,\"hex\":\"", 25) &&
+				   outputSinkWrite(out, hex, binaryToHexadecimal(value, valueSize, hex, valueSize * 2 + 1)) &&
+				   outputSinkWrite(out, "\"", 1));
+
+		hex = clearMemory(hex, valueSize * 2 + 1, true);
+	}
+
+	return (success && outputSinkWrite(out, "}\n", 2));
+}
+
+// scan indexed data and write a record for each encrypted value instead of the data itself - the section
+// of a value is only known, if the data is contiguous and may be parsed as configuration file; offsets
+// are relative to the specified base
+
+EXPORTED	bool	memoryBufferExtractValues(memoryIndex_t * index, size_t position, char * key, char * fileName, size_t fileNameSize, size_t base, outputSink_t * out, valueCache_t * cache)
+{
+	CipherContext 		*ctx = CipherInit(NULL, CipherTypeValue, NULL, NULL, false);
+	configIndex_t *		config = NULL;
+	size_t				next = 0; /* nodes are visited in the order of their values */
+	char *				data = NULL;
+	char *				value = NULL;
+	size_t				valueBufferSize = 0;
+	valueMemo_t			memo;
+	memorySpans_t		spans;
+	size_t				skipped = 0;
+
+	memset(&memo, 0, sizeof(valueMemo_t));
+	memorySpansInit(&spans);
+
+	if (index->count == 1)
+	{
+		data = (char *) index->segments[0].iov_base;
+		if (!(config = configIndexParse(data, index->size, false)))
+		{
+			if (!isError(INVALID_FILE))
+			{
+				ctx = CipherCleanup(ctx);
+				return false;
+			}
+			resetError();
+		}
+	}
+
+	while (position < index->size)
+	{
+		size_t			found = memoryIndexFindString(index, position, "$$$$", 4);
+		size_t			valueSize;
+		configNode_t *	node = NULL;
+		char			name[MEMORY_VALUE_NAME_SIZE];
+		size_t			nameSize = 0;
+		valueMemoEntry_t *	entry = NULL;
+		size_t			dataSize = 0;
+		bool			isString = false;
+
+		if (found == index->size) /* no more encrypted data */
+			break;
+
+		valueSize = memoryIndexValueSize(index, found + 4);
+		position = found + 4 + valueSize;
+
+		if (!memoryValueSelected(index, found))
+		{
+			skipped++;
+			continue;
+		}
+
+		while (config && next < config->count && (config->nodes[next].type != CONFIG_NODE_VALUE ||
+			   config->nodes[next].value + config->nodes[next].valueSize <= data + found))
+			next++;
+
+		if (config && next < config->count && config->nodes[next].value <= data + found)
+		{
+			node = &config->nodes[next];
+			nameSize = node->nameSize;
+		}
+		else
+			nameSize = memoryIndexValueName(index, found, name, sizeof(name));
+
+		if (!memoryIndexClearText(index, found, valueSize, key, cache, &memo, &spans, ctx, &value, &valueBufferSize, &entry, &dataSize, &isString))
+		{
+			if (isAnyError())
+				break;
+			continue;
+		}
+
+		if (!memoryWriteValueRecord(fileName, fileNameSize, config, node, (node ? node->name : name), nameSize, base + found,
+									(entry ? entry->value : value), (entry ? entry->valueSize : dataSize), (entry ? entry->isString : isString), out))
+			break;
+
+		if (value)
+			memset(value, 0, valueBufferSize);
+	}
+
+	if (skipped)
+	{
+		verboseMessage(verboseValuesNotSelected, skipped);
+	}
+
+	if (memo.values)
+	{
+		verboseMessage(verboseRepeatedValues, memo.duplicates, memo.values, (memo.duplicates * 100) / memo.values);
+	}
+
+	config = configIndexFree(config);
+	if (memo.failed && !isAnyError()) /* the data was written, but not all values were decrypted */
+		setError(DECRYPT_ERR);
+
+	valueMemoFree(&memo);
+	memorySpansFree(&spans);
+	value = clearMemory(value, valueBufferSize, true);
+	ctx = CipherCleanup(ctx);
+
+	return !isAnyError();
+}
+
+// encrypt an encrypted file section starting at the specified position with another key, the position
+// of the next marker line is returned - a file, which can't be decrypted, is written unchanged
+
+static	size_t	memoryIndexRekeyFile(memoryIndex_t * index, size_t position, char * sourceKey, char * targetKey, outputSink_t * out)
+{
+	size_t			content = memoryIndexFindString(index, position, "\n", 1);
+	size_t			end;
+	char *			line;
+	char *			data = NULL;
+	bool			lineCopied = false;
+	bool			dataCopied = false;
+
+	content = (content < index->size ? content + 1 : index->size);
+	end = memoryIndexFindString(index, content, "\n**** ", 6);
+	end = (end < index->size ? end + 1 : index->size);
+
+	if ((line = memoryIndexGetRange(index, position, content - position, &lineCopied)) != NULL &&
+		(data = memoryIndexGetRange(index, content, end - content, &dataCopied)) != NULL &&
+		!exportRekeySection(line, content - position, data, end - content, sourceKey, targetKey, out) && isError(DECRYPT_ERR))
+	{
+		char *		name = memchr(line, ':', content - position);
+		size_t		nameSize = (name ? (line + (content - position)) - ++name : 0);
+
+		if (nameSize > 0 && *(name + nameSize - 1) == '\n')
+			nameSize--;
+
+		warningMessage(verboseFileNotDecrypted, (int) nameSize, (name ? name : ""));
+		resetError();
+		if (!isStrict())
+			memoryIndexWrite(index, position, end - position, out);
+		else
+			setError(WARNING_ISSUED);
+	}
+
+	if (lineCopied)
+		clearMemory(line, content - position, true);
+	if (dataCopied)
+		clearMemory(data, end - content, true);
+
+	return end;
+}
+
+// scan indexed data and encrypt all values and encrypted files with other keys while writing data to
+// output, every value gets a new random IV - unchanged data is written from the input buffers like
+// with memoryBufferProcessFile()
+
+EXPORTED	bool	memoryBufferRekeyFile(memoryIndex_t * index, size_t position, char * sourceKey, char * targetKey, outputSink_t * out, char * sourceFilesKey, char * targetFilesKey)
+{
+	CipherContext 		*ctx = CipherContextNew();
+	valueEncryptor_t *	encryptor = valueEncryptorNew(targetKey);
+	size_t				file = 0; /* position of the next encrypted file */
+	char *				value = NULL;
+	size_t				valueBufferSize = 0;
+	memorySpans_t		spans;
+
+	memorySpansInit(&spans);
+
+	if (!ctx || !encryptor)
+	{
+		if (ctx)
+			ctx = CipherCleanup(ctx);
+		encryptor = valueEncryptorFree(encryptor);
+		returnError(NO_MEMORY, false);
+	}
+
+	while (position < index->size)
+	{
+		size_t			found = memoryIndexFindString(index, position, "$$$$", 4);
+
+		if (file < position || file == 0) /* search the next encrypted file, it has to start on a new line */
+		{
+			file = memoryIndexFindString(index, (position ? position - 1 : 0), "\n**** CRYPTED", 13);
+			file = (file < index->size ? file + 1 : index->size);
+		}
+
+		if (file < found)
+		{
+			if (!memoryIndexWrite(index, position, file - position, out)) /* data in front of the file */
+				break;
+
+			position = memoryIndexRekeyFile(index, file, sourceFilesKey, targetFilesKey, out);
+
+			if (isAnyError())
+				break;
+
+			continue;
+		}
+
+		if (!memoryIndexWrite(index, position, found - position, out)) /* data in front of cipher-text */
+			break;
+
+		if (found == index->size) /* no more encrypted data */
+			break;
+
+		size_t			valueSize = memoryIndexValueSize(index, found + 4);
+		size_t			dataSize = valueSize;
+		bool			isString = false;
+
+		if (!memoryIndexGetSpans(index, found + 4, valueSize, &spans))
+			break;
+
+		if (valueBufferSize < valueSize) /* the clear-text is never larger than its Base32 encoding */
+		{
+			value = clearMemory(value, valueBufferSize, true);
+			valueBufferSize = 0;
+
+			if (!(value = (char *) malloc(valueSize)))
+			{
+				setError(NO_MEMORY);
+				break;
+			}
+
+			valueBufferSize = valueSize;
+		}
+
+		position = found + 4 + valueSize;
+
+		if (decryptValueDataVector(ctx, spans.vector, spans.count, sourceKey, value, &dataSize, &isString))
+		{
+			if (!outputSinkWrite(out, "$$$$", 4) || !valueEncryptorWrite(encryptor, value, dataSize, isString, out))
+				break;
+		}
+		else /* unable to decrypt, write data as is */
+		{
+			bool		copied = false;
+			char *		cipherText = memoryIndexGetRange(index, found + 4, valueSize, &copied); /* joined for the message only */
+
+			resetError();
+			warningMessage(verboseValueNotRekeyed, (int) (cipherText ? valueSize : 0), (cipherText ? cipherText : ""));
+
+			if (copied)
+				clearMemory(cipherText, valueSize, true);
+
+			if (isStrict())
+				setError(WARNING_ISSUED);
+			else
+				memoryIndexWrite(index, found, position - found, out);
+		}
+
+		if (isAnyError())
+			break;
+	}
+
+	value = clearMemory(value, valueBufferSize, true);
+	memorySpansFree(&spans);
+	encryptor = valueEncryptorFree(encryptor);
+	ctx = CipherCleanup(ctx);
+
+	return !isAnyError();
+}
+
+// scan indexed data and replace clear-text placeholders ('$$$${' ... '}') with encrypted values while
+// writing data to output - a backslash escapes the next character in a placeholder, like in the quoted
+// strings of configuration files
+
+EXPORTED	bool	memoryBufferEncryptFile(memoryIndex_t * index, size_t position, valueEncryptor_t * encryptor, outputSink_t * out)
+{
+	char *				value = NULL;
+	size_t				valueBufferSize = 0;
+
+	while (position < index->size)
+	{
+		size_t			found = memoryIndexFindString(index, position, "$$$${", 5);
+		size_t			end = found + 5;
+		size_t			rangeSize = 0;
+		size_t			valueSize = 0;
+		bool			escaped = false;
+
+		if (!memoryIndexWrite(index, position, found - position, out)) /* data in front of placeholder */
+			break;
+
+		if (found == index->size) /* no more placeholders */
+			break;
+
+		while ((end = memoryIndexFindString(index, end, "}", 1)) < index->size) /* an escaped brace doesn't end the value */
+		{
+			size_t		escapes = 0;
+			struct iovec	single;
+
+			rangeSize = end - (found + 5);
+
+			while (escapes < rangeSize && memoryIndexGetVector(index, end - escapes - 1, 1, &single, 1) &&
+				   *((char *) single.iov_base) == '\\')
+				escapes++;
+
+			if ((escapes % 2) == 0)
+				break;
+
+			end++;
+		}
+
+		if (end == index->size) /* unterminated placeholder, it's written unchanged */
+		{
+			warningMessage(verbosePlaceholderNotClosed, (unsigned long) found);
+
+			if (isStrict())
+			{
+				setError(WARNING_ISSUED);
+				break;
+			}
+
+			if (!memoryIndexWrite(index, found, end - found, out))
+				break;
+
+			position = end;
+			continue;
+		}
+
+		if (valueBufferSize < rangeSize + 1)
+		{
+			value = clearMemory(value, valueBufferSize, true);
+			valueBufferSize = 0;
+
+			if (!(value = (char *) malloc(rangeSize + 1)))
+			{
+				setError(NO_MEMORY);
+				break;
+			}
+
+			valueBufferSize = rangeSize + 1;
+		}
+
+		for (size_t offset = 0; offset < rangeSize; ) /* the placeholder may cross segment borders */
+		{
+			struct iovec	single;
+
+			if (!memoryIndexGetVector(index, found + 5 + offset, rangeSize - offset, &single, 1))
+				break;
+
+			for (size_t i = 0; i < single.iov_len; i++)
+			{
+				char	c = *((char *) single.iov_base + i);
+
+				if (!escaped && c == '\\' && (offset + i + 1) < rangeSize)
+				{
+					escaped = true;
+					continue;
+				}
+
+				escaped = false;
+				*(value + valueSize++) = c;
+			}
+
+			offset += single.iov_len;
+		}
+
+		position = end + 1;
+
+		if (!outputSinkWrite(out, "$$$$", 4) || !valueEncryptorWrite(encryptor, value, valueSize, true, out))
+			break;
+	}
+
+	value = clearMemory(value, valueBufferSize, true);
+
+	return !isAnyError();
+}
+
+// views are lists of memory spans in output order, data not present in any input buffer is
+// stored in an arena (a chain of buffers with the newest one at its head), which is cleared on
+// release - it may contain clear-text values
+
+EXPORTED	memoryView_t *	memoryViewNew(void)
+{
+	memoryView_t	*view = (memoryView_t *) malloc(sizeof(memoryView_t));
+
+	if (!view)
+	{
+		setError(NO_MEMORY);
+		return NULL;
+	}
+
+	memset(view, 0, sizeof(memoryView_t));
+
+	return view;
+}
+
+EXPORTED	memoryView_t *	memoryViewFree(memoryView_t * view)
+{
+	if (!view)
+		return NULL;
+
+	for (memoryBuffer_t * arena = view->arena; arena; arena = arena->next) /* clear-text values, even in mapped buffers */
+	{
+		if (arena->mapped)
+			memset(arena->data, 0, arena->used);
+	}
+
+	view->arena = memoryBufferFreeChain(view->arena);
+	free(view->spans);
+	free(view);
+
+	return NULL;
+}
+
+// create a view for all data in a buffer chain
+
+EXPORTED	memoryView_t *	memoryViewFromChain(memoryBuffer_t * chain)
+{
+	memoryView_t	*view = memoryViewNew();
+	memoryBuffer_t	*current = chain;
+
+	while (view && current)
+	{
+		if (!memoryViewAppendSpan(view, current->data, current->used))
+			view = memoryViewFree(view);
+		else
+			current = current->next;
+	}
+
+	return view;
+}
+
+// add a reference to existing data, adjacent spans are merged
+
+EXPORTED	bool	memoryViewAppendSpan(memoryView_t * view, char * data, size_t size)
+{
+	if (!size)
+		return true;
+
+	if (view->count > 0)
+	{
+		struct iovec	*last = view->spans + view->count - 1;
+
+		if (((char *) last->iov_base + last->iov_len) == data)
+		{
+			last->iov_len += size;
+			return true;
+		}
+	}
+
+	if (view->count == view->allocated)
+	{
+		size_t			allocated = (view->allocated ? view->allocated * 2 : 64);
+		struct iovec	*spans = (struct iovec *) realloc(view->spans, allocated * sizeof(struct iovec));
+
+		if (!spans)
+			returnError(NO_MEMORY, false);
+
+		view->spans = spans;
+		view->allocated = allocated;
+	}
+
+	view->spans[view->count].iov_base = data;
+	view->spans[view->count].iov_len = size;
+	view->count++;
+
+	return true;
+}
+
+// copy data to the arena and add a span for it
+
+EXPORTED	bool	memoryViewAppendData(memoryView_t * view, char * data, size_t size)
+{
+	memoryBuffer_t	*arena = view->arena;
+
+	if (!size)
+		return true;
+
+	if (!arena || (arena->size - sizeof(memoryBuffer_t) - arena->used) < size)
+	{
+		size_t			allocSize = (size > memoryBufferSize ? size : memoryBufferSize) + sizeof(memoryBuffer_t);
+
+		arena = memoryBufferNew(allocSize);
+		if (!arena)
+			returnError(NO_MEMORY, false);
+
+		arena->next = view->arena;
+		if (view->arena)
+			view->arena->prev = arena;
+		view->arena = arena;
+	}
+
+	char *			target = arena->data + arena->used;
+
+	memcpy(target, data, size);
+	arena->used += size;
+
+	return memoryViewAppendSpan(view, target, size);
+}
+
+// compute the size of data in a view
+
+EXPORTED	size_t	memoryViewDataSize(memoryView_t * view)
+{
+	size_t			size = 0;
+
+	for (size_t i = 0; i < view->count; i++)
+		size += view->spans[i].iov_len;
+
+	return size;
+}
+
+// get the next line (including its newline character) from a view; lines crossing span borders
+// are assembled in a buffer owned by the cursor, otherwise the result points into the span
+
+EXPORTED	char *	memoryViewGetLine(memoryView_t * view, memoryViewCursor_t * cursor, size_t * size, size_t * position)
+{
+	size_t			lineSize = 0;
+
+	*size = 0;
+
+	while (cursor->span < view->count && cursor->offset >= view->spans[cursor->span].iov_len)
+	{
+		cursor->span++;
+		cursor->offset = 0;
+	}
+
+	if (cursor->span >= view->count)
+		return NULL;
+
+	if (position)
+		*position = cursor->position;
+
+	while (cursor->span < view->count)
+	{
+		char *		start = (char *) view->spans[cursor->span].iov_base + cursor->offset;
+		size_t		available = view->spans[cursor->span].iov_len - cursor->offset;
+		char *		newline = memchr(start, '\n', available);
+		size_t		used = (newline ? (size_t) (newline - start) + 1 : available);
+
+		if (lineSize == 0 && (newline || cursor->span == view->count - 1)) /* line is contained in a single span */
+		{
+			cursor->offset += used;
+			cursor->position += used;
+			*size = used;
+			return start;
+		}
+
+		if (lineSize + used > cursor->lineSize)
+		{
+			size_t		newSize = (lineSize + used) * 2;
+			char *		line = (char *) malloc(newSize);
+
+			if (!line)
+				returnError(NO_MEMORY, NULL);
+
+			if (cursor->line)
+			{
+				memcpy(line, cursor->line, lineSize);
+				clearMemory(cursor->line, cursor->lineSize, true);
+			}
+
+			cursor->line = line;
+			cursor->lineSize = newSize;
+		}
+
+		memcpy(cursor->line + lineSize, start, used);
+		lineSize += used;
+		cursor->offset += used;
+		cursor->position += used;
+
+		if (newline)
+			break;
+
+		cursor->span++;
+		cursor->offset = 0;
+	}
+
+	*size = lineSize;
+
+	return cursor->line;
+}
+
+// release the line buffer of a cursor and reset it to the start of a view
+
+EXPORTED	void	memoryViewCursorReset(memoryViewCursor_t * cursor)
+{
+	cursor->line = clearMemory(cursor->line, cursor->lineSize, true);
+	memset(cursor, 0, sizeof(memoryViewCursor_t));
+}
+
+// free memory after clearing its content
+
+void *	clearMemory(void * buffer, size_t size, bool freeBuffer)
+{
+	if (buffer)
+	{
+		memset(buffer, 0, size);
+
+		if (freeBuffer) free(buffer);
+	}
+
+	return NULL;
+}
+
+#pragma GCC diagnostic pop
@@ -26,6 +26,14 @@
 #include "common.h"
 
 #define	DEFAULT_MEMORY_BUFFER_SIZE		DECODER_CONFIG_MEMORY_BUFFER_SIZE
+#define	MEMORY_MAP_THRESHOLD			DECODER_CONFIG_MEMORY_MAP_THRESHOLD
+#define	MEMORY_HUGEPAGE_THRESHOLD		DECODER_CONFIG_MEMORY_HUGEPAGE_THRESHOLD
+#define	MEMORY_VALUE_MEMO_SIZE			DECODER_CONFIG_MEMORY_VALUE_MEMO_SIZE
+
+// the name of a setting is searched within this number of characters in front of its value
+
+#define	MEMORY_VALUE_NAME_LOOKBACK		128
+#define	MEMORY_VALUE_NAME_SIZE			64
 
 // memory structure for file buffering
 
@@ -36,24 +44,80 @@ typedef struct memoryBuffer {
 	struct memoryBuffer	*prev;
 	size_t				size;
 	size_t				used;
+	bool				mapped;
 	char				data[];
 } memoryBuffer_t;
 
+// index of a buffer chain with cumulative offsets of all segments
+
+typedef struct memoryIndex {
+	struct iovec *		segments;
+	size_t *			offsets;
+	size_t				count;
+	size_t				size;
+} memoryIndex_t;
+
+// decoded data view - a list of spans over input buffers (zero-copy) and an arena for new data
+
+typedef struct memoryView {
+	struct iovec *		spans;
+	size_t				count;
+	size_t				allocated;
+	memoryBuffer_t *	arena;
+} memoryView_t;
+
+// position for line-oriented reading from a view
+
+typedef struct memoryViewCursor {
+	size_t				span;
+	size_t				offset;
+	size_t				position;
+	char *				line;
+	size_t				lineSize;
+} memoryViewCursor_t;
+
 // function prototypes
 
+struct outputSink;
+struct valueEncryptor;
+struct valueCache;
+
 void				memoryBufferSetSize(size_t size);
+bool				memoryValueFilterSet(char * names, bool exclude);
 
 memoryBuffer_t *	memoryBufferNew(size_t size);
 memoryBuffer_t *	memoryBufferFreeChain(memoryBuffer_t *start);
 memoryBuffer_t *	memoryBufferConsolidateData(memoryBuffer_t *start);
 
 memoryBuffer_t *	memoryBufferReadFile(FILE * file, size_t chunkSize);
+char *				memoryMapFile(FILE * file, size_t * size);
+char *				memoryUnmapFile(char * data, size_t size);
 size_t				memoryBufferDataSize(memoryBuffer_t *top);
-bool				memoryBufferProcessFile(memoryBuffer_t * *buffer, size_t offset, char * key, FILE * out, char * filesKey);
+bool				memoryBufferProcessFile(memoryIndex_t * index, size_t position, char * key, struct outputSink * out, char * filesKey, struct valueCache * cache);
+bool				memoryBufferExtractValues(memoryIndex_t * index, size_t position, char * key, char * fileName, size_t fileNameSize, size_t base, struct outputSink * out, struct valueCache * cache);
+bool				memoryBufferEncryptFile(memoryIndex_t * index, size_t position, struct valueEncryptor * encryptor, struct outputSink * out);
+bool				memoryBufferRekeyFile(memoryIndex_t * index, size_t position, char * sourceKey, char * targetKey, struct outputSink * out, char * sourceFilesKey, char * targetFilesKey);
+
+memoryIndex_t *		memoryIndexNew(memoryBuffer_t * chain);
+memoryIndex_t *		memoryIndexFromData(char * data, size_t size);
+memoryIndex_t *		memoryIndexFree(memoryIndex_t * index);
+size_t				memoryIndexLocate(memoryIndex_t * index, size_t position, size_t * offset);
+size_t				memoryIndexFindString(memoryIndex_t * index, size_t position, char * find, size_t findSize);
+size_t				memoryIndexValueSize(memoryIndex_t * index, size_t position);
+size_t				memoryIndexCountLines(memoryIndex_t * index, size_t position, size_t end);
+size_t				memoryIndexValueName(memoryIndex_t * index, size_t position, char * name, size_t nameSize);
+int					memoryIndexGetVector(memoryIndex_t * index, size_t position, size_t size, struct iovec * vector, int count);
+bool				memoryIndexWrite(memoryIndex_t * index, size_t position, size_t size, struct outputSink * out);
+void				memoryShowCipherText(char * text, size_t size);
 
-char *				memoryBufferFindString(memoryBuffer_t * *buffer, size_t *offset, char *find, size_t findSize, bool *split);
-char *				memoryBufferAdvancePointer(memoryBuffer_t * *buffer, size_t *lastOffset, size_t offset);
-char *				memoryBufferSearchValueEnd(memoryBuffer_t * *buffer, size_t *offset, size_t * size, bool *split);
+memoryView_t *		memoryViewNew(void);
+memoryView_t *		memoryViewFree(memoryView_t * view);
+memoryView_t *		memoryViewFromChain(memoryBuffer_t * chain);
+bool				memoryViewAppendSpan(memoryView_t * view, char * data, size_t size);
+bool				memoryViewAppendData(memoryView_t * view, char * data, size_t size);
+size_t				memoryViewDataSize(memoryView_t * view);
+char *				memoryViewGetLine(memoryView_t * view, memoryViewCursor_t * cursor, size_t * size, size_t * position);
+void				memoryViewCursorReset(memoryViewCursor_t * cursor);
 
 void *				clearMemory(void * buffer, size_t size, bool freeBuffer);
 
@@ -43,6 +43,37 @@ EXPORTED	bool	setAlternativeEnvironment(char * newEnvironment)
 	return true;
 }
 
+EXPORTED	bool	setKeyCacheOption(char * value)
+{
+	char *			endString = NULL;
+	unsigned long	timeout = strtoul(value, &endString, 10);
+
+	if (!*value || *endString || timeout == 0 || timeout > KEY_CACHE_MAX_TIMEOUT)
+	{
+		errorMessage(errorInvalidKeyCacheTimeout, value);
+		return false;
+	}
+
+	setKeyCacheTimeout(timeout);
+
+	return true;
+}
+
+EXPORTED	bool	setOutputFormat(char * value, outputFormat_t * format)
+{
+	if (!strcmp(value, "text"))
+		*format = OUTPUT_FORMAT_TEXT;
+	else if (!strcmp(value, "ndjson"))
+		*format = OUTPUT_FORMAT_NDJSON;
+	else
+	{
+		errorMessage(errorInvalidOutputFormat, value);
+		return false;
+	}
+
+	return true;
+}
+
 EXPORTED	bool	checkLastArgumentIsInputFile(char * name)
 {
 	struct stat		st;
@@ -101,6 +101,32 @@
 #define altenv_verbose_message()		if (altEnv)\
 											verboseMessage(verboseAltEnv, getEnvironmentPath())
 
+// device keys in the kernel keyring
+
+#define keycache_options_long			{ "key-cache", required_argument, NULL, 'K' }
+
+#define keycache_options_short			"K:"
+
+#define check_keycache_options_short()	case 'K':\
+											if (!setKeyCacheOption(optarg)) {\
+												__autoUsage();\
+												return EXIT_FAILURE;\
+											}\
+											break
+
+// format of records
+
+#define format_options_long				{ "format", required_argument, NULL, 'f' }
+
+#define format_options_short			"f:"
+
+#define check_format_options_short()	case 'f':\
+											if (!setOutputFormat(optarg, &format)) {\
+												__autoUsage();\
+												return EXIT_FAILURE;\
+											}\
+											break
+
 // wrap output lines
 
 #define width_options_long				{ "wrap-lines", optional_argument, NULL, 'w' }
@@ -121,6 +147,8 @@
 // function prototypes
 
 bool									setAlternativeEnvironment(char * newEnvironment);
+bool									setKeyCacheOption(char * value);
+bool									setOutputFormat(char * value, outputFormat_t * format);
 int										setLineWidth(char * value, char * option, char * next);
 bool									setInputBufferSize(char * value, char * option);
 bool									checkLastArgumentIsInputFile(char * name);
@@ -55,10 +55,39 @@ EXPORTED	char *				verboseWrapLinesIgnored = "output data is written as binary c
 EXPORTED	char *				verboseBufferSize = "input data will be read in blocks of %u bytes\n";
 EXPORTED	char *				verboseInputDataConsolidated = "input data consolidated in a single buffer with %lu bytes\n";
 EXPORTED	char *				verboseNoConsolidate = "input data consolidation will be skipped\n";
+EXPORTED	char *				verboseInputFileMapped = "input file with %lu bytes mapped into memory\n";
 EXPORTED	char *				verboseChecksumFound = "found current checksum '%s'\n";
 EXPORTED	char *				verboseChecksumIsValid = "the current checksum is still valid\n";
 EXPORTED	char *				verboseNewChecksum = "the new checksum '%s' was written instead of the old one\n";
 EXPORTED	char *				verboseOpenedOutputFile = "output file '%s' opened\n";
+EXPORTED	char *				verboseChecksumWasInvalid = "the checksum of the input file was invalid already\n";
+EXPORTED	char *				verboseChecksumReplaced = "checksum in file '%s' replaced\n";
+EXPORTED	char *				verboseNoExportFileSkipped = "file '%s' skipped, it isn't an export file\n";
+EXPORTED	char *				verboseOpenedInputFile = "input file '%s' opened\n";
+EXPORTED	char *				verboseFileDecryptJobs = "%lu bytes of encrypted file data were decrypted by %lu parallel jobs\n";
+EXPORTED	char *				verboseFileDecrypted = "encrypted file '%.*s' was decrypted, it contains %lu bytes\n";
+EXPORTED	char *				verboseFileNotDecrypted = "unable to decrypt file '%.*s', it's written unchanged\n";
+EXPORTED	char *				verboseValueNotRekeyed = "unable to decrypt value '%.*s', it's written unchanged\n";
+EXPORTED	char *				verbosePlaceholderNotClosed = "the placeholder at offset %lu isn't closed, it's written unchanged\n";
+EXPORTED	char *				verboseValuesEncrypted = "%lu values were encrypted\n";
+EXPORTED	char *				verboseValueCacheNotUsed = "unable to use the value cache in '%s', values are decrypted without it\n";
+EXPORTED	char *				verboseValueCacheStatistics = "value cache: %lu hits, %lu misses, %lu values stored\n";
+EXPORTED	char *				verboseValuesNotSelected = "%lu values weren't selected by the name of their setting, they're written unchanged\n";
+EXPORTED	char *				verboseRepeatedValues = "%lu of %lu values were repeated cipher-text (%lu%%), they were decrypted only once\n";
+EXPORTED	char *				verboseKeyFromCache = "device key '%s' was found in the kernel keyring\n";
+EXPORTED	char *				verboseKeyCached = "device key '%s' was stored in the kernel keyring for %u seconds\n";
+EXPORTED	char *				verboseKeyNotCached = "unable to store the device key in the kernel keyring\n";
+EXPORTED	char *				verboseTffsSegment = "TFFS segment %lu found at offset %lu\n";
+EXPORTED	char *				verboseTffsTruncated = "the TFFS entry at offset %lu exceeds the image, the segment ends there\n";
+EXPORTED	char *				verboseTffsNodeInflated = "node '%s' was decompressed from %lu to %lu bytes\n";
+EXPORTED	char *				verboseTffsNodeNotInflated = "node '%s' looks compressed, but it couldn't be decompressed - it's written unchanged\n";
+EXPORTED	char *				verboseTffsNodesWritten = "%lu nodes were written to '%s'\n";
+EXPORTED	char *				verboseConfigValuesSelected = "%lu settings were selected from %lu indexed nodes\n";
+EXPORTED	char *				verboseFilesSearched = "%lu files were searched by %u parallel jobs, %lu values were decrypted\n";
+EXPORTED	char *				verboseExportKeyNotFound = "the password entry of the export file '%s' can't be decrypted, the file is skipped\n";
+EXPORTED	char *				verboseFilesCompared = "%lu of %lu files were unchanged, %lu values were decrypted\n";
+EXPORTED	char *				verboseValuesScanned = "%lu encrypted values found, %lu of them may be decrypted with the specified key\n";
+EXPORTED	char *				verboseSplitJobs = "%lu files will be written by %u parallel jobs\n";
 
 EXPORTED	char *				verboseDebugKey = "key\t: (%03u) 0x%s\n";
 EXPORTED	char *				verboseDebugBase32 = "base32\t: (%03u) %s\n";
@@ -75,8 +104,7 @@ EXPORTED	char *				verboseDebugValue = "value\t: (%03u) %s\n";
 static	char *					appletName = NULL;
 static	size_t					outputLineWidth = DEFAULT_OUTPUT_LINE_WIDTH;
 static	bool					wrapLines = false;
-UNUSED	static	FILE *			outputFile = NULL;
-UNUSED	static	memoryBuffer_t 	*outputBuffer = NULL;
+static	outputSink_t *			standardOutput = NULL;
 
 // get verbosity level
 
@@ -132,36 +160,404 @@ EXPORTED	char *	getAppletName(void)
 
 // output formatting
 
-EXPORTED	char * 	wrapOutput(FILE * outFile, size_t *charsOnLine, size_t *toWrite, char *output)
+EXPORTED	char * 	wrapOutput(outputSink_t * sink, size_t *charsOnLine, size_t *toWrite, char *output)
 {
 	size_t				remOnLine = outputLineWidth - *charsOnLine;
 	char *				out = output;
 
 	if (wrapLines && !output)
 	{
-		if (fwrite("\n", 1, 1, outFile) != 1) /* append newline */
-			returnError(WRITE_FAILED, 0);
+		if (!outputSinkWrite(sink, "\n", 1)) /* append newline */
+			return NULL;
 		returnError(NOERROR, 0);
 	}
 	if (wrapLines && (*toWrite > remOnLine)) /* wrap on lineSize */
 	{
-		if ((remOnLine > 0) && (fwrite(out, remOnLine, 1, outFile) != 1)) /* remaining line */
-			returnError(WRITE_FAILED, out);
+		if ((remOnLine > 0) && !outputSinkWrite(sink, out, remOnLine)) /* remaining line */
+			return out;
 		out += remOnLine;
 		*toWrite -= remOnLine;
 		*charsOnLine = 0;
-		if (fwrite("\n", 1, 1, outFile) != 1) /* append newline */
-			returnError(WRITE_FAILED, 0);
+		if (!outputSinkWrite(sink, "\n", 1)) /* append newline */
+			return NULL;
 		while (*toWrite > outputLineWidth)
 		{
-			if (fwrite(out, outputLineWidth, 1, outFile) != 1)
-				returnError(WRITE_FAILED, 0);
+			if (!outputSinkWrite(sink, out, outputLineWidth) || !outputSinkWrite(sink, "\n", 1))
+				return NULL;
 			*toWrite -= outputLineWidth;
 			out += outputLineWidth;
-			if (fwrite("\n", 1, 1, outFile) != 1) /* append newline */
-				returnError(WRITE_FAILED, 0);
 		}
 	}
 
 	return out;
 }
+
+// output sinks - small fragments are copied to a staging buffer, spans from long-living buffers are
+// only referenced (zero-copy), all data is written with writev() as soon as about OUTPUT_SINK_FLUSH_SIZE
+// bytes are pending or the vector is full
+
+static	outputSink_t *	outputSinkNew(outputSinkType_t type)
+{
+	outputSink_t		*sink = (outputSink_t *) malloc(sizeof(outputSink_t));
+
+	if (!sink)
+		returnError(NO_MEMORY, NULL);
+
+	memset(sink, 0, sizeof(outputSink_t));
+	sink->type = type;
+	sink->fd = -1;
+
+	if (type != OUTPUT_SINK_MEMORY)
+	{
+		sink->buffer = (char *) malloc(OUTPUT_SINK_FLUSH_SIZE);
+
+		if (!sink->buffer)
+		{
+			free(sink);
+			returnError(NO_MEMORY, NULL);
+		}
+	}
+
+	return sink;
+}
+
+EXPORTED	outputSink_t *	outputSinkForFd(int fd)
+{
+	outputSink_t		*sink = outputSinkNew(OUTPUT_SINK_FD);
+
+	if (sink)
+		sink->fd = fd;
+
+	return sink;
+}
+
+EXPORTED	outputSink_t *	outputSinkForFile(FILE * file)
+{
+	outputSink_t		*sink = outputSinkNew(OUTPUT_SINK_FILE);
+
+	if (sink)
+	{
+		sink->file = file;
+		sink->fd = fileno(file);
+	}
+
+	return sink;
+}
+
+EXPORTED	outputSink_t *	outputSinkForView(memoryView_t * view)
+{
+	outputSink_t		*sink = outputSinkNew(OUTPUT_SINK_MEMORY);
+
+	if (sink)
+		sink->view = view;
+
+	return sink;
+}
+
+// flush pending data and release a sink, the staging buffer is cleared - it may contain clear-text values
+
+EXPORTED	outputSink_t *	outputSinkFree(outputSink_t * sink)
+{
+	if (!sink)
+		return NULL;
+
+	outputSinkFlush(sink);
+
+	if (sink->buffer)
+		clearMemory(sink->buffer, OUTPUT_SINK_FLUSH_SIZE, true);
+
+	free(sink);
+
+	return NULL;
+}
+
+// write all pending data
+
+EXPORTED	bool	outputSinkFlush(outputSink_t * sink)
+{
+	struct iovec		*next = sink->vector;
+	int					count = sink->count;
+
+	if (sink->type == OUTPUT_SINK_MEMORY || count == 0)
+		return true;
+
+	sink->count = 0;
+	sink->pending = 0;
+	sink->used = 0;
+
+	if (sink->file && fflush(sink->file))
+		returnError(WRITE_FAILED, false);
+
+	while (count > 0)
+	{
+		ssize_t			written = writev(sink->fd, next, count);
+
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			returnError(WRITE_FAILED, false);
+		}
+
+		while (count > 0 && (size_t) written >= next->iov_len)
+		{
+			written -= next->iov_len;
+			next++;
+			count--;
+		}
+
+		if (count > 0)
+		{
+			next->iov_base = (char *) next->iov_base + written;
+			next->iov_len -= written;
+		}
+	}
+
+	return true;
+}
+
+// register a file, which is mapped into memory at the specified address - larger spans from this
+// file are moved to the output within the kernel, if the output is a pipe or a regular file
+
+EXPORTED	void	outputSinkSetSource(outputSink_t * sink, int fd, char * data, size_t size)
+{
+	struct stat			fileStat;
+
+	sink->passthrough = OUTPUT_PASSTHROUGH_NONE;
+
+	if (sink->type == OUTPUT_SINK_MEMORY || fstat(sink->fd, &fileStat))
+		return;
+
+	if (S_ISFIFO(fileStat.st_mode))
+		sink->passthrough = OUTPUT_PASSTHROUGH_SPLICE;
+	else if (S_ISREG(fileStat.st_mode))
+		sink->passthrough = OUTPUT_PASSTHROUGH_COPY;
+
+	sink->sourceFd = fd;
+	sink->source = data;
+	sink->sourceSize = size;
+}
+
+// move data from the source file to the output without copying it to user space - if the kernel doesn't
+// support it for these files, passthrough is disabled and the caller has to write the remaining data
+
+static	bool	outputSinkPassthrough(outputSink_t * sink, char * data, size_t size, size_t * moved)
+{
+	loff_t				offset = data - sink->source;
+
+	*moved = 0;
+
+	if (!outputSinkFlush(sink))
+		return false;
+
+	while (*moved < size)
+	{
+		ssize_t			count;
+
+		if (sink->passthrough == OUTPUT_PASSTHROUGH_SPLICE)
+			count = splice(sink->sourceFd, &offset, sink->fd, NULL, size - *moved, SPLICE_F_MORE);
+		else
+			count = copy_file_range(sink->sourceFd, &offset, sink->fd, NULL, size - *moved, 0);
+
+		if (count < 0 && errno == EINTR)
+			continue;
+
+		if (count <= 0)
+		{
+			sink->passthrough = OUTPUT_PASSTHROUGH_NONE;
+			if (count < 0 && errno != EINVAL && errno != ENOSYS && errno != EXDEV && errno != EBADF && errno != EOPNOTSUPP)
+				returnError(WRITE_FAILED, false);
+			break;
+		}
+
+		*moved += count;
+	}
+
+	return true;
+}
+
+// add a span to the vector - data has to remain unchanged until the sink was flushed
+
+EXPORTED	bool	outputSinkWriteSpan(outputSink_t * sink, char * data, size_t size)
+{
+	if (!sink) /* sink creation failed */
+		return false;
+
+	if (!size)
+		return true;
+
+	if (sink->type == OUTPUT_SINK_MEMORY)
+		return memoryViewAppendSpan(sink->view, data, size);
+
+	if (sink->passthrough != OUTPUT_PASSTHROUGH_NONE && size >= OUTPUT_SINK_PASSTHROUGH_SIZE &&
+		data >= sink->source && (data + size) <= (sink->source + sink->sourceSize)) /* unchanged data from mapped input file */
+	{
+		size_t			moved;
+
+		if (!outputSinkPassthrough(sink, data, size, &moved))
+			return false;
+
+		data += moved;
+		size -= moved;
+
+		if (!size)
+			return true;
+	}
+
+	if (sink->count > 0)
+	{
+		struct iovec	*last = sink->vector + sink->count - 1;
+
+		if (((char *) last->iov_base + last->iov_len) == data) /* adjacent data */
+		{
+			last->iov_len += size;
+			sink->pending += size;
+			return (sink->pending < OUTPUT_SINK_FLUSH_SIZE ? true : outputSinkFlush(sink));
+		}
+	}
+
+	if (sink->count == OUTPUT_SINK_VECTOR_SIZE && !outputSinkFlush(sink))
+		return false;
+
+	sink->vector[sink->count].iov_base = data;
+	sink->vector[sink->count].iov_len = size;
+	sink->count++;
+	sink->pending += size;
+
+	return (sink->pending < OUTPUT_SINK_FLUSH_SIZE ? true : outputSinkFlush(sink));
+}
+
+// add a copy of the specified data
+
+EXPORTED	bool	outputSinkWrite(outputSink_t * sink, char * data, size_t size)
+{
+	if (!sink) /* sink creation failed */
+		return false;
+
+	if (!size)
+		return true;
+
+	if (sink->type == OUTPUT_SINK_MEMORY)
+		return memoryViewAppendData(sink->view, data, size);
+
+	if ((sink->used + size) > OUTPUT_SINK_FLUSH_SIZE || sink->count == OUTPUT_SINK_VECTOR_SIZE) /* a flush for a new span would reuse the buffer */
+	{
+		if (!outputSinkFlush(sink))
+			return false;
+
+		if (size > OUTPUT_SINK_FLUSH_SIZE) /* write it at once */
+			return outputSinkWriteSpan(sink, data, size) && outputSinkFlush(sink);
+	}
+
+	char *				copy = sink->buffer + sink->used;
+
+	memcpy(copy, data, size);
+	sink->used += size;
+
+	return outputSinkWriteSpan(sink, copy, size);
+}
+
+// add a range of data from a view
+
+EXPORTED	bool	outputSinkWriteView(outputSink_t * sink, memoryView_t * view, size_t offset, size_t size)
+{
+	for (size_t i = 0; i < view->count && size > 0; i++)
+	{
+		struct iovec	*span = view->spans + i;
+
+		if (offset >= span->iov_len)
+		{
+			offset -= span->iov_len;
+			continue;
+		}
+
+		size_t			available = span->iov_len - offset;
+
+		if (available > size)
+			available = size;
+
+		if (!outputSinkWriteSpan(sink, (char *) span->iov_base + offset, available))
+			return false;
+
+		size -= available;
+		offset = 0;
+	}
+
+	return true;
+}
+
+// add data as JSON string with quotation marks - backslashes, quotation marks and control characters
+// are escaped, all other characters are written unchanged
+
+EXPORTED	bool	outputSinkWriteJson(outputSink_t * sink, char * data, size_t size)
+{
+	size_t				start = 0;
+
+	if (!outputSinkWrite(sink, "\"", 1))
+		return false;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		unsigned char	c = (unsigned char) *(data + i);
+		char			escape[7];
+		size_t			escapeSize = 2;
+
+		if (c >= 0x20 && c != '"' && c != '\\')
+			continue;
+
+		escape[0] = '\\';
+		switch (c)
+		{
+			case '"':
+			case '\\':
+				escape[1] = c;
+				break;
+
+			case '\n':
+				escape[1] = 'n';
+				break;
+
+			case '\r':
+				escape[1] = 'r';
+				break;
+
+			case '\t':
+				escape[1] = 't';
+				break;
+
+			default:
+				escapeSize = snprintf(escape, sizeof(escape), "\\u%04x", c);
+				break;
+		}
+
+		if (!outputSinkWrite(sink, data + start, i - start) || !outputSinkWrite(sink, escape, escapeSize))
+			return false;
+
+		start = i + 1;
+	}
+
+	return (outputSinkWrite(sink, data + start, size - start) && outputSinkWrite(sink, "\"", 1));
+}
+
+// shared sink for STDOUT, it's closed by the main program after an applet has finished
+
+EXPORTED	outputSink_t *	outputStdout(void)
+{
+	if (!standardOutput)
+		standardOutput = outputSinkForFile(stdout);
+
+	return standardOutput;
+}
+
+EXPORTED	bool	outputClose(void)
+{
+	bool				result = true;
+
+	if (standardOutput)
+	{
+		result = outputSinkFlush(standardOutput);
+		standardOutput = outputSinkFree(standardOutput);
+	}
+
+	return result;
+}
@@ -32,6 +32,47 @@ typedef enum {
 	VERBOSITY_VERBOSE	/* show extra information on STDERR */
 } decoder_verbosity_t;
 
+// format of records written by applets, which don't copy their input
+
+typedef enum {
+	OUTPUT_FORMAT_TEXT,		/* one line with tab-separated fields per record */
+	OUTPUT_FORMAT_NDJSON	/* one JSON object per line */
+} outputFormat_t;
+
+// output sink - gathers data fragments in a vector, which is written with a single system call
+
+typedef enum {
+	OUTPUT_SINK_FD,		/* file descriptor */
+	OUTPUT_SINK_FILE,	/* stdio stream, it's flushed before own data is written */
+	OUTPUT_SINK_MEMORY	/* data is collected in a memory view */
+} outputSinkType_t;
+
+#define OUTPUT_SINK_FLUSH_SIZE			(1024 * 1024)
+#define OUTPUT_SINK_VECTOR_SIZE			1024
+#define OUTPUT_SINK_PASSTHROUGH_SIZE	(64 * 1024)
+
+typedef enum {
+	OUTPUT_PASSTHROUGH_NONE,	/* data has to be written from user space */
+	OUTPUT_PASSTHROUGH_SPLICE,	/* source file to pipe */
+	OUTPUT_PASSTHROUGH_COPY		/* source file to regular file */
+} outputPassthrough_t;
+
+typedef struct outputSink {
+	outputSinkType_t	type;
+	int					fd;
+	FILE *				file;
+	memoryView_t *		view;
+	struct iovec		vector[OUTPUT_SINK_VECTOR_SIZE];
+	int					count;
+	size_t				pending;
+	char *				buffer;
+	size_t				used;
+	outputPassthrough_t	passthrough;
+	int					sourceFd;
+	char *				source;
+	size_t				sourceSize;
+} outputSink_t;
+
 #ifndef OUTPUT_C
 
 // global verbosity setting
@@ -66,10 +107,39 @@ extern	char *							verboseWrapLinesIgnored;
 extern	char *							verboseBufferSize;
 extern	char *							verboseInputDataConsolidated;
 extern	char *							verboseNoConsolidate;
+extern	char *							verboseInputFileMapped;
 extern	char *							verboseChecksumFound;
 extern	char *							verboseChecksumIsValid;
 extern	char *							verboseNewChecksum;
 extern	char *							verboseOpenedOutputFile;
+extern	char *							verboseChecksumWasInvalid;
+extern	char *							verboseChecksumReplaced;
+extern	char *							verboseNoExportFileSkipped;
+extern	char *							verboseOpenedInputFile;
+extern	char *							verboseSplitJobs;
+extern	char *							verboseFileDecryptJobs;
+extern	char *							verboseFileDecrypted;
+extern	char *							verboseFileNotDecrypted;
+extern	char *							verboseValueNotRekeyed;
+extern	char *							verbosePlaceholderNotClosed;
+extern	char *							verboseValuesEncrypted;
+extern	char *							verboseValueCacheNotUsed;
+extern	char *							verboseValueCacheStatistics;
+extern	char *							verboseRepeatedValues;
+extern	char *							verboseValuesNotSelected;
+extern	char *							verboseKeyFromCache;
+extern	char *							verboseKeyCached;
+extern	char *							verboseKeyNotCached;
+extern	char *							verboseTffsSegment;
+extern	char *							verboseTffsTruncated;
+extern	char *							verboseTffsNodeInflated;
+extern	char *							verboseTffsNodeNotInflated;
+extern	char *							verboseTffsNodesWritten;
+extern	char *							verboseValuesScanned;
+extern	char *							verboseConfigValuesSelected;
+extern	char *							verboseFilesSearched;
+extern	char *							verboseExportKeyNotFound;
+extern	char *							verboseFilesCompared;
 
 extern	char *							verboseDebugKey;
 extern	char *							verboseDebugBase32;
@@ -118,7 +188,19 @@ extern	char *							verboseDebugValue;
 
 // function prototypes
 
-char *									wrapOutput(FILE * outFile, size_t *charsOnLine, size_t *toWrite, char *output);
+char *									wrapOutput(outputSink_t * sink, size_t *charsOnLine, size_t *toWrite, char *output);
+outputSink_t *							outputSinkForFd(int fd);
+outputSink_t *							outputSinkForFile(FILE * file);
+outputSink_t *							outputSinkForView(memoryView_t * view);
+outputSink_t *							outputSinkFree(outputSink_t * sink);
+bool									outputSinkWrite(outputSink_t * sink, char * data, size_t size);
+bool									outputSinkWriteSpan(outputSink_t * sink, char * data, size_t size);
+bool									outputSinkWriteView(outputSink_t * sink, memoryView_t * view, size_t offset, size_t size);
+bool									outputSinkWriteJson(outputSink_t * sink, char * data, size_t size);
+bool									outputSinkFlush(outputSink_t * sink);
+void									outputSinkSetSource(outputSink_t * sink, int fd, char * data, size_t size);
+outputSink_t *							outputStdout(void);
+bool									outputClose(void);
 char *									optionsString(int option, const char * longOption);
 decoder_verbosity_t						__getVerbosity(void);
 void									__setVerbosity(decoder_verbosity_t verbosity);
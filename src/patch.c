@@ -0,0 +1,161 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+#define PATCH_C
+
+#include "common.h"
+#include "patch_usage.c"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+static	char *				__commandNames[] = {
+#include "patch_commands.c"
+		NULL
+};
+static	char * *			commandNames = &__commandNames[0];
+static	commandEntry_t 		__patch_command = { .names = &commandNames, .ep = &patch_entry, .short_desc = &patch_shortdesc, .usage = &patch_usage };
+EXPORTED commandEntry_t *	patch_command = &__patch_command;
+
+// 'patch' function - replace a single file in an export file
+
+int		patch_entry(int argc, char** argv, int argo, commandEntry_t * entry)
+{
+	char *				sectionName = NULL;
+	char *				fileName = NULL;
+	int					fd;
+
+	if (argc > argo + 1)
+	{
+		int				opt;
+		int				optIndex = 0;
+
+		static struct option options_long[] = {
+			verbosity_options_long,
+			options_long_end,
+		};
+		char *			options_short = ":" verbosity_options_short;
+
+		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
+		{
+			switch (opt)
+			{
+				check_verbosity_options_short();
+				help_option();
+				getopt_invalid_option();
+				invalid_option(opt);
+			}
+		} 
+		if (argc > argo + optind)
+			sectionName = argv[argo + optind];
+		if (argc > argo + optind + 1)
+			fileName = argv[argo + optind + 1];
+		if (argc > argo + optind + 2)
+			warnAboutExtraArguments(argv, argo + optind + 2);
+	}
+
+	if (!sectionName || !fileName)
+	{
+		errorMessage(errorMissingArguments);
+		__autoUsage();
+		return EXIT_FAILURE;
+	}
+
+	if ((fd = open(fileName, O_RDONLY | O_CLOEXEC)) < 0)
+	{
+		errorMessage(errorOpeningInputFile, fileName);
+		return EXIT_FAILURE;
+	}
+
+	resetError();
+
+	memoryBuffer_t		*inputFile = NULL;
+	memoryBuffer_t		*consolidated = NULL;
+	size_t				mappedSize = 0;
+	char *				mapped = memoryMapFile(stdin, &mappedSize);
+
+	if (mapped)
+	{
+		/* unchanged parts of the input file may be copied by the kernel now */
+		verboseMessage(verboseInputFileMapped, mappedSize);
+		outputSinkSetSource(outputStdout(), fileno(stdin), mapped, mappedSize);
+		patchExportSection(mapped, mappedSize, sectionName, fd, outputStdout());
+	}
+	else
+	{
+		inputFile = memoryBufferReadFile(stdin, -1);
+
+		if (!inputFile)
+		{
+			if (!isAnyError()) /* empty input file */
+			{
+				errorMessage(errorEmptyInputFile);
+			}
+			else
+			{
+				errorMessage(errorReadToMemory);
+			}
+			close(fd);
+			return EXIT_FAILURE;
+		}
+
+		consolidated = memoryBufferConsolidateData(inputFile);
+		inputFile = memoryBufferFreeChain(inputFile);
+
+		if (!consolidated)
+		{
+			errorMessage(errorNoMemory);
+			close(fd);
+			return EXIT_FAILURE;
+		}
+
+		patchExportSection(consolidated->data, consolidated->used, sectionName, fd, outputStdout());
+	}
+
+	close(fd);
+
+	if (!outputClose())
+	{
+		errorMessage(errorWriteFailed);
+	}
+	else if (isError(INVALID_FILE))
+	{
+		errorMessage(errorNoExportFile, "STDIN");
+	}
+	else if (isError(NO_MEMORY))
+	{
+		errorMessage(errorNoMemory);
+	}
+	else if (isError(IO_ERROR))
+	{
+		errorMessage(errorOpeningInputFile, fileName);
+	}
+
+	if (mapped)
+		mapped = memoryUnmapFile(mapped, mappedSize);
+	if (consolidated)
+		consolidated = memoryBufferFreeChain(consolidated);
+
+	return (!isAnyError() ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+#pragma GCC diagnostic pop
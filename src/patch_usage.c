@@ -0,0 +1,76 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+// display usage help
+
+void 	patch_usage(const bool help, UNUSED const bool version)
+{
+	FILE *	out = (help || version ? stdout : stderr);
+
+	showUsageHeader(out, help, version);
+
+	if (version)
+	{
+		fprintf(out, "\n");
+		return;
+	}
+
+	showPurposeHeader(out);
+	fprintf(out,
+		"This program replaces the content of a single file in an export file and computes the new checksum.\n"
+	);
+
+	showFormatHeader(out);
+	addSpace();
+	addOption("options");
+	addSpace();
+	startOption();
+	addArgument("name");
+	endOption();
+	addSpace();
+	startOption();
+	addArgument("file");
+	endOption();
+	showFormatEnd(out);
+
+	showOptionsHeader("options");
+	addOptionsEntryVerbose();
+	addOptionsEntryQuiet();
+	addOptionsEntryStrict();
+	addOptionsEntryHelp();
+	addOptionsEntryVersion();
+	showOptionsEnd(out);
+
+	fprintf(out,
+		"\nThe export file is read from STDIN, the content of the file with the specified " __undl("name") " is replaced with\n"
+		"the content of " __undl("file") " and the result is written to STDOUT. Binary files are encoded again with the\n"
+		"type used in the export file, encrypted files have to be encrypted already.\n"
+		"\nAll other data is copied unchanged (the kernel copies it without help, if possible) and the new\n"
+		"checksum is computed from the values of the unchanged files and the value of the new content.\n"
+	);
+
+	showUsageFinalize(out, help, version);
+}
+
+char *	patch_shortdesc(void)
+{
+	return "replace a single settings file in an export file";	
+}
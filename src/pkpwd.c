@@ -93,7 +93,7 @@ int		pkpwd_entry(int argc, char** argv, int argo, commandEntry_t * entry)
 	{
 		altenv_verbose_message();
 
-		maca = getEnvironmentValue(NULL, URLADER_MACA_NAME);
+		maca = environmentValue(getEnvironment(), URLADER_MACA_NAME);
 		if (!maca)
 		{
 			errorMessage(errorMissingDeviceProperty, URLADER_MACA_NAME);		
@@ -0,0 +1,290 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#define QRYCFG_C
+
+#include "common.h"
+#include "qrycfg_usage.c"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+static	char *				__commandNames[] = {
+#include "qrycfg_commands.c"
+		NULL
+};
+static	char * *			commandNames = &__commandNames[0];
+static	commandEntry_t 		__qrycfg_command = { .names = &commandNames, .ep = &qrycfg_entry, .usage = &qrycfg_usage, .short_desc = &qrycfg_shortdesc, .usesCrypto = true };
+EXPORTED commandEntry_t *	qrycfg_command = &__qrycfg_command;
+
+// release the list of paths
+
+static	configPath_t * *	freePaths(configPath_t * *paths, size_t count)
+{
+	if (paths)
+	{
+		for (size_t i = 0; i < count; i++)
+			configPathFree(paths[i]);
+		free(paths);
+	}
+
+	return NULL;
+}
+
+// write each value selected by any of the paths, only these values are decrypted - if any cipher-text
+// couldn't be decrypted, DECRYPT_ERR is set after all values were written
+
+static	void	queryConfig(configIndex_t * index, configPath_t * *paths, size_t pathCount, char * key, outputFormat_t format, outputSink_t * out)
+{
+	CipherContext *		ctx = CipherInit(NULL, CipherTypeValue, NULL, NULL, false);
+	size_t				selected = 0;
+	size_t				failed = 0;
+	bool				success = (ctx != NULL);
+
+	for (size_t node = 0; success && node < index->count; node++)
+	{
+		size_t			i;
+
+		if (index->nodes[node].type != CONFIG_NODE_VALUE)
+			continue;
+
+		for (i = 0; i < pathCount && !configPathMatches(index, node, paths[i]); i++);
+
+		if (i == pathCount)
+			continue;
+
+		selected++;
+
+		if (format == OUTPUT_FORMAT_NDJSON)
+			success = (outputSinkWrite(out, "{\"path\":\"", 9) && configWritePath(index, node, out) && outputSinkWrite(out, "\",\"value\":", 10) &&
+					   configWriteValue(&index->nodes[node], ctx, key, format, out, &failed) && outputSinkWrite(out, "}\n", 2));
+		else
+			success = (configWritePath(index, node, out) && outputSinkWrite(out, " = ", 3) &&
+					   configWriteValue(&index->nodes[node], ctx, key, format, out, &failed) && outputSinkWrite(out, "\n", 1));
+	}
+
+	verboseMessage(verboseConfigValuesSelected, (unsigned long) selected, (unsigned long) index->count);
+
+	if (!success && !isAnyError())
+		setError(WRITE_FAILED);
+
+	if (failed && !isAnyError()) /* the values were written, but not all of them were decrypted */
+		setError(DECRYPT_ERR);
+
+	ctx = (ctx ? CipherCleanup(ctx) : NULL);
+}
+
+// 'query_config' function - decrypt selected values from a configuration file on STDIN
+
+int		qrycfg_entry(int argc, char** argv, int argo, commandEntry_t * entry)
+{
+	char *				serial = NULL;
+	char *				maca = NULL;
+	char *				wlanKey = NULL;
+	char *				tr069Passphrase = NULL;
+	bool				altEnv = false;
+	bool				tty = false;
+	outputFormat_t		format = OUTPUT_FORMAT_TEXT;
+	configPath_t * *	paths = NULL;
+	size_t				pathCount = 0;
+
+	if (argc > argo + 1)
+	{
+		int				opt;
+		int				optIndex = 0;
+
+		static struct option options_long[] = {
+			{ "tty", no_argument, NULL, 't' },
+			{ "path", required_argument, NULL, 'p' },
+			format_options_long,
+			altenv_options_long,
+			keycache_options_long,
+			verbosity_options_long,
+			options_long_end,
+		};
+		char *			options_short = ":" "tp:" format_options_short altenv_options_short keycache_options_short verbosity_options_short;
+
+		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
+		{
+			switch (opt)
+			{
+				case 't':
+					tty = true;
+					break;
+
+				case 'p':
+					{
+						configPath_t * *	grown = (configPath_t * *) realloc(paths, (pathCount + 1) * sizeof(configPath_t *));
+
+						if (!grown)
+						{
+							paths = freePaths(paths, pathCount);
+							errorMessage(errorNoMemory);
+							return EXIT_FAILURE;
+						}
+
+						paths = grown;
+
+						if (!(paths[pathCount] = configPathParse(optarg)))
+						{
+							paths = freePaths(paths, pathCount);
+							return EXIT_FAILURE;
+						}
+
+						pathCount++;
+					}
+					break;
+
+				check_format_options_short();
+				check_altenv_options_short();
+				check_keycache_options_short();
+				check_verbosity_options_short();
+				help_option();
+				getopt_argument_missing();
+				getopt_invalid_option();
+				invalid_option(opt);
+			}
+		}
+		if (optind < argc)
+		{
+			int			i = optind + argo;
+			int			index = 0;
+
+			char *		*arguments[] = {
+				&serial,
+				&maca,
+				&wlanKey,
+				&tr069Passphrase,
+				NULL
+			};
+
+			while (argv[i])
+			{
+				if (!argv[i + 1])
+				{
+					if (isatty(0) && !tty)
+					{
+						if (checkLastArgumentIsInputFile(argv[i]))
+							break;
+					}
+				}
+				*(arguments[index++]) = argv[i++];
+				if (!arguments[index])
+				{
+					if (argv[i])
+					{
+						if (checkLastArgumentIsInputFile(argv[i]))
+							i++;
+					}
+					warnAboutExtraArguments(argv,i);
+					break;
+				}
+			}
+		}
+	}
+
+	if (!isAnyError() && pathCount == 0)
+	{
+		errorMessage(errorMissingConfigPath);
+		setError(OPTION_VALUE_MISSING);
+	}
+
+	if (isAnyError())
+	{
+		paths = freePaths(paths, pathCount);
+		return EXIT_FAILURE;
+	}
+
+	resetError();
+
+	CipherSizes();
+
+	char				key[*cipher_keyLen];
+
+	if (!keyFromArguments(key, serial, maca, wlanKey, tr069Passphrase, altEnv))
+	{
+		paths = freePaths(paths, pathCount);
+		return EXIT_FAILURE;
+	}
+
+	if (isatty(0) && !tty)
+	{
+		errorMessage(errorReadFromTTY);
+		paths = freePaths(paths, pathCount);
+		clearMemory(key, *cipher_keyLen, false);
+		return EXIT_FAILURE;
+	}
+
+	memoryBuffer_t		*inputFile = NULL;
+	memoryBuffer_t		*consolidated = NULL;
+	configIndex_t		*index = NULL;
+	size_t				mappedSize = 0;
+	char *				mapped = memoryMapFile(stdin, &mappedSize);
+
+	if (mapped) /* the index references the input data */
+	{
+		verboseMessage(verboseInputFileMapped, mappedSize);
+		index = configIndexParse(mapped, mappedSize, true);
+	}
+	else if ((inputFile = memoryBufferReadFile(stdin, -1)) != NULL)
+	{
+		consolidated = memoryBufferConsolidateData(inputFile);
+		inputFile = memoryBufferFreeChain(inputFile);
+
+		if (consolidated)
+			index = configIndexParse(consolidated->data, consolidated->used, true);
+		else
+		{
+			errorMessage(errorNoMemory);
+		}
+	}
+	else if (isAnyError())
+	{
+		errorMessage(errorReadToMemory);
+	}
+	else /* empty input file */
+		index = configIndexParse("", 0, true);
+
+	if (index)
+	{
+		queryConfig(index, paths, pathCount, key, format, outputStdout());
+		index = configIndexFree(index);
+	}
+	else if (isError(NO_MEMORY))
+	{
+		errorMessage(errorNoMemory);
+	}
+
+	clearMemory(key, *cipher_keyLen, false);
+	paths = freePaths(paths, pathCount);
+
+	if (!outputClose())
+		errorMessage(errorWriteFailed);
+
+	consolidated = memoryBufferFreeChain(consolidated);
+	mapped = memoryUnmapFile(mapped, mappedSize);
+
+	return (isAnyError() ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+#pragma GCC diagnostic pop
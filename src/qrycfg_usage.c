@@ -0,0 +1,106 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+// display usage help
+
+void 	qrycfg_usage(const bool help, UNUSED const bool version)
+{
+	FILE *	out = (help || version ? stdout : stderr);
+
+	showUsageHeader(out, help, version);
+
+	if (version)
+	{
+		fprintf(out, "\n");
+		return;
+	}
+
+	showPurposeHeader(out);
+	fprintf(out,
+		"This program reads a configuration file from STDIN and writes the values of the selected settings to\n"
+		"STDOUT. Only the encrypted data within these values is decrypted.\n"
+	);
+
+	showFormatHeader(out);
+	addSpace();
+	addOption("options");
+	addSpace();
+	endOptions();
+	addSpace();
+	startOption();
+	addArgument("parameter");
+	addSpace();
+	startOption();
+	addNormalString("...");
+	endOption();
+	endOption();
+	addSpace();
+	startOption();
+	startOption();
+	addNormalString("<");
+	endOption();
+	addSpace();
+	addArgument("input-file");
+	endOption();
+	showFormatEnd(out);
+
+	showOptionsHeader("options");
+	addOptionsEntry("-p, --path " __undl("path"), "select the settings to show, this option may be specified more than once and at least one " __undl("path") " is needed", 8);
+	addOptionsEntry("-f, --format " __undl("format"), "write the values as 'text' (the default) or as 'ndjson'", 8);
+	addOptionsEntry("-t, --tty", "don't quit execution, if STDIN is connected to a terminal device", 0);
+	addOptionsEntry("-a, --alt-env " __undl("filename"), "use an alternative source for the 'urlader environment'", 8);
+	addOptionsEntry("-K, --key-cache " __undl("seconds"), "keep the device key in the kernel keyring for " __undl("seconds"), 8);
+	addOptionsEntryVerbose();
+	addOptionsEntryQuiet();
+	addOptionsEntryStrict();
+	addOptionsEntryHelp();
+	addOptionsEntryVersion();
+	showOptionsEnd(out);
+
+	fprintf(out,
+		"\nA %s consists of the names of the sections and the name of the setting, separated by dots\n"
+		"(e.g. 'ar7cfg.ddns.accounts[*].passwd'). An asterisk matches any name. A list of sections (written\n"
+		"as '} {' in the file) is selected with the number of an entry in brackets, starting with zero, or\n"
+		"with an asterisk for all entries - a name without brackets selects all entries too. If the %s\n"
+		"ends with a section, all settings within this section are selected.\n",
+		showUndl("path"), showUndl("path")
+	);
+
+	fprintf(out,
+		"\nEach selected setting is written as a line with its complete path and its value, the path contains\n"
+		"the number of the entry for lists of sections. The 'ndjson' format writes a JSON object with the\n"
+		"keys 'path' and 'value' instead, a value with a list of strings is written as JSON array.\n"
+	);
+
+	fprintf(out,
+		"\nThe %ss select the key the same way as for 'decode_secrets'. Values, which can't be\n"
+		"decrypted with this key, are written unchanged and the exit code is one then.\n",
+		showUndl("parameter")
+	);
+
+	showUsageFinalize(out, help, version);
+}
+
+char *	qrycfg_shortdesc(void)
+{
+	return "decrypt selected settings from a configuration file";
+}
@@ -0,0 +1,265 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+#define REKEY_C
+
+#include "common.h"
+#include "rekey_usage.c"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+static	char *				__commandNames[] = {
+#include "rekey_commands.c"
+		NULL
+};
+static	char * *			commandNames = &__commandNames[0];
+static	commandEntry_t 		__rekey_command = { .names = &commandNames, .ep = &rekey_entry, .usage = &rekey_usage, .short_desc = &rekey_shortdesc, .usesCrypto = true };
+EXPORTED commandEntry_t *	rekey_command = &__rekey_command;
+
+// 'rekey_export' function - encrypt all secret values and encrypted files from the export file on STDIN
+// with the key for another device or password and write the file with a new checksum to STDOUT
+
+int		rekey_entry(int argc, char** argv, int argo, commandEntry_t * entry)
+{
+	char *				serial = NULL;
+	char *				maca = NULL;
+	char *				targetPassword = NULL;
+	char *				targetSerial = NULL;
+	char *				targetMaca = NULL;
+	bool				altEnv = false;
+	bool				tty = false;
+
+	if (argc > argo + 1)
+	{
+		int				opt;
+		int				optIndex = 0;
+
+		static struct option options_long[] = {
+			{ "tty", no_argument, NULL, 't' },
+			{ "target-password", required_argument, NULL, 'P' },
+			{ "target-serial", required_argument, NULL, 'N' },
+			{ "target-maca", required_argument, NULL, 'M' },
+			altenv_options_long,
+			verbosity_options_long,
+			options_long_end,
+		};
+		char *			options_short = ":" "tP:N:M:" altenv_options_short verbosity_options_short;
+
+		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
+		{
+			switch (opt)
+			{
+				case 't':
+					tty = true;
+					break;
+
+				case 'P':
+					targetPassword = optarg;
+					break;
+
+				case 'N':
+					targetSerial = optarg;
+					break;
+
+				case 'M':
+					if (!checkMACAddress(optarg))
+					{
+						errorMessage(errorWrongMACAddress, optarg);
+						return EXIT_FAILURE;
+					}
+					targetMaca = optarg;
+					break;
+
+				check_altenv_options_short();
+				check_verbosity_options_short();
+				help_option();
+				getopt_argument_missing();
+				getopt_invalid_option();
+				invalid_option(opt);
+			}
+		}
+		if (argc > argo + optind)
+			serial = argv[argo + optind];
+		if (argc > argo + optind + 1)
+			maca = argv[argo + optind + 1];
+		if (argc > argo + optind + 2)
+			warnAboutExtraArguments(argv, argo + optind + 2);
+	}
+
+	if (isAnyError())
+		return EXIT_FAILURE;
+
+	if (!targetPassword && !(targetSerial && targetMaca))
+	{
+		errorMessage(errorMissingTargetKey);
+		__autoUsage();
+		return EXIT_FAILURE;
+	}
+
+	if (serial && altEnv)
+	{
+		warningMessage(verboseAltEnvIgnored);
+		failOnStrict();
+	}
+
+	resetError();
+
+	CipherSizes();
+
+	char				key[*cipher_keyLen];
+	char				targetKey[*cipher_keyLen];
+
+	if (!exportKeyFromArguments(key, (maca ? NULL : serial), serial, maca, altEnv) ||
+		!exportKeyFromArguments(targetKey, targetPassword, targetSerial, targetMaca, false))
+	{
+		clearMemory(key, *cipher_keyLen, false);
+		return EXIT_FAILURE;
+	}
+
+	if (isatty(0) && !tty)
+	{
+		errorMessage(errorReadFromTTY);
+		return EXIT_FAILURE;
+	}
+
+	memoryBuffer_t		*inputFile = memoryBufferReadFile(stdin, -1);
+	memoryBuffer_t		*consolidated = NULL;
+
+	if (!inputFile)
+	{
+		if (!isAnyError()) /* empty input file */
+		{
+			errorMessage(errorEmptyInputFile);
+		}
+		else
+		{
+			errorMessage(errorReadToMemory);
+		}
+		return EXIT_FAILURE;
+	}
+
+	consolidated = memoryBufferConsolidateData(inputFile);
+	inputFile = memoryBufferFreeChain(inputFile);
+
+	if (!consolidated)
+	{
+		errorMessage(errorNoMemory);
+		return EXIT_FAILURE;
+	}
+
+	verboseMessage(verboseInputDataConsolidated, memoryBufferDataSize(consolidated));
+
+	memoryIndex_t *		index = memoryIndexNew(consolidated);
+	size_t				found = 0;
+	size_t				valueSize = 0;
+	char				exportKey[*cipher_keyLen];
+	char				targetExportKey[*cipher_keyLen];
+	size_t				exportKeySize = *cipher_keyLen;
+	bool				isString = false;
+	memoryView_t *		output = NULL;
+	outputSink_t *		sink = NULL;
+
+	if (!index)
+	{
+		errorMessage(errorNoMemory);
+		consolidated = memoryBufferFreeChain(consolidated);
+		return EXIT_FAILURE;
+	}
+
+	memset(exportKey, 0, *cipher_keyLen);
+	memset(targetExportKey, 0, *cipher_keyLen);
+
+	if ((found = memoryIndexFindString(index, 0, EXPORT_PASSWORD_NAME, strlen(EXPORT_PASSWORD_NAME))) < index->size)
+	{
+		found += strlen(EXPORT_PASSWORD_NAME);
+		valueSize = memoryIndexValueSize(index, found);
+
+		if (valueSize != 104)
+		{
+			errorMessage(errorInvalidFirstStageLength, valueSize, EXPORT_PASSWORD_NAME);
+			setError(INV_DATA_SIZE);
+		}
+		else if (!decryptValueData(NULL, consolidated->data + found, valueSize, key, exportKey, &exportKeySize, &isString))
+		{
+			errorMessage(errorDecryptionFailed);
+		}
+		else
+		{
+			/* the new random key for the second stage gets the size and the type of the old one */
+
+			if (!(output = memoryViewNew()) || !(sink = outputSinkForView(output)) || !memoryIndexWrite(index, 0, found, sink))
+			{
+				errorMessage(errorNoMemory);
+			}
+			else if (!RandomBytes(targetExportKey, exportKeySize) ||
+					 !encryptValue(NULL, targetExportKey, exportKeySize, isString, targetKey, NULL, sink))
+			{
+				errorMessage(errorEncryptionFailed);
+			}
+
+			memset(exportKey + *cipher_ivLen, 0, *cipher_keyLen - *cipher_ivLen);
+			memset(targetExportKey + *cipher_ivLen, 0, *cipher_keyLen - *cipher_ivLen);
+			found += valueSize;
+		}
+	}
+	else
+	{
+		errorMessage(errorNoPasswordEntry);
+		setError(INVALID_FILE);
+	}
+
+	if (!isAnyError() && !memoryBufferRekeyFile(index, found, exportKey, targetExportKey, sink, key, targetKey))
+	{
+		if (isError(OSSL_CIPHER_ERR))
+		{
+			errorMessage(errorEncryptionFailed);
+		}
+		else if (isError(NO_MEMORY))
+		{
+			errorMessage(errorNoMemory);
+		}
+	}
+
+	clearMemory(exportKey, *cipher_keyLen, false);
+	clearMemory(targetExportKey, *cipher_keyLen, false);
+	clearMemory(key, *cipher_keyLen, false);
+	clearMemory(targetKey, *cipher_keyLen, false);
+
+	/* the checksum is computed from the collected output, after all data was encrypted again */
+
+	if (!isAnyError() && output)
+		computeExportViewChecksum(output, outputStdout());
+
+	if (!outputClose()) /* input buffers are referenced until the data was written */
+		errorMessage(errorWriteFailed);
+
+	if (sink)
+		sink = outputSinkFree(sink);
+	output = memoryViewFree(output);
+	index = memoryIndexFree(index);
+	consolidated = memoryBufferFreeChain(consolidated);
+
+	return (isAnyError() ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,99 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+// display usage help
+
+void 	rekey_usage(const bool help, UNUSED const bool version)
+{
+	FILE *	out = (help || version ? stdout : stderr);
+
+	showUsageHeader(out, help, version);
+
+	if (version)
+	{
+		fprintf(out, "\n");
+		return;
+	}
+
+	showPurposeHeader(out);
+	fprintf(out,
+		"This program encrypts all secret values and encrypted files of an export file on STDIN with the key\n"
+		"for another device or another password and writes the result with a new checksum to STDOUT.\n"
+	);
+
+	showFormatHeader(out);
+	addSpace();
+	addOption("options");
+	addSpace();
+	endOptions();
+	addSpace();
+	startOption();
+	addArgument("password");
+	addAlternative();
+	addArgument("serial");
+	addSpace();
+	addArgument("maca");
+	endOption();
+	addSpace();
+	startOption();
+	addNormalString("<");
+	addSpace();
+	addArgument("input-file");
+	endOption();
+	showFormatEnd(out);
+
+	showOptionsHeader("options");
+	addOptionsEntry("-t, --tty", "don't quit execution, if STDIN is connected to a terminal device", 0);
+	addOptionsEntry("-a, --alt-env " __undl("filename"), "use an alternative source for the 'urlader environment' of the source device", 8);
+	addOptionsEntry("-P, --target-password " __undl("password"), "encrypt the file with the specified " __undl("password"), 8);
+	addOptionsEntry("-N, --target-serial " __undl("serial"), "encrypt the file for the device with the specified " __undl("serial") " number", 8);
+	addOptionsEntry("-M, --target-maca " __undl("maca"), "encrypt the file for the device with the specified MAC address", 8);
+	addOptionsEntryVerbose();
+	addOptionsEntryQuiet();
+	addOptionsEntryStrict();
+	addOptionsEntryHelp();
+	addOptionsEntryVersion();
+	showOptionsEnd(out);
+
+	fprintf(out,
+		"\nThe source key is specified like for %s - a %s or the %s and %s values of\n"
+		"the source device or nothing at all to use the properties of the running device.\n",
+		showBold(DECODER_CONFIG_DECRYPT_EXPORT_FILES_NAME), showUndl("password"), showUndl("serial"), showUndl("maca")
+	);
+
+	fprintf(out,
+		"\nThe target key has to be specified with the '--target-password' (or '-P') option or with both of\n"
+		"the options '--target-serial' (or '-N') and '--target-maca' (or '-M').\n"
+	);
+
+	fprintf(out,
+		"\nA new random key for the second stage is stored in the 'Password' field of the header and all\n"
+		"values are encrypted with a new random IV. Values and files, which can't be decrypted, are written\n"
+		"unchanged with a warning - this is an error in strict mode.\n"
+	);
+
+	showUsageFinalize(out, help, version);
+}
+
+char *	rekey_shortdesc(void)
+{
+	return "encrypt a FRITZ!OS export file for another device or password";
+}
@@ -0,0 +1,285 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#define SCANSEC_C
+
+#include "common.h"
+#include "scansec_usage.c"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+static	char *				__commandNames[] = {
+#include "scansec_commands.c"
+		NULL
+};
+static	char * *			commandNames = &__commandNames[0];
+static	commandEntry_t 		__scansec_command = { .names = &commandNames, .ep = &scansec_entry, .usage = &scansec_usage, .short_desc = &scansec_shortdesc, .usesCrypto = true };
+EXPORTED commandEntry_t *	scansec_command = &__scansec_command;
+
+// write a record for each encrypted value - lines are counted from the previous value on and the key is
+// checked with the first cipher block only, if a context was specified
+
+static	bool	scanSecrets(memoryIndex_t * index, CipherContext * ctx, outputFormat_t format, outputSink_t * out)
+{
+	size_t				position = 0;
+	size_t				line = 1;
+	size_t				counted = 0;
+	size_t				values = 0;
+	size_t				decryptable = 0;
+
+	while (position < index->size)
+	{
+		size_t			found = memoryIndexFindString(index, position, "$$$$", 4);
+		size_t			valueSize;
+		char			name[MEMORY_VALUE_NAME_SIZE];
+		char			record[MEMORY_VALUE_NAME_SIZE + 128];
+		int				recordSize;
+		char *			check = "";
+
+		if (found == index->size)
+			break;
+
+		if ((valueSize = memoryIndexValueSize(index, found + 4)) == 0) /* no cipher-text behind the marker */
+		{
+			position = found + 4;
+			continue;
+		}
+
+		line += memoryIndexCountLines(index, counted, found);
+		counted = found;
+		values++;
+
+		memoryIndexValueName(index, found, name, sizeof(name));
+
+		if (ctx)
+		{
+			char		cipherText[VALUE_CHECK_BASE32_SIZE];
+			size_t		size = (valueSize < sizeof(cipherText) ? valueSize : sizeof(cipherText));
+			bool		matches;
+
+			for (size_t offset = 0; offset < size; ) /* the first characters may cross segment borders */
+			{
+				struct iovec	single;
+
+				memoryIndexGetVector(index, found + 4 + offset, size - offset, &single, 1);
+				memcpy(cipherText + offset, single.iov_base, single.iov_len);
+				offset += single.iov_len;
+			}
+
+			if ((matches = checkValueKey(ctx, cipherText, valueSize)))
+				decryptable++;
+
+			if (format == OUTPUT_FORMAT_NDJSON)
+				check = (matches ? ",\"decryptable\":true" : ",\"decryptable\":false");
+			else
+				check = (matches ? "\tyes" : "\tno");
+		}
+
+		if (format == OUTPUT_FORMAT_NDJSON)
+		{
+			if (*name)
+				recordSize = snprintf(record, sizeof(record), "{\"offset\":%lu,\"line\":%lu,\"length\":%lu,\"key\":\"%s\"%s}\n", (unsigned long) found, (unsigned long) line, (unsigned long) valueSize, name, check);
+			else
+				recordSize = snprintf(record, sizeof(record), "{\"offset\":%lu,\"line\":%lu,\"length\":%lu,\"key\":null%s}\n", (unsigned long) found, (unsigned long) line, (unsigned long) valueSize, check);
+		}
+		else
+			recordSize = snprintf(record, sizeof(record), "%lu\t%lu\t%lu\t%s%s\n", (unsigned long) found, (unsigned long) line, (unsigned long) valueSize, (*name ? name : "-"), check);
+
+		if (!outputSinkWrite(out, record, recordSize))
+			returnError(WRITE_FAILED, false);
+
+		position = found + 4 + valueSize;
+	}
+
+	verboseMessage(verboseValuesScanned, (unsigned long) values, (unsigned long) decryptable);
+
+	return true;
+}
+
+// 'scan_secrets' function - list all encrypted values from STDIN content without decrypting them
+
+int		scansec_entry(int argc, char** argv, int argo, commandEntry_t * entry)
+{
+	char *				serial = NULL;
+	char *				maca = NULL;
+	char *				wlanKey = NULL;
+	char *				tr069Passphrase = NULL;
+	bool				altEnv = false;
+	bool				tty = false;
+	bool				checkKey = false;
+	outputFormat_t		format = OUTPUT_FORMAT_TEXT;
+
+	if (argc > argo + 1)
+	{
+		int				opt;
+		int				optIndex = 0;
+
+		static struct option options_long[] = {
+			{ "tty", no_argument, NULL, 't' },
+			{ "check-key", no_argument, NULL, 'c' },
+			format_options_long,
+			altenv_options_long,
+			keycache_options_long,
+			verbosity_options_long,
+			options_long_end,
+		};
+		char *			options_short = ":" "tc" format_options_short altenv_options_short keycache_options_short verbosity_options_short;
+
+		while ((opt = getopt_long(argc - argo, &argv[argo], options_short, options_long, &optIndex)) != -1)
+		{
+			switch (opt)
+			{
+				case 't':
+					tty = true;
+					break;
+
+				case 'c':
+					checkKey = true;
+					break;
+
+				check_format_options_short();
+				check_altenv_options_short();
+				check_keycache_options_short();
+				check_verbosity_options_short();
+				help_option();
+				getopt_argument_missing();
+				getopt_invalid_option();
+				invalid_option(opt);
+			}
+		}
+		if (optind < argc)
+		{
+			int			i = optind + argo;
+			int			index = 0;
+
+			char *		*arguments[] = {
+				&serial,
+				&maca,
+				&wlanKey,
+				&tr069Passphrase,
+				NULL
+			};
+
+			while (argv[i])
+			{
+				if (!argv[i + 1])
+				{
+					if (isatty(0) && !tty)
+					{
+						if (checkLastArgumentIsInputFile(argv[i]))
+							break;
+					}
+				}
+				*(arguments[index++]) = argv[i++];
+				if (!arguments[index])
+				{
+					if (argv[i])
+					{
+						if (checkLastArgumentIsInputFile(argv[i]))
+							i++;
+					}
+					warnAboutExtraArguments(argv,i);
+					break;
+				}
+			}
+		}
+	}
+
+	if (isAnyError())
+		return EXIT_FAILURE;
+
+	resetError();
+
+	CipherSizes();
+
+	char				key[*cipher_keyLen];
+	CipherContext *		ctx = NULL;
+
+	memset(key, 0, *cipher_keyLen);
+
+	if (checkKey)
+	{
+		if (!keyFromArguments(key, serial, maca, wlanKey, tr069Passphrase, altEnv))
+			return EXIT_FAILURE;
+
+		if (!(ctx = CipherInit(NULL, CipherTypeFile, key, NULL, false)))
+		{
+			clearMemory(key, *cipher_keyLen, false);
+			errorMessage(errorNoMemory);
+			return EXIT_FAILURE;
+		}
+	}
+	else if (serial)
+	{
+		warningMessage(verboseTooMuchArguments, serial);
+		failOnStrict();
+	}
+
+	if (isatty(0) && !tty)
+	{
+		errorMessage(errorReadFromTTY);
+		ctx = (ctx ? CipherCleanup(ctx) : NULL);
+		return EXIT_FAILURE;
+	}
+
+	memoryBuffer_t		*inputFile = NULL;
+	memoryIndex_t		*index = NULL;
+	size_t				mappedSize = 0;
+	char *				mapped = memoryMapFile(stdin, &mappedSize);
+
+	if (mapped)
+	{
+		verboseMessage(verboseInputFileMapped, mappedSize);
+		index = memoryIndexFromData(mapped, mappedSize);
+	}
+	else if ((inputFile = memoryBufferReadFile(stdin, -1)) != NULL)
+		index = memoryIndexNew(inputFile);
+	else if (!isAnyError()) /* empty input file */
+	{
+		ctx = (ctx ? CipherCleanup(ctx) : NULL);
+		clearMemory(key, *cipher_keyLen, false);
+		return EXIT_SUCCESS;
+	}
+
+	if (!index)
+	{
+		errorMessage(errorNoMemory);
+	}
+	else
+		scanSecrets(index, ctx, format, outputStdout());
+
+	ctx = (ctx ? CipherCleanup(ctx) : NULL);
+	clearMemory(key, *cipher_keyLen, false);
+
+	if (!outputClose())
+		errorMessage(errorWriteFailed);
+
+	index = memoryIndexFree(index);
+	inputFile = memoryBufferFreeChain(inputFile);
+	mapped = memoryUnmapFile(mapped, mappedSize);
+
+	return (isAnyError() ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,108 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+// display usage help
+
+void 	scansec_usage(const bool help, UNUSED const bool version)
+{
+	FILE *	out = (help || version ? stdout : stderr);
+
+	showUsageHeader(out, help, version);
+
+	if (version)
+	{
+		fprintf(out, "\n");
+		return;
+	}
+
+	showPurposeHeader(out);
+	fprintf(out,
+		"This program lists all occurrences of encrypted data on STDIN without decrypting them.\n"
+	);
+
+	showFormatHeader(out);
+	addSpace();
+	addOption("options");
+	addSpace();
+	endOptions();
+	addSpace();
+	startOption();
+	addArgument("parameter");
+	addSpace();
+	startOption();
+	addNormalString("...");
+	endOption();
+	endOption();
+	addSpace();
+	startOption();
+	startOption();
+	addNormalString("<");
+	endOption();
+	addSpace();
+	addArgument("input-file");
+	endOption();
+	showFormatEnd(out);
+
+	showOptionsHeader("options");
+	addOptionsEntry("-t, --tty", "don't quit execution, if STDIN is connected to a terminal device", 0);
+	addOptionsEntry("-f, --format " __undl("format"), "write the records as 'text' (the default) or as 'ndjson'", 8);
+	addOptionsEntry("-c, --check-key", "check for each value, if it may be decrypted with the key from the specified " __undl("parameter") "s", 0);
+	addOptionsEntry("-a, --alt-env " __undl("filename"), "use an alternative source for the 'urlader environment'", 8);
+	addOptionsEntry("-K, --key-cache " __undl("seconds"), "keep the device key in the kernel keyring for " __undl("seconds"), 8);
+	addOptionsEntryVerbose();
+	addOptionsEntryQuiet();
+	addOptionsEntryStrict();
+	addOptionsEntryHelp();
+	addOptionsEntryVersion();
+	showOptionsEnd(out);
+
+	fprintf(out,
+		"\nA record is written for each encrypted value. It contains the offset of the four dollar-signs in\n"
+		"front of the value, the number of the line, the number of Base32 characters and the name of the\n"
+		"setting, which is assigned the value ('-' or 'null', if there's no name in front of it). Text\n"
+		"records have tab-separated fields, 'ndjson' records are JSON objects with the keys 'offset',\n"
+		"'line', 'length' and 'key'.\n"
+	);
+
+	fprintf(out,
+		"\nIf the '--check-key' (or '-c') option is specified, the first cipher block of each value is\n"
+		"decrypted and the record gets an additional field ('yes' or 'no' for text records, 'decryptable'\n"
+		"for JSON objects). Only the size stored in this block is checked, the value isn't decrypted\n"
+		"completely. The %ss select the key the same way as for 'decode_secrets'.\n",
+		showUndl("parameter")
+	);
+
+	fprintf(out,
+		"\nSTDIN has to be redirected or the program will be aborted, unless the '--tty' option was specified.\n"
+		"If STDIN is connected to a terminal device, the last expected value from command line is checked,\n"
+		"wether it's the name of a readable file. In this case the specified %s will be used as\n"
+		"source of input data.\n",
+		showUndl("input-file")
+	);
+
+	showUsageFinalize(out, help, version);
+}
+
+char *	scansec_shortdesc(void)
+{
+	return "list encrypted values with their location, without decrypting them";
+}
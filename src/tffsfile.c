@@ -0,0 +1,441 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#define TFFSFILE_C
+
+#include "common.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+// TFFS image processing
+
+// numbers are stored in big endian order
+
+static	uint16_t	tffsGet16(char * data)
+{
+	return (uint16_t) ((((unsigned char) *data) << 8) | ((unsigned char) *(data + 1)));
+}
+
+static	uint32_t	tffsGet32(char * data)
+{
+	return ((uint32_t) tffsGet16(data) << 16) | tffsGet16(data + 2);
+}
+
+// entries are ordered by ID, by segment number and by position - the last entry of an ID is the
+// newest one
+
+static	int		compareTffsNodes(const void * left, const void * right)
+{
+	tffsNode_t *		leftNode = (tffsNode_t *) left;
+	tffsNode_t *		rightNode = (tffsNode_t *) right;
+
+	if (leftNode->id != rightNode->id)
+		return (leftNode->id < rightNode->id ? -1 : 1);
+
+	if (leftNode->segment != rightNode->segment)
+		return (leftNode->segment < rightNode->segment ? -1 : 1);
+
+	return (leftNode->offset < rightNode->offset ? -1 : (leftNode->offset > rightNode->offset ? 1 : 0));
+}
+
+// assign the names from the name table - each entry contains a 32-bit ID and a name terminated by a
+// NUL character, padded to a multiple of 4 bytes
+
+static	void	tffsImageNames(tffsImage_t * image)
+{
+	tffsNode_t *		table = tffsImageNode(image, TFFS_ID_NAME_TABLE);
+	size_t				position = 0;
+
+	if (!table)
+		return;
+
+	while (position + 4 < table->size)
+	{
+		uint32_t		id = tffsGet32(table->data + position);
+		char *			name = table->data + position + 4;
+		char *			end = memchr(name, 0, table->size - position - 4);
+		tffsNode_t *	node;
+
+		if (!end) /* damaged table */
+			break;
+
+		if (id <= TFFS_ID_FREE && (node = tffsImageNode(image, (uint16_t) id)) != NULL && end > name)
+			node->name = name;
+
+		position = (((end + 1) - table->data) + 3) & ~((size_t) 3);
+	}
+}
+
+// index all entries of all segments in an image, a later segment may follow the erased space at the
+// end of a segment
+
+EXPORTED	tffsImage_t *	tffsImageParse(char * data, size_t size)
+{
+	tffsImage_t *		image = (tffsImage_t *) calloc(1, sizeof(tffsImage_t));
+	size_t				allocated = 0;
+	size_t				position = 0;
+	size_t				count = 0;
+
+	if (!image)
+		returnError(NO_MEMORY, NULL);
+
+	while (position + TFFS_SEGMENT_HEADER_SIZE <= size &&
+		   tffsGet16(data + position) == TFFS_ID_SEGMENT && tffsGet16(data + position + 2) == 4)
+	{
+		uint32_t		segment = tffsGet32(data + position + TFFS_ENTRY_HEADER_SIZE);
+
+		verboseMessage(verboseTffsSegment, (unsigned long) segment, (unsigned long) position);
+		image->segments++;
+		position += TFFS_SEGMENT_HEADER_SIZE;
+
+		while (position + TFFS_ENTRY_HEADER_SIZE <= size)
+		{
+			uint16_t	id = tffsGet16(data + position);
+			size_t		length = tffsGet16(data + position + 2);
+
+			if (id == TFFS_ID_FREE)
+				break;
+
+			if (position + TFFS_ENTRY_HEADER_SIZE + length > size)
+			{
+				warningMessage(verboseTffsTruncated, (unsigned long) position);
+				break;
+			}
+
+			if (id != TFFS_ID_DELETED)
+			{
+				if (count == allocated)
+				{
+					tffsNode_t *	grown = (tffsNode_t *) realloc(image->nodes, (allocated ? allocated * 2 : 64) * sizeof(tffsNode_t));
+
+					if (!grown)
+					{
+						image = tffsImageFree(image);
+						returnError(NO_MEMORY, NULL);
+					}
+
+					image->nodes = grown;
+					allocated = (allocated ? allocated * 2 : 64);
+				}
+
+				image->nodes[count].id = id;
+				image->nodes[count].segment = segment;
+				image->nodes[count].offset = position;
+				image->nodes[count].data = data + position + TFFS_ENTRY_HEADER_SIZE;
+				image->nodes[count].size = length;
+				image->nodes[count].name = NULL;
+				count++;
+			}
+
+			position += TFFS_ENTRY_HEADER_SIZE + ((length + 3) & ~((size_t) 3));
+		}
+
+		while (position + 4 <= size && tffsGet32(data + position) == 0xFFFFFFFF) /* erased flash */
+			position += 4;
+	}
+
+	if (image->segments == 0)
+	{
+		image = tffsImageFree(image);
+		returnError(INVALID_FILE, NULL);
+	}
+
+	/* only the newest version of each node is kept - without any entry, there's no array to sort */
+
+	if (count > 0)
+	{
+		qsort(image->nodes, count, sizeof(tffsNode_t), &compareTffsNodes);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			if (i + 1 < count && image->nodes[i + 1].id == image->nodes[i].id)
+				continue;
+
+			image->nodes[image->count++] = image->nodes[i];
+		}
+	}
+
+	tffsImageNames(image);
+
+	return image;
+}
+
+// release an index, the image data remains unchanged
+
+EXPORTED	tffsImage_t *	tffsImageFree(tffsImage_t * image)
+{
+	if (image)
+	{
+		if (image->nodes)
+			free(image->nodes);
+		free(image);
+	}
+
+	return NULL;
+}
+
+// find a node by its ID
+
+EXPORTED	tffsNode_t *	tffsImageNode(tffsImage_t * image, uint16_t id)
+{
+	size_t				low = 0;
+	size_t				high = image->count;
+
+	while (low < high)
+	{
+		size_t			middle = low + (high - low) / 2;
+
+		if (image->nodes[middle].id == id)
+			return &image->nodes[middle];
+
+		if (image->nodes[middle].id < id)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return NULL;
+}
+
+// build the text of the 'urlader environment' from its nodes - the result has the same format as the
+// file in procfs and room for a terminating NUL character, it has to be freed by the caller
+
+EXPORTED	char *	tffsImageEnvironment(tffsImage_t * image, size_t * size)
+{
+	char *				text;
+	size_t				used = 0;
+	size_t				needed = 1;
+
+	for (size_t i = 0; i < image->count; i++)
+	{
+		if (image->nodes[i].id >= TFFS_ID_ENV_FIRST && image->nodes[i].id <= TFFS_ID_ENV_LAST && image->nodes[i].name)
+			needed += strlen(image->nodes[i].name) + image->nodes[i].size + 2;
+	}
+
+	if (!(text = (char *) malloc(needed)))
+		returnError(NO_MEMORY, NULL);
+
+	for (size_t i = 0; i < image->count; i++)
+	{
+		tffsNode_t *	node = &image->nodes[i];
+		char *			end;
+		size_t			nameSize;
+		size_t			valueSize;
+
+		if (node->id < TFFS_ID_ENV_FIRST || node->id > TFFS_ID_ENV_LAST || !node->name)
+			continue;
+
+		nameSize = strlen(node->name);
+		valueSize = ((end = memchr(node->data, 0, node->size)) != NULL ? (size_t) (end - node->data) : node->size);
+
+		memcpy(text + used, node->name, nameSize);
+		used += nameSize;
+		*(text + used++) = '\t';
+		memcpy(text + used, node->data, valueSize);
+		used += valueSize;
+		*(text + used++) = '\n';
+	}
+
+	*(text + used) = 0;
+	*size = used;
+
+	return text;
+}
+
+// write data to a new file in the output directory, only the owner may read it
+
+static	bool	tffsWriteFile(int dirFd, char * name, char * data, size_t size, char * key)
+{
+	int					fd = openat(dirFd, name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	outputSink_t *		sink;
+	memoryIndex_t *		index = NULL;
+	bool				success = false;
+
+	if (fd < 0)
+	{
+		errorMessage(errorOpeningOutputFile, name);
+		returnError(IO_ERROR, false);
+	}
+
+	verboseMessage(verboseOpenedOutputFile, name);
+
+	if ((sink = outputSinkForFd(fd)) != NULL)
+	{
+		if (key) /* secrets are decrypted, data is referenced from the input until the sink is flushed */
+		{
+			if ((index = memoryIndexFromData(data, size)) != NULL)
+				success = memoryBufferProcessFile(index, 0, key, sink, NULL, NULL);
+			else
+				setError(NO_MEMORY);
+		}
+		else
+			success = outputSinkWriteSpan(sink, data, size);
+
+		success = (outputSinkFlush(sink) && success);
+		sink = outputSinkFree(sink);
+		index = memoryIndexFree(index);
+	}
+	else
+		setError(NO_MEMORY);
+
+	if (close(fd) != 0 || !success)
+	{
+		if (!isAnyError())
+			setError(WRITE_FAILED);
+		return false;
+	}
+
+	return true;
+}
+
+// get the content of a node - it's decompressed, if it's a zlib stream (optionally with its size in
+// front of it), the result has to be freed by the caller, if it's another buffer
+
+static	char *	tffsNodeContent(tffsNode_t * node, const char * name, size_t * size)
+{
+	size_t				skip = 0;
+	size_t				hint = 0;
+	char *				content;
+
+	if (!inflateIsZlib(node->data, node->size))
+	{
+		if (node->size <= 4 || !inflateIsZlib(node->data + 4, node->size - 4))
+		{
+			*size = node->size;
+			return node->data;
+		}
+
+		skip = 4;
+		hint = tffsGet32(node->data);
+		hint = (hint <= INFLATE_MAX_SIZE ? hint : 0);
+	}
+
+	if ((content = inflateZlib(node->data + skip, node->size - skip, hint, size)) != NULL)
+	{
+		verboseMessage(verboseTffsNodeInflated, name, (unsigned long) node->size, (unsigned long) *size);
+		return content;
+	}
+
+	resetError();
+	warningMessage(verboseTffsNodeNotInflated, name);
+	*size = node->size;
+
+	return node->data;
+}
+
+// check, if a node is written to its own file - the environment is written as a whole and nodes
+// without content are skipped
+
+static	bool	tffsNodeWritten(tffsNode_t * node)
+{
+	return !((node->id >= TFFS_ID_ENV_FIRST && node->id <= TFFS_ID_NAME_TABLE) || node->size == 0);
+}
+
+// check, if the name of a node may be used as file name in the output directory
+
+static	bool	tffsNodeNameUsable(tffsNode_t * node)
+{
+	return (node->name && strlen(node->name) <= NAME_MAX && !strchr(node->name, '/') && strcmp(node->name, ".") &&
+			strcmp(node->name, "..") && strcmp(node->name, TFFS_ENVIRONMENT_FILE));
+}
+
+// check, if the name of a node was used for a file already - the name table may contain the same name
+// for more than one ID, each further node is written with its ID as name then
+
+static	bool	tffsNodeNameTaken(tffsImage_t * image, size_t current)
+{
+	tffsNode_t *		node = &image->nodes[current];
+
+	for (size_t i = 0; i < current; i++)
+	{
+		tffsNode_t *	other = &image->nodes[i];
+
+		if (tffsNodeWritten(other) && tffsNodeNameUsable(other) && !strcmp(other->name, node->name))
+			return true;
+	}
+
+	return false;
+}
+
+// write the environment and all other nodes with content to files in the specified directory, the
+// secrets in them are decrypted with the specified key (if any) - nodes without a usable name are
+// written with their ID as name, a value, which can't be decrypted, doesn't stop the other nodes
+
+EXPORTED	bool	tffsDecodeNodes(tffsImage_t * image, char * key, const char * path)
+{
+	int					dirFd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	char *				environment;
+	size_t				environmentSize = 0;
+	size_t				written = 0;
+	bool				failed = false;
+
+	if (dirFd < 0)
+		returnError(IO_ERROR, false);
+
+	if ((environment = tffsImageEnvironment(image, &environmentSize)) != NULL)
+	{
+		tffsWriteFile(dirFd, TFFS_ENVIRONMENT_FILE, environment, environmentSize, NULL);
+		environment = clearMemory(environment, environmentSize + 1, true);
+	}
+
+	for (size_t i = 0; i < image->count && !isAnyError(); i++)
+	{
+		tffsNode_t *	node = &image->nodes[i];
+		char			name[NAME_MAX + 1];
+		char *			content;
+		size_t			contentSize = 0;
+
+		if (!tffsNodeWritten(node))
+			continue;
+
+		if (tffsNodeNameUsable(node) && !tffsNodeNameTaken(image, i))
+			strcpy(name, node->name);
+		else
+			snprintf(name, sizeof(name), "node_%04X", node->id);
+
+		content = tffsNodeContent(node, name, &contentSize);
+
+		if (tffsWriteFile(dirFd, name, content, contentSize, key))
+			written++;
+		else if (isError(DECRYPT_ERR)) /* the file was written, but not all values were decrypted */
+		{
+			resetError();
+			failed = true;
+			written++;
+		}
+
+		if (content != node->data)
+			clearMemory(content, contentSize, true);
+	}
+
+	verboseMessage(verboseTffsNodesWritten, (unsigned long) written, path);
+	close(dirFd);
+
+	if (failed && !isAnyError())
+		setError(DECRYPT_ERR);
+
+	return !isAnyError();
+}
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,71 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+
+#ifndef TFFSFILE_H
+
+#define TFFSFILE_H
+
+#include "common.h"
+
+// TFFS (the flash file system of FRITZ!OS for settings) - a segment starts with an entry containing its
+// number, each entry has a 16-bit ID and a 16-bit length (both in big endian order) in front of its data
+// and the data is padded to a multiple of 4 bytes; erased flash (an ID of 0xFFFF) ends a segment
+
+#define	TFFS_ID_SEGMENT				0x0000	/* first entry of a segment */
+#define	TFFS_ID_DELETED				0x0000	/* any other entry with this ID was removed */
+#define	TFFS_ID_ENV_FIRST			0x0100	/* 'urlader environment' variables */
+#define	TFFS_ID_ENV_LAST			0x01FE
+#define	TFFS_ID_NAME_TABLE			0x01FF	/* names of the nodes */
+#define	TFFS_ID_FREE				0xFFFF
+
+#define	TFFS_ENTRY_HEADER_SIZE		4
+#define	TFFS_SEGMENT_HEADER_SIZE	8
+#define	TFFS_ENVIRONMENT_FILE		"environment"
+
+// newest version of a node
+
+typedef struct tffsNode {
+	uint16_t			id;
+	uint32_t			segment;
+	size_t				offset;
+	char *				data;
+	size_t				size;
+	char *				name;			/* NULL, if the name table doesn't contain the ID */
+} tffsNode_t;
+
+// index of an image, the nodes are sorted by ID
+
+typedef struct tffsImage {
+	tffsNode_t *		nodes;
+	size_t				count;
+	size_t				segments;
+} tffsImage_t;
+
+// function prototypes
+
+tffsImage_t *		tffsImageParse(char * data, size_t size);
+tffsImage_t *		tffsImageFree(tffsImage_t * image);
+tffsNode_t *		tffsImageNode(tffsImage_t * image, uint16_t id);
+char *				tffsImageEnvironment(tffsImage_t * image, size_t * size);
+bool				tffsDecodeNodes(tffsImage_t * image, char * key, const char * path);
+
+#endif
@@ -0,0 +1,349 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+#define VALUECACHE_C
+
+#include "common.h"
+
+// cache of decrypted values
+
+// compute a digest over a label and a value, the first VALUE_CACHE_TAG_SIZE bytes are used
+
+static	bool	valueCacheDigest(char * output, const char * label, size_t labelSize, char * data, size_t dataSize)
+{
+	DigestContext *		ctx = DigestInit();
+	char				digest[MAX_DIGEST_SIZE];
+	bool				success = false;
+
+	if (!ctx)
+		return false;
+
+	if (DigestUpdate(ctx, (char *) label, labelSize) && DigestUpdate(ctx, data, dataSize) && DigestFinal(ctx, digest))
+	{
+		memcpy(output, digest, VALUE_CACHE_TAG_SIZE);
+		success = true;
+	}
+
+	ctx = DigestCleanup(ctx);
+	clearMemory(digest, sizeof(digest), false);
+
+	return success;
+}
+
+// compute the tag of a cipher-text, which may be spread over more than one memory span
+
+static	bool	valueCacheTag(char * tag, char * keyId, struct iovec * cipherText, int count)
+{
+	DigestContext *		ctx = DigestInit();
+	char				digest[MAX_DIGEST_SIZE];
+	bool				success;
+
+	if (!ctx)
+		return false;
+
+	success = DigestUpdate(ctx, keyId, VALUE_CACHE_TAG_SIZE);
+
+	for (int i = 0; success && i < count; i++)
+		success = DigestUpdate(ctx, (char *) cipherText[i].iov_base, cipherText[i].iov_len);
+
+	if (success && (success = DigestFinal(ctx, digest)))
+		memcpy(tag, digest, VALUE_CACHE_TAG_SIZE);
+
+	ctx = DigestCleanup(ctx);
+	clearMemory(digest, sizeof(digest), false);
+
+	return success;
+}
+
+// set up an empty cache file
+
+static	bool	valueCacheInitFile(int fd, size_t size)
+{
+	valueCacheHeader_t	header;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, VALUE_CACHE_MAGIC, sizeof(header.magic));
+	header.sets = VALUE_CACHE_SETS;
+	header.ways = VALUE_CACHE_WAYS;
+	header.slotSize = sizeof(valueCacheSlot_t);
+
+	if (ftruncate(fd, 0) || ftruncate(fd, size)) /* all slots are empty (zero) */
+		return false;
+
+	return (pwrite(fd, &header, sizeof(header), 0) == sizeof(header));
+}
+
+// open (or create) the cache in the specified directory - the file is locked exclusively, while it's
+// in use, and it's accessible by its owner only
+
+EXPORTED	valueCache_t *	valueCacheOpen(const char * path, char * key)
+{
+	valueCache_t *		cache = (valueCache_t *) malloc(sizeof(valueCache_t));
+	size_t				size = sizeof(valueCacheHeader_t) + ((size_t) VALUE_CACHE_SETS * VALUE_CACHE_WAYS * sizeof(valueCacheSlot_t));
+	valueCacheHeader_t	header;
+	struct stat			st;
+	int					dirFd;
+
+	if (!cache)
+		returnError(NO_MEMORY, NULL);
+
+	memset(cache, 0, sizeof(valueCache_t));
+	cache->fd = -1;
+	cache->mapped = MAP_FAILED;
+
+	if (mkdir(path, 0700) && errno != EEXIST)
+	{
+		cache = valueCacheClose(cache);
+		returnError(IO_ERROR, NULL);
+	}
+
+	if ((dirFd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) >= 0)
+	{
+		cache->fd = openat(dirFd, VALUE_CACHE_FILE_NAME, O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+		close(dirFd);
+	}
+
+	if (cache->fd < 0 || fchmod(cache->fd, 0600) || flock(cache->fd, LOCK_EX) || fstat(cache->fd, &st))
+	{
+		cache = valueCacheClose(cache);
+		returnError(IO_ERROR, NULL);
+	}
+
+	/* a file with another layout (or a damaged one) is replaced by an empty cache */
+
+	if ((size_t) st.st_size != size || pread(cache->fd, &header, sizeof(header), 0) != sizeof(header) ||
+		memcmp(header.magic, VALUE_CACHE_MAGIC, sizeof(header.magic)) || header.sets != VALUE_CACHE_SETS ||
+		header.ways != VALUE_CACHE_WAYS || header.slotSize != sizeof(valueCacheSlot_t))
+	{
+		if (!valueCacheInitFile(cache->fd, size))
+		{
+			cache = valueCacheClose(cache);
+			returnError(IO_ERROR, NULL);
+		}
+	}
+
+	if ((cache->mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, cache->fd, 0)) == MAP_FAILED)
+	{
+		cache = valueCacheClose(cache);
+		returnError(IO_ERROR, NULL);
+	}
+
+	cache->mappedSize = size;
+	cache->header = (valueCacheHeader_t *) cache->mapped;
+	cache->slots = (valueCacheSlot_t *) (cache->mapped + sizeof(valueCacheHeader_t));
+
+	/* the key ID separates entries for different keys, the data key is only used for the cache */
+
+	if (!(cache->key = (char *) malloc(*cipher_keyLen)))
+	{
+		cache = valueCacheClose(cache);
+		returnError(NO_MEMORY, NULL);
+	}
+
+	memset(cache->key, 0, *cipher_keyLen);
+
+	if (!valueCacheDigest(cache->keyId, "decoder value cache id", strlen("decoder value cache id"), key, *cipher_keyLen) ||
+		!valueCacheDigest(cache->key, "decoder value cache key", strlen("decoder value cache key"), key, *cipher_keyLen))
+	{
+		cache = valueCacheClose(cache);
+		returnError(OSSL_DIGEST_ERR, NULL);
+	}
+
+	if (!(cache->decryptCtx = CipherInit(NULL, CipherTypeFile, cache->key, NULL, false)) ||
+		!(cache->encryptCtx = CipherEncryptInit(NULL, CipherTypeFile, cache->key, NULL)))
+	{
+		cache = valueCacheClose(cache);
+		returnError(OSSL_CIPHER_ERR, NULL);
+	}
+
+	return cache;
+}
+
+// release all resources of a cache, the lock is removed with closing the file
+
+EXPORTED	valueCache_t *	valueCacheClose(valueCache_t * cache)
+{
+	if (!cache)
+		return NULL;
+
+	if (cache->mapped != MAP_FAILED)
+		munmap(cache->mapped, cache->mappedSize);
+
+	if (cache->fd >= 0)
+		close(cache->fd);
+
+	if (cache->decryptCtx)
+		cache->decryptCtx = CipherCleanup(cache->decryptCtx);
+
+	if (cache->encryptCtx)
+		cache->encryptCtx = CipherCleanup(cache->encryptCtx);
+
+	if (cache->key)
+		cache->key = clearMemory(cache->key, *cipher_keyLen, true);
+
+	clearMemory(cache, sizeof(valueCache_t), true);
+
+	return NULL;
+}
+
+// locate the slot for a cipher-text - an empty slot or the least recently used one of the set is
+// returned, if the tag wasn't found
+
+static	valueCacheSlot_t *	valueCacheFind(valueCache_t * cache, char * tag, bool * found)
+{
+	uint32_t			set = (((uint32_t) (unsigned char) tag[0] << 24) | ((uint32_t) (unsigned char) tag[1] << 16) |
+						   ((uint32_t) (unsigned char) tag[2] << 8) | (uint32_t) (unsigned char) tag[3]) % VALUE_CACHE_SETS;
+	valueCacheSlot_t *	slot = cache->slots + ((size_t) set * VALUE_CACHE_WAYS);
+	valueCacheSlot_t *	oldest = slot;
+
+	*found = false;
+
+	for (size_t i = 0; i < VALUE_CACHE_WAYS; i++, slot++)
+	{
+		if (slot->used && memcmp(slot->tag, tag, VALUE_CACHE_TAG_SIZE) == 0)
+		{
+			*found = true;
+			return slot;
+		}
+
+		if (slot->used < oldest->used)
+			oldest = slot;
+	}
+
+	return oldest;
+}
+
+// data at rest is encrypted in CBC mode with the tag of an entry as IV - it's chained here from single
+// blocks, this way the contexts don't need a new initialization for each entry
+
+static	bool	valueCacheEncrypt(valueCache_t * cache, char * tag, char * plain, char * data, size_t size)
+{
+	char				block[*cipher_blockSize];
+	char *				previous = tag;
+	size_t				outSize = 0;
+
+	for (size_t offset = 0; offset < size; offset += *cipher_blockSize)
+	{
+		for (size_t i = 0; i < *cipher_blockSize; i++)
+			block[i] = plain[offset + i] ^ previous[i];
+
+		if (!CipherEncryptUpdate(cache->encryptCtx, data + offset, &outSize, block, *cipher_blockSize))
+			return false;
+
+		previous = data + offset;
+	}
+
+	clearMemory(block, *cipher_blockSize, false);
+
+	return true;
+}
+
+static	bool	valueCacheDecrypt(valueCache_t * cache, char * tag, char * data, char * plain, size_t size)
+{
+	size_t				outSize = 0;
+
+	if (!CipherUpdate(cache->decryptCtx, plain, &outSize, data, size))
+		return false;
+
+	for (size_t offset = 0; offset < size; offset += *cipher_blockSize)
+	{
+		char *			previous = (offset ? data + offset - *cipher_blockSize : tag);
+
+		for (size_t i = 0; i < *cipher_blockSize; i++)
+			plain[offset + i] ^= previous[i];
+	}
+
+	return true;
+}
+
+// look up the clear-text for a cipher-text, the value buffer has to be at least as large as the cipher-text
+
+EXPORTED	bool	valueCacheLookup(valueCache_t * cache, struct iovec * cipherText, int count, size_t cipherTextSize, char * value, size_t * valueSize, bool * isString)
+{
+	char				tag[VALUE_CACHE_TAG_SIZE];
+	char				plain[VALUE_CACHE_DATA_SIZE];
+	valueCacheSlot_t *	slot;
+	bool				found = false;
+
+	if (!valueCacheTag(tag, cache->keyId, cipherText, count))
+		return false;
+
+	slot = valueCacheFind(cache, tag, &found);
+
+	/* only the blocks containing the value are decrypted */
+
+	if (found && slot->size <= VALUE_CACHE_DATA_SIZE && slot->size <= cipherTextSize &&
+		valueCacheDecrypt(cache, slot->tag, slot->data, plain, ((slot->size + *cipher_blockSize - 1) / *cipher_blockSize) * *cipher_blockSize))
+	{
+		memcpy(value, plain, slot->size);
+		*valueSize = slot->size;
+		*isString = ((slot->flags & VALUE_CACHE_STRING) != 0);
+		slot->used = ++cache->header->clock;
+		cache->header->hits++;
+		cache->hits++;
+		clearMemory(plain, sizeof(plain), false);
+		return true;
+	}
+
+	resetError();
+	cache->header->misses++;
+	cache->misses++;
+	clearMemory(plain, sizeof(plain), false);
+
+	return false;
+}
+
+// store the clear-text for a cipher-text, values larger than a slot aren't cached
+
+EXPORTED	bool	valueCacheStore(valueCache_t * cache, struct iovec * cipherText, int count, char * value, size_t valueSize, bool isString)
+{
+	char				tag[VALUE_CACHE_TAG_SIZE];
+	char				plain[VALUE_CACHE_DATA_SIZE];
+	valueCacheSlot_t *	slot;
+	bool				found = false;
+
+	if (valueSize > VALUE_CACHE_DATA_SIZE || !valueCacheTag(tag, cache->keyId, cipherText, count))
+		return false;
+
+	slot = valueCacheFind(cache, tag, &found);
+
+	memset(plain, 0, sizeof(plain));
+	memcpy(plain, value, valueSize);
+
+	/* the tag is unique for each entry, it's used as IV */
+
+	if (!valueCacheEncrypt(cache, tag, plain, slot->data, ((valueSize + *cipher_blockSize - 1) / *cipher_blockSize) * *cipher_blockSize))
+	{
+		clearMemory(plain, sizeof(plain), false);
+		slot->used = 0;
+		resetError();
+		return false;
+	}
+
+	memcpy(slot->tag, tag, VALUE_CACHE_TAG_SIZE);
+	slot->size = valueSize;
+	slot->flags = (isString ? VALUE_CACHE_STRING : 0);
+	slot->used = ++cache->header->clock;
+	cache->stored++;
+	clearMemory(plain, sizeof(plain), false);
+
+	return true;
+}
@@ -0,0 +1,82 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * vim: set tabstop=4 syntax=c :
+ *
+ * Copyright (C) 2014-2020, Peter Haemmerlein (peterpawn@yourfritz.de)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program, please look for the file LICENSE.
+ */
+
+#ifndef VALUECACHE_H
+
+#define VALUECACHE_H
+
+#include "common.h"
+
+// on-disk cache of decrypted values - a set-associative hash table in a single file, which is mapped
+// into memory; each set is searched linearly and the least recently used entry of a set is replaced
+
+#define	VALUE_CACHE_FILE_NAME		"decoder_value_cache"
+#define	VALUE_CACHE_MAGIC			"DECVCHE1"
+#define	VALUE_CACHE_SETS			4096
+#define	VALUE_CACHE_WAYS			16
+#define	VALUE_CACHE_TAG_SIZE		16
+#define	VALUE_CACHE_DATA_SIZE		96		/* multiple of the cipher block size */
+
+#define	VALUE_CACHE_STRING			1
+
+typedef struct {
+	char				magic[8];
+	uint32_t			sets;
+	uint32_t			ways;
+	uint32_t			slotSize;
+	uint32_t			reserved;
+	uint64_t			clock;			/* incremented on each access, it's the LRU time base */
+	uint64_t			hits;
+	uint64_t			misses;
+	char				filler[16];
+} valueCacheHeader_t;
+
+typedef struct {
+	char				tag[VALUE_CACHE_TAG_SIZE];	/* digest of key ID and cipher-text */
+	uint64_t			used;			/* clock value of last access, zero for an empty slot */
+	uint32_t			size;
+	uint32_t			flags;
+	char				data[VALUE_CACHE_DATA_SIZE];	/* encrypted clear-text */
+} valueCacheSlot_t;
+
+typedef struct valueCache {
+	int					fd;
+	char *				mapped;
+	size_t				mappedSize;
+	valueCacheHeader_t *	header;
+	valueCacheSlot_t *	slots;
+	CipherContext *		decryptCtx;		/* ECB contexts, the key schedule is set up only once */
+	CipherContext *		encryptCtx;
+	char				keyId[VALUE_CACHE_TAG_SIZE];
+	char *				key;			/* key for data at rest, derived from the decryption key */
+	size_t				hits;			/* counters for this run */
+	size_t				misses;
+	size_t				stored;
+} valueCache_t;
+
+// function prototypes
+
+valueCache_t *	valueCacheOpen(const char * path, char * key);
+valueCache_t *	valueCacheClose(valueCache_t * cache);
+bool			valueCacheLookup(valueCache_t * cache, struct iovec * cipherText, int count, size_t cipherTextSize, char * value, size_t * valueSize, bool * isString);
+bool			valueCacheStore(valueCache_t * cache, struct iovec * cipherText, int count, char * value, size_t valueSize, bool isString);
+
+#endif